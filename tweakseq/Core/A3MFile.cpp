@@ -0,0 +1,292 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <QtDebug>
+#include "DebuggingInfo.h"
+
+#include <cctype>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTextStream>
+
+#include "A3MFile.h"
+#include "BufferedWriter.h"
+#include "CompressedDevice.h"
+#include "Sequence.h"
+
+//
+//	Public members
+//		
+
+A3MFile::A3MFile(QString n):SequenceFile(n)
+{
+	QStringList ext;
+	ext << "*.a3m" << "*.a2m";
+	setExtensions(ext,SequenceFile::Proteins);
+	setExtensions(ext,SequenceFile::DNA);
+}
+
+A3MFile::~A3MFile()
+{
+}
+
+bool A3MFile::isValidFormat(QString & fname)
+{
+	QFileInfo fi(fname);
+	QString ext = "*."+fi.suffix();
+	return (extensions(SequenceFile::Proteins).contains(ext,Qt::CaseInsensitive) ||
+					extensions(SequenceFile::DNA).contains(ext,Qt::CaseInsensitive));
+}
+
+bool A3MFile::read(QStringList &seqnames, QStringList &seqs,QStringList &comments,Structure *)
+{
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << name();
+	
+	setError("");
+	
+	QFile f(name());
+	if (!f.open(QIODevice::ReadOnly | QIODevice::Text)){
+		qDebug() << trace.header(__PRETTY_FUNCTION__) << "couldn't open file";
+		setError("Couldn't open file");
+		return false;
+	}
+	QTextStream ts (&f);
+	
+	// The file is read in a single pass. As each record is completed, the number of 
+	// insertions preceding each match column is counted and the maximum for each column kept, 
+	// so that when the file has been read, the width of the expanded alignment is known
+	// and each sequence can be expanded into a buffer of the right size
+	QStringList raw;
+	QVector<int> maxIns;
+	QString s,l,seq;
+	bool inRecord=false;
+	while (!ts.atEnd()){
+		s = ts.readLine().trimmed();
+		if (s.isEmpty() || s.at(0) == QChar('#')) continue; // skip empty lines and the A3M header
+		if (s.at(0) == QChar('>')){
+			if (inRecord){
+				if (!countColumns(seq,maxIns)){
+					setError("Inconsistent number of match states for " + seqnames.last());
+					return false;
+				}
+				raw.append(seq);
+			}
+			comments.append(s);
+			parseComment(s,l);
+			seqnames.append(l);
+			seq="";
+			inRecord=true;
+		}
+		else if (inRecord){
+			seq.append(s);
+		}
+	}
+	
+	if (inRecord){
+		if (!countColumns(seq,maxIns)){
+			setError("Inconsistent number of match states for " + seqnames.last());
+			return false;
+		}
+		raw.append(seq);
+	}
+	
+	int width=0;
+	for (int i=0;i<maxIns.size();i++)
+		width += maxIns.at(i);
+	width += maxIns.size()-1; // the number of match columns
+	
+	for (int i=0;i<raw.size();i++){
+		seqs.append(expand(raw.at(i),maxIns,width));
+		raw[i]=QString(); // release it as we go
+	}
+	
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << "read " << seqs.size() << " sequences, " << width << " columns";
+	setDataType(SequenceFile::Unknown);
+	return true;
+}
+
+bool A3MFile::write(QStringList &l,QStringList &s,QStringList &c)
+{
+	setError("");
+	
+	// Output is compressed if the extension asks for it
+	CompressedDevice::Format compression = CompressedDevice::formatForFile(name());
+	QString errmsg;
+	if (!CompressedDevice::available(compression,errmsg)){
+		setError(errmsg);
+		return false;
+	}
+	QFile f(name());
+	if (!f.open(CompressedDevice::fileOpenMode(compression))){
+		qDebug() << trace.header(__PRETTY_FUNCTION__) << "couldn't open file";
+		setError("Couldn't open file");
+		return false;
+	}
+	
+	CompressedDevice cd(&f,compression);
+	if (!cd.open(QIODevice::WriteOnly)){
+		f.close();
+		setError(cd.errorString());
+		return false;
+	}
+	BufferedWriter bw(&cd);
+	for (int i=0;i<l.size();i++)
+		writeRecord(bw,l.at(i),s.at(i),(i < c.size() ? c.at(i) : QString()),s.at(0));
+	
+	bool ok = bw.flush() && cd.finish();
+	f.close();
+	if (!ok){
+		setError("Error while writing file");
+		return false;
+	}
+	return true;
+}
+
+bool A3MFile::isA2M()
+{
+	QString fname = name().toLower();
+	if (CompressedDevice::formatForFile(fname) != CompressedDevice::None)
+		fname = fname.left(fname.lastIndexOf('.'));
+	return fname.endsWith(".a2m");
+}
+
+// Writes a single record, using master to determine which columns are insert states.
+// Residues in columns where the master has a gap are written in lower case. Gaps in these columns
+// are dropped (A3M) or written as '.' (A2M)
+void A3MFile::writeRecord(BufferedWriter &bw,const QString &label,const QString &seq,const QString &comment,const QString &master)
+{
+	bool a2m = isA2M();
+	if (comment.startsWith('>'))
+		bw.write(comment);
+	else{
+		bw.write('>');
+		bw.write(label);
+	}
+	bw.write('\n');
+	
+	QByteArray out;
+	out.reserve(seq.size());
+	for (int col=0;col<seq.size();col++){
+		char ch = (char) (seq.at(col).unicode() & REMOVE_FLAGS);
+		bool gap = (ch == '-' || ch == '.');
+		bool matchCol = false;
+		if (col < master.size()){
+			char mch = (char) (master.at(col).unicode() & REMOVE_FLAGS);
+			matchCol = (mch != '-' && mch != '.');
+		}
+		if (matchCol)
+			out.append(gap ? '-' : toupper(ch));
+		else if (!gap)
+			out.append(tolower(ch));
+		else if (a2m)
+			out.append('.');
+	}
+	out.append('\n');
+	bw.write(out.constData(),out.size());
+}
+
+//
+// Private members
+//
+
+void A3MFile::parseComment(QString &s,QString &l)
+{
+	// Use the comment up to the first space as the label
+	int index =s.indexOf(QChar(' '),1);
+	if (index == -1)
+		l = s.mid(1,-1); // use the lot
+	else
+		l = s.mid(1,index-1);
+}
+
+// Counts the insert states preceding each match column in s and updates the running maximum in maxIns.
+// maxIns has one entry for each match column plus one for insertions following the last match column.
+// The first sequence read defines the number of match columns
+// Returns false if the number of match columns differs from the first sequence
+bool A3MFile::countColumns(const QString &s,QVector<int> &maxIns)
+{
+	bool first = maxIns.isEmpty();
+	int col=0,nins=0;
+	const QChar *p = s.constData();
+	const QChar *end = p + s.size();
+	for (;p<end;++p){
+		ushort u = p->unicode();
+		if (u >= 'a' && u <= 'z'){ // insert state
+			nins++;
+			continue;
+		}
+		if (u == '.') // gap in an insert column (A2M)
+			continue;
+		// Anything else is a match state
+		if (first)
+			maxIns.append(nins);
+		else{
+			if (col >= maxIns.size()-1) return false;
+			if (nins > maxIns.at(col)) maxIns[col]=nins;
+		}
+		col++;
+		nins=0;
+	}
+	
+	if (first)
+		maxIns.append(nins);
+	else{
+		if (col != maxIns.size()-1) return false;
+		if (nins > maxIns.at(col)) maxIns[col]=nins;
+	}
+	return true;
+}
+
+// Expands an A3M sequence to the full alignment width
+// Inserted residues are converted to upper case, and left-justified in the insert columns
+QString A3MFile::expand(const QString &s,const QVector<int> &maxIns,int width)
+{
+	QString r;
+	r.reserve(width);
+	int col=0,nins=0;
+	const QChar *p = s.constData();
+	const QChar *end = p + s.size();
+	for (;p<end;++p){
+		ushort u = p->unicode();
+		if (u >= 'a' && u <= 'z'){
+			r.append(QChar(u - 'a' + 'A'));
+			nins++;
+			continue;
+		}
+		if (u == '.')
+			continue;
+		for (int i=nins;i<maxIns.at(col);i++)
+			r.append(QChar('-'));
+		r.append(*p);
+		col++;
+		nins=0;
+	}
+	for (int i=nins;i<maxIns.at(col);i++)
+		r.append(QChar('-'));
+	return r;
+}
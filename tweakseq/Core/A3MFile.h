@@ -0,0 +1,68 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef __A3M_FILE_
+#define __A3M_FILE_
+
+#include <QVector>
+
+#include "SequenceFile.h"
+
+class BufferedWriter;
+
+// HH-suite style A3M (and A2M) alignments
+// Match states are upper case or '-', insert states are lower case and,
+// in A3M, unaligned. On reading, the insert states are expanded so that 
+// the result is an ordinary alignment. On writing, the first sequence
+// is used as the master sequence to determine which columns are inserts.
+// A file with the extension .a2m is written as A2M, with gaps in insert columns written as '.'
+
+class A3MFile:public SequenceFile{
+	public:
+		
+		A3MFile(QString n= QString());
+		~A3MFile();
+		
+		virtual bool isValidFormat(QString &);
+		
+		virtual bool read(QStringList &,QStringList &,QStringList &,Structure *s=NULL);
+		virtual bool write(QStringList &,QStringList &,QStringList &);
+		
+		bool isA2M(); // from the file name
+		
+		void writeRecord(BufferedWriter &,const QString &,const QString &,const QString &,const QString &);
+	
+	private:
+		
+		void parseComment(QString &,QString &);
+		bool countColumns(const QString &,QVector<int> &);
+		QString expand(const QString &,const QVector<int> &,int);
+		
+		QString n_;
+		
+};
+
+#endif
@@ -0,0 +1,161 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <QtDebug>
+#include "DebuggingInfo.h"
+
+#include <sys/types.h>
+#include <utime.h>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include "AlignmentCache.h"
+#include "AlignmentTool.h"
+#include "BufferedWriter.h"
+#include "FASTAFile.h"
+
+//
+//	Public members
+//	
+
+AlignmentCache::AlignmentCache(const QString &path,qint64 maxSize)
+{
+	path_=path;
+	maxSize_=maxSize;
+	QDir d;
+	if (!d.mkpath(path_))
+		qWarning() << warning.header(__PRETTY_FUNCTION__) << "couldn't create " << path_;
+}
+
+AlignmentCache::~AlignmentCache()
+{
+}
+
+// The key is a hash of everything which determines the output:
+// the tool, its version, the command line and the input sequences (labels included, since they come back in the output)
+QString AlignmentCache::key(AlignmentTool *tool,const QString &exec,const QStringList &args,
+	const QStringList &labels,const QStringList &seqs)
+{
+	QCryptographicHash h(QCryptographicHash::Sha1);
+	h.addData(tool->name().toUtf8());
+	h.addData("\n",1);
+	h.addData(tool->version().toUtf8());
+	h.addData("\n",1);
+	h.addData(exec.toUtf8());
+	for (int a=0;a<args.size();a++){
+		h.addData("\t",1);
+		h.addData(args.at(a).toUtf8());
+	}
+	h.addData("\n",1);
+	for (int s=0;s<labels.size();s++){
+		h.addData(">",1);
+		h.addData(labels.at(s).toUtf8());
+		h.addData("\n",1);
+		h.addData(seqs.at(s).toLatin1());
+		h.addData("\n",1);
+	}
+	return QString(h.result().toHex());
+}
+
+bool AlignmentCache::lookup(const QString &key,QStringList &labels,QStringList &seqs)
+{
+	QString fname = entryPath(key);
+	if (!QFileInfo::exists(fname)) return false;
+	
+	FASTAFile fin(fname);
+	QStringList comments;
+	labels.clear();
+	seqs.clear();
+	if (!fin.read(labels,seqs,comments) || labels.isEmpty()){
+		QFile::remove(fname); // unreadable, so don't try again
+		return false;
+	}
+	
+	// Mark it as recently used
+	if (0 != utime(QFile::encodeName(fname).constData(),NULL))
+		qWarning() << warning.header(__PRETTY_FUNCTION__) << "couldn't touch " << fname;
+	
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << "hit " << key;
+	return true;
+}
+
+bool AlignmentCache::store(const QString &key,const QStringList &labels,const QStringList &seqs)
+{
+	QSaveFile f(entryPath(key));
+	if (!f.open(QIODevice::WriteOnly)){
+		qWarning() << warning.header(__PRETTY_FUNCTION__) << "couldn't open " << f.fileName();
+		return false;
+	}
+	
+	FASTAFile ff;
+	BufferedWriter bw(&f);
+	for (int s=0;s<labels.size();s++)
+		ff.writeRecord(bw,labels.at(s),seqs.at(s),"");
+	if (!bw.flush() || !f.commit()){
+		qWarning() << warning.header(__PRETTY_FUNCTION__) << "couldn't write " << f.fileName();
+		return false;
+	}
+	
+	evict();
+	return true;
+}
+
+void AlignmentCache::clear()
+{
+	QDir d(path_);
+	QStringList entries = d.entryList(QStringList() << "*.fa",QDir::Files);
+	for (int e=0;e<entries.size();e++)
+		d.remove(entries.at(e));
+}
+
+//
+//	Private members
+//	
+
+QString AlignmentCache::entryPath(const QString &key)
+{
+	return path_ + "/" + key + ".fa";
+}
+
+// Removes the least recently used entries until the cache is under its size cap
+void AlignmentCache::evict()
+{
+	QDir d(path_);
+	QFileInfoList entries = d.entryInfoList(QStringList() << "*.fa",QDir::Files,QDir::Time | QDir::Reversed); // oldest first
+	qint64 total=0;
+	for (int e=0;e<entries.size();e++)
+		total += entries.at(e).size();
+	for (int e=0;e<entries.size() && total > maxSize_;e++){
+		if (d.remove(entries.at(e).fileName())){
+			total -= entries.at(e).size();
+			qDebug() << trace.header(__PRETTY_FUNCTION__) << "evicted " << entries.at(e).fileName();
+		}
+	}
+}
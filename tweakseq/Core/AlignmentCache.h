@@ -0,0 +1,66 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef __ALIGNMENT_CACHE_H_
+#define __ALIGNMENT_CACHE_H_
+
+#include <QString>
+#include <QStringList>
+
+class AlignmentTool;
+
+// An on-disk cache of aligner output, keyed on a hash of the input and the command which was run.
+// Each entry is a FASTA file. When the cache grows past its size cap,
+// the least recently used entries are removed (use is tracked by the file's modification time).
+
+class AlignmentCache
+{
+	public:
+		
+		AlignmentCache(const QString &,qint64 maxSize=268435456);
+		~AlignmentCache();
+		
+		void setMaxSize(qint64 s){maxSize_=s;}
+		qint64 maxSize(){return maxSize_;}
+		
+		static QString key(AlignmentTool *,const QString &,const QStringList &,
+			const QStringList &,const QStringList &);
+		
+		bool lookup(const QString &,QStringList &,QStringList &);
+		bool store(const QString &,const QStringList &,const QStringList &);
+		
+		void clear();
+		
+	private:
+		
+		QString entryPath(const QString &);
+		void evict();
+		
+		QString path_;
+		qint64 maxSize_;
+};
+
+#endif
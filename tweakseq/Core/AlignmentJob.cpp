@@ -0,0 +1,447 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <QtDebug>
+#include "DebuggingInfo.h"
+
+#include <QTemporaryFile>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+#include <QtConcurrentRun>
+
+#include "AlignmentJob.h"
+#include "AlignmentTool.h"
+#include "ProgressParser.h"
+#include "ToolProcess.h"
+#include "BufferedWriter.h"
+#include "FASTAFile.h"
+
+#define INPUT_CHUNK 1048576 // bytes written to the aligner's stdin at a time
+#define PROGRESS_POLL 500 // ms, for in-process tools
+
+//
+//	Public members
+//	
+
+AlignmentJob::AlignmentJob(const QString &name,bool isFullAlignment,QObject *parent):QObject(parent)
+{
+	name_=name;
+	isFullAlignment_=isFullAlignment;
+	state_=Queued;
+	nseqs_=0;
+	nres_=0;
+	maxLength_=0;
+	inputPos_=-1;
+	proc_=NULL;
+	progress_=NULL;
+	memoryLimit_=0;
+	niceLevel_=0;
+	threadsRequested_=0;
+	cores_=0;
+	threaded_=false;
+	elapsed_=0;
+	alignmentFile_=NULL;
+	tool_=NULL;
+	ownsTool_=false;
+	watcher_=NULL;
+	cancelFlag_=0;
+	toolProgress_=-1;
+	reportedProgress_=-1;
+	progressTimer_=NULL;
+}
+
+AlignmentJob::~AlignmentJob()
+{
+	if (proc_ != NULL){
+		proc_->disconnect(this);
+		if (proc_->state() != QProcess::NotRunning){
+			proc_->kill();
+			proc_->waitForFinished(1000);
+		}
+		delete proc_;
+	}
+	if (watcher_ != NULL){
+		cancelFlag_=1;
+		watcher_->disconnect(this);
+		watcher_->waitForFinished();
+	}
+	if (ownsTool_)
+		delete tool_;
+	delete alignmentFile_;
+	delete progress_;
+}
+
+void AlignmentJob::addSequence(const QString &label,const QString &residues)
+{
+	labels_.append(label);
+	seqs_.append(residues);
+	nseqs_++;
+	nres_ += residues.size();
+	maxLength_ = qMax(maxLength_,residues.size());
+}
+
+void AlignmentJob::setCommand(const QString &exec,const QStringList &args)
+{
+	exec_=exec;
+	args_=args;
+}
+
+// A tool without a thread count option is charged one core
+int AlignmentJob::coresWanted()
+{
+	if (!threaded_) return 1;
+	return threadsRequested_;
+}
+
+void AlignmentJob::setProgressParser(ProgressParser *p)
+{
+	delete progress_;
+	progress_=p;
+}
+
+void AlignmentJob::setInProcess(AlignmentTool *t,bool takeOwnership)
+{
+	if (ownsTool_)
+		delete tool_;
+	tool_=t;
+	ownsTool_=takeOwnership;
+}
+
+// The records of the existing alignment are numbered after the added sequences
+void AlignmentJob::setAddition(QTemporaryFile *alignmentFile,const QStringList &addedLabels,const QStringList &alignmentLabels)
+{
+	delete alignmentFile_;
+	alignmentFile_=alignmentFile;
+	addedLabels_=addedLabels;
+	alignmentLabels_=alignmentLabels;
+}
+
+QString AlignmentJob::stateText()
+{
+	switch (state_){
+		case Queued:return "queued";
+		case Running:return "running";
+		case Finished:return "finished";
+		case Failed:return "failed";
+		case Cancelled:return "cancelled";
+	}
+	return "";
+}
+
+qint64 AlignmentJob::elapsed()
+{
+	if (state_ == Running)
+		return timer_.elapsed();
+	return elapsed_;
+}
+
+double AlignmentJob::progress()
+{
+	if (progress_ != NULL){
+		if (state_ == Finished) return 1.0;
+		return progress_->fraction();
+	}
+	if (tool_ != NULL && toolProgress_.load() >= 0){
+		if (state_ == Finished) return 1.0;
+		return toolProgress_.load()/1000.0;
+	}
+	return -1.0;
+}
+
+qint64 AlignmentJob::eta()
+{
+	if (state_ != Running) return -1;
+	if (progress_ != NULL)
+		return progress_->eta(timer_.elapsed());
+	double f = progress();
+	if (f < 0.02) return -1; // too early to extrapolate
+	return (qint64) (timer_.elapsed()*(1.0-f)/f);
+}
+
+// eg "45% progressive 1, 2:05 left"
+QString AlignmentJob::progressText()
+{
+	double f = progress();
+	if (f < 0.0 || state_ != Running) return "";
+	QString txt = QString::number(qRound(f*100.0)) + "%";
+	if (progress_ != NULL)
+		txt += " " + progress_->stage();
+	qint64 t = eta();
+	if (t >= 0){
+		t = (t + 999)/1000;
+		QString mmss = QString("%1:%2").arg((t/60) % 60).arg(t % 60,2,10,QChar('0'));
+		if (t >= 3600)
+			mmss = QString("%1:%2").arg(t/3600).arg(mmss.rightJustified(5,'0'));
+		txt += ", " + mmss + " left";
+	}
+	return txt;
+}
+
+void AlignmentJob::start()
+{
+	if (state_ != Queued) return;
+	
+	if (cores_ < 1){ // not run from a queue
+		cores_ = coresWanted();
+		if (cores_ < 1)
+			cores_ = qMax(1,QThread::idealThreadCount());
+	}
+	
+	if (tool_ != NULL){
+		if (threaded_ && tool_->threaded())
+			tool_->setThreads(cores_);
+		qDebug() << trace.header(__PRETTY_FUNCTION__) << name_ << tool_->name();
+		timer_.start();
+		getrusage(RUSAGE_SELF,&startUsage_);
+		setState(Running);
+		watcher_ = new QFutureWatcher<bool>(this);
+		connect(watcher_,SIGNAL(finished()),this,SLOT(inProcessFinished()));
+		watcher_->setFuture(QtConcurrent::run(this,&AlignmentJob::runInProcess));
+		progressTimer_ = new QTimer(this);
+		connect(progressTimer_,SIGNAL(timeout()),this,SLOT(pollProgress()));
+		progressTimer_->start(PROGRESS_POLL);
+		return;
+	}
+	
+	args_.replaceInStrings("%threads",QString::number(cores_));
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << name_ << exec_ << args_;
+	
+	ToolProcess *tp = new ToolProcess();
+	tp->setMemoryLimit(memoryLimit_);
+	tp->setNiceLevel(niceLevel_);
+	proc_ = tp;
+	connect(proc_,SIGNAL(started()),this,SLOT(writeInput()));
+	connect(proc_,SIGNAL(bytesWritten(qint64)),this,SLOT(writeInput()));
+	connect(proc_,SIGNAL(readyReadStandardOutput()),this,SLOT(readStdOut()));
+	connect(proc_,SIGNAL(readyReadStandardError()),this,SLOT(readStdErr()));
+	connect(proc_,SIGNAL(error(QProcess::ProcessError)),this,SLOT(processError(QProcess::ProcessError)));
+	connect(proc_,SIGNAL(finished(int,QProcess::ExitStatus)),this,SLOT(processFinished(int,QProcess::ExitStatus)));
+	
+	inputPos_=0;
+	output_.clear();
+	timer_.start();
+	setState(Running);
+	proc_->start(exec_,args_);
+}
+
+void AlignmentJob::cancel()
+{
+	if (state_ == Queued){
+		setState(Cancelled);
+		emit finished(this);
+	}
+	else if (state_ == Running){
+		elapsed_ = timer_.elapsed();
+		setState(Cancelled); // processFinished() or inProcessFinished() will see this
+		if (tool_ != NULL)
+			cancelFlag_=1;
+		else
+			proc_->kill();
+	}
+}
+
+//
+//	Private slots
+//	
+
+// Input is only written when the pipe has drained, so the whole of it is never buffered
+void AlignmentJob::writeInput()
+{
+	if (NULL == proc_ || inputPos_ < 0) return;
+	
+	if (proc_->bytesToWrite() > INPUT_CHUNK) return;
+	
+	FASTAFile ff;
+	BufferedWriter bw(proc_,INPUT_CHUNK);
+	while (inputPos_ < labels_.size() && bw.bytesWritten() < INPUT_CHUNK){
+		ff.writeRecord(bw,QString::number(inputPos_),seqs_.at(inputPos_),"");
+		inputPos_++;
+	}
+	bw.flush();
+	
+	if (inputPos_ == labels_.size()){
+		proc_->closeWriteChannel();
+		inputPos_ = -1; // done
+		seqs_.clear(); // the labels are kept, to restore them in the output
+	}
+}
+
+void AlignmentJob::readStdOut()
+{
+	// The alignment is parsed as it arrives. Anything before it is a log message
+	output_.addData(proc_->readAllStandardOutput());
+	QStringList msgs = output_.takeMessages();
+	if (progress_ != NULL){ // progress reports are filtered out of the log
+		QStringList logged;
+		for (int m=0;m<msgs.size();m++)
+			progress_->addData(msgs.at(m).toLocal8Bit() + '\n',logged);
+		msgs=logged;
+		checkProgress();
+	}
+	for (int m=0;m<msgs.size();m++)
+		emit message(msgs.at(m),false);
+}
+
+void AlignmentJob::readStdErr()
+{
+	if (progress_ != NULL){
+		QStringList logged;
+		progress_->addData(proc_->readAllStandardError(),logged);
+		if (!logged.isEmpty())
+			emit message(logged.join("\n"),true);
+		checkProgress();
+	}
+	else
+		emit message(QString(proc_->readAllStandardError()),true);
+}
+
+void AlignmentJob::processError(QProcess::ProcessError err)
+{
+	if (err == QProcess::FailedToStart){ // finished() is not emitted
+		emit message("Failed to start " + exec_,true);
+		elapsed_ = timer_.elapsed();
+		setState(Failed);
+		emit finished(this);
+	}
+}
+
+void AlignmentJob::processFinished(int exitCode,QProcess::ExitStatus exitStatus)
+{
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << name_ << " exitCode=" << exitCode << " exitStatus=" << exitStatus;
+	
+	if (state_ != Cancelled){
+		elapsed_ = timer_.elapsed();
+		usage_ = static_cast<ToolProcess *>(proc_)->usage();
+		output_.addData(proc_->readAllStandardOutput());
+		output_.finish();
+		if (progress_ != NULL){
+			QStringList logged;
+			progress_->flush(logged);
+			if (!logged.isEmpty())
+				emit message(logged.join("\n"),true);
+		}
+		if (exitStatus == QProcess::NormalExit && exitCode == 0 && output_.size() > 0){
+			if (progress_ != NULL)
+				progress_->finish(elapsed_); // learn from the stage timings
+			setState(restoreLabels() ? Finished : Failed);
+		}
+		else{
+			if (memoryLimit_ > 0)
+				emit message(name_ + ": the tool may have run out of memory (limit " + QString::number(memoryLimit_) + " MB)",true);
+			setState(Failed);
+		}
+	}
+	emit finished(this);
+}
+
+void AlignmentJob::inProcessFinished()
+{
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << name_;
+	
+	progressTimer_->stop();
+	if (state_ != Cancelled){
+		elapsed_ = timer_.elapsed();
+		// The editor's own use is counted too, so this is only an estimate.
+		// Its peak RSS is the editor's over its lifetime, which says nothing about this run
+		struct rusage endUsage;
+		getrusage(RUSAGE_SELF,&endUsage);
+		usage_.wall = elapsed_;
+		usage_.user = (endUsage.ru_utime.tv_sec - startUsage_.ru_utime.tv_sec)*1000LL + (endUsage.ru_utime.tv_usec - startUsage_.ru_utime.tv_usec)/1000;
+		usage_.sys = (endUsage.ru_stime.tv_sec - startUsage_.ru_stime.tv_sec)*1000LL + (endUsage.ru_stime.tv_usec - startUsage_.ru_stime.tv_usec)/1000;
+		usage_.peakRSS = 0;
+		usage_.exact=false;
+		if (watcher_->result()){
+			// The output goes straight to the parser's lists, there's no FASTA to parse
+			output_.clear();
+			output_.labels() = labels_;
+			output_.sequences() = result_;
+			setState(Finished);
+		}
+		else{
+			emit message(errmsg_,true);
+			setState(Failed);
+		}
+	}
+	result_.clear();
+	emit finished(this);
+}
+
+// Replaces the IDs in the output with the labels, by direct lookup.
+// Every input sequence must come back, otherwise applying the alignment would drop the missing ones
+bool AlignmentJob::restoreLabels()
+{
+	QStringList &out = output_.labels();
+	int nIDs = labels_.size() + alignmentLabels_.size();
+	QVector<bool> seen(nIDs,false);
+	for (int r=0;r<out.size();r++){
+		bool ok;
+		int id = out.at(r).toInt(&ok);
+		if (!ok || id < 0 || id >= nIDs || seen.at(id)){
+			emit message(name_ + ": the tool returned an unexpected sequence " + out.at(r),true);
+			return false;
+		}
+		seen[id]=true;
+		out[r] = (id < labels_.size() ? labels_.at(id) : alignmentLabels_.at(id - labels_.size()));
+	}
+	if (out.size() != nIDs){ // no duplicates, so some are missing
+		emit message(name_ + ": the tool returned " + QString::number(out.size()) + " of " + QString::number(nIDs) + " sequences",true);
+		return false;
+	}
+	return true;
+}
+
+// In-process tools report their progress through an atomic, which is polled here, in the GUI thread
+void AlignmentJob::pollProgress()
+{
+	int p = toolProgress_.load();
+	if (p >= 0 && qAbs(p - reportedProgress_) >= 5){
+		reportedProgress_=p;
+		emit progressChanged(this);
+	}
+}
+
+//
+//	Private members
+//	
+
+void AlignmentJob::setState(State s)
+{
+	state_=s;
+	emit stateChanged(this);
+}
+
+void AlignmentJob::checkProgress()
+{
+	if (progress_->takeChanged())
+		emit progressChanged(this);
+}
+
+// Runs on the thread pool
+bool AlignmentJob::runInProcess()
+{
+	return tool_->align(seqs_,result_,errmsg_,&cancelFlag_,&toolProgress_);
+}
@@ -0,0 +1,177 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef __ALIGNMENT_JOB_H_
+#define __ALIGNMENT_JOB_H_
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QProcess>
+#include <QString>
+#include <QStringList>
+
+#include "ColumnWindow.h"
+#include "FASTAStreamParser.h"
+#include "ToolProcess.h"
+
+class QTemporaryFile;
+class QTimer;
+
+class AlignmentTool;
+class ProgressParser;
+
+// One run of an alignment tool on a set of sequences.
+// The input is a snapshot, streamed to the tool's stdin, and the alignment is parsed from stdout.
+// The tool sees each record by a numeric ID, its row in the input, so labels that the tool would mangle
+// or truncate don't matter; the labels are put back as the output is read.
+// Sequences are identified by label, since the project may change while the job is queued or running.
+// An in-process tool aligns the snapshot on the thread pool instead.
+
+class AlignmentJob:public QObject
+{
+	Q_OBJECT
+	
+	public:
+		
+		enum State {Queued,Running,Finished,Failed,Cancelled};
+		
+		AlignmentJob(const QString &,bool,QObject *parent=NULL);
+		~AlignmentJob();
+		
+		void addSequence(const QString &,const QString &); // label, residues
+		void setCommand(const QString &,const QStringList &);
+		void setLimits(int mb,int nice){memoryLimit_=mb;niceLevel_=nice;} // for the tool's process
+		void setThreads(int requested,bool threaded){threadsRequested_=requested;threaded_=threaded;}
+		int coresWanted(); // 0 for a threaded tool which takes what is available
+		void setCores(int n){cores_=n;} // given by the queue, before the job starts
+		int cores(){return cores_;}
+		void setProgressParser(ProgressParser *); // takes ownership
+		void setInProcess(AlignmentTool *,bool takeOwnership=false); // runs the tool on the thread pool, instead of a process
+		
+		void setToolInfo(const QString &name,const QString &version){toolName_=name;toolVersion_=version;} // for the run history
+		QString toolName(){return toolName_;}
+		QString toolVersion(){return toolVersion_;}
+		
+		void setCacheKey(const QString &k){cacheKey_=k;}
+		QString cacheKey(){return cacheKey_;}
+		
+		void setAddition(QTemporaryFile *,const QStringList &,const QStringList &); // takes ownership of the file
+		bool isAddition(){return NULL != alignmentFile_;}
+		QStringList &addedLabels(){return addedLabels_;}
+		
+		void setWindow(const ColumnWindow &w){window_=w;} // the sequences are a block of columns, to be spliced back
+		ColumnWindow &window(){return window_;}
+		
+		QString name(){return name_;}
+		bool isFullAlignment(){return isFullAlignment_;}
+		int numSequences(){return nseqs_;}
+		qint64 numResidues(){return nres_;}
+		int maxLength(){return maxLength_;}
+		
+		State state(){return state_;}
+		QString stateText();
+		qint64 elapsed(); // ms
+		ResourceUsage usage(){return usage_;} // of the finished run
+		
+		double progress(); // fraction done, -1 if unknown
+		qint64 eta(); // ms, -1 if unknown
+		QString progressText();
+		
+		FASTAStreamParser &output(){return output_;}
+		
+		void start();
+		void cancel();
+		
+	signals:
+		
+		void stateChanged(AlignmentJob *);
+		void message(const QString &,bool);
+		void progressChanged(AlignmentJob *);
+		void finished(AlignmentJob *);
+		
+	private slots:
+		
+		void writeInput();
+		void readStdOut();
+		void readStdErr();
+		void processError(QProcess::ProcessError);
+		void processFinished(int,QProcess::ExitStatus);
+		void inProcessFinished();
+		void pollProgress();
+		
+	private:
+		
+		void setState(State);
+		bool runInProcess();
+		void checkProgress();
+		bool restoreLabels();
+		
+		QString name_;
+		bool isFullAlignment_;
+		State state_;
+		
+		QString exec_;
+		QStringList args_;
+		QString cacheKey_;
+		QString toolName_,toolVersion_;
+		int memoryLimit_,niceLevel_;
+		int threadsRequested_,cores_;
+		bool threaded_;
+		
+		QTemporaryFile *alignmentFile_; // the existing alignment, when adding sequences to it
+		QStringList addedLabels_;
+		QStringList alignmentLabels_; // of the existing alignment, numbered after the added sequences
+		ColumnWindow window_;
+		
+		QStringList labels_,seqs_;
+		int nseqs_;
+		qint64 nres_;
+		int maxLength_;
+		int inputPos_; // next sequence to write, -1 when done
+		
+		QProcess *proc_;
+		ProgressParser *progress_;
+		
+		AlignmentTool *tool_;
+		bool ownsTool_;
+		QFutureWatcher<bool> *watcher_;
+		QAtomicInt cancelFlag_;
+		QAtomicInt toolProgress_; // per mille, -1 if the tool doesn't report it
+		int reportedProgress_;
+		QTimer *progressTimer_;
+		QStringList result_;
+		QString errmsg_;
+		
+		FASTAStreamParser output_;
+		QElapsedTimer timer_;
+		qint64 elapsed_;
+		ResourceUsage usage_;
+		struct rusage startUsage_; // of the whole process, for in-process tools
+};
+
+#endif
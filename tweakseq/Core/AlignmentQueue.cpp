@@ -0,0 +1,185 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <QtDebug>
+#include "DebuggingInfo.h"
+
+#include <unistd.h>
+
+#include <QThread>
+
+#include "AlignmentJob.h"
+#include "AlignmentQueue.h"
+
+//
+//	Public members
+//	
+
+AlignmentQueue::AlignmentQueue(QObject *parent):QObject(parent)
+{
+	// Default budgets are all of the cores and half of the physical memory
+	scheduling_=false;
+	rescheduleNeeded_=false;
+	coreBudget_ = qMax(1,QThread::idealThreadCount());
+	memoryBudget_ = (qint64) 1 << 31;
+	long pages = sysconf(_SC_PHYS_PAGES);
+	long pageSize = sysconf(_SC_PAGE_SIZE);
+	if (pages > 0 && pageSize > 0)
+		memoryBudget_ = ((qint64) pages * pageSize)/2;
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << "core budget " << coreBudget_ << " memory budget " << memoryBudget_;
+}
+
+AlignmentQueue::~AlignmentQueue()
+{
+	while (!jobs_.isEmpty())
+		delete jobs_.takeFirst(); // kills any running process
+}
+
+// A rough estimate of the memory needed by a job.
+// Progressive aligners keep a distance matrix, and profiles of the sequences
+qint64 AlignmentQueue::memoryEstimate(AlignmentJob *job)
+{
+	qint64 n = job->numSequences();
+	return 32*1048576 + n*n*8 + job->numResidues()*64;
+}
+
+void AlignmentQueue::add(AlignmentJob *job)
+{
+	jobs_.append(job);
+	connect(job,SIGNAL(stateChanged(AlignmentJob *)),this,SIGNAL(jobChanged(AlignmentJob *)));
+	connect(job,SIGNAL(progressChanged(AlignmentJob *)),this,SIGNAL(jobProgress(AlignmentJob *)));
+	connect(job,SIGNAL(finished(AlignmentJob *)),this,SLOT(finished(AlignmentJob *)));
+	emit jobAdded(job);
+	schedule();
+}
+
+int AlignmentQueue::numActive()
+{
+	int n=0;
+	for (int j=0;j<jobs_.size();j++){
+		if (jobs_.at(j)->state() == AlignmentJob::Queued || jobs_.at(j)->state() == AlignmentJob::Running)
+			n++;
+	}
+	return n;
+}
+
+int AlignmentQueue::numRunning()
+{
+	int n=0;
+	for (int j=0;j<jobs_.size();j++){
+		if (jobs_.at(j)->state() == AlignmentJob::Running)
+			n++;
+	}
+	return n;
+}
+
+void AlignmentQueue::cancelAll()
+{
+	// Queued jobs first, so that nothing gets started as the running jobs finish
+	for (int j=0;j<jobs_.size();j++){
+		if (jobs_.at(j)->state() == AlignmentJob::Queued)
+			jobs_.at(j)->cancel();
+	}
+	for (int j=0;j<jobs_.size();j++){
+		if (jobs_.at(j)->state() == AlignmentJob::Running)
+			jobs_.at(j)->cancel();
+	}
+}
+
+// Removes finished, failed and cancelled jobs
+void AlignmentQueue::removeInactive()
+{
+	for (int j=jobs_.size()-1;j>=0;j--){
+		AlignmentJob *job = jobs_.at(j);
+		if (job->state() != AlignmentJob::Queued && job->state() != AlignmentJob::Running){
+			jobs_.removeAt(j);
+			job->deleteLater();
+		}
+	}
+}
+
+//
+//	Private slots
+//	
+
+void AlignmentQueue::finished(AlignmentJob *job)
+{
+	emit jobFinished(job);
+	schedule();
+}
+
+//
+//	Private members
+//	
+
+void AlignmentQueue::schedule()
+{
+	// A job which fails to start finishes straight away, which calls back into here
+	if (scheduling_){
+		rescheduleNeeded_=true;
+		return;
+	}
+	scheduling_=true;
+	do {
+		rescheduleNeeded_=false;
+		startJobs();
+	} while (rescheduleNeeded_);
+	scheduling_=false;
+}
+
+void AlignmentQueue::startJobs()
+{
+	int nRunning=0,nQueued=0;
+	int coresInUse=0;
+	qint64 memInUse=0;
+	for (int j=0;j<jobs_.size();j++){
+		if (jobs_.at(j)->state() == AlignmentJob::Running){
+			nRunning++;
+			coresInUse += jobs_.at(j)->cores();
+			memInUse += memoryEstimate(jobs_.at(j));
+		}
+		else if (jobs_.at(j)->state() == AlignmentJob::Queued)
+			nQueued++;
+	}
+	
+	for (int j=0;j<jobs_.size();j++){
+		AlignmentJob *job = jobs_.at(j);
+		if (job->state() != AlignmentJob::Queued) continue;
+		int freeCores = coreBudget_ - coresInUse;
+		int cores = job->coresWanted();
+		if (cores < 1) // the free cores are shared between the waiting jobs
+			cores = qMax(1,freeCores/nQueued);
+		qint64 mem = memoryEstimate(job);
+		if (nRunning > 0 && (cores > freeCores || memInUse + mem > memoryBudget_))
+			break; // jobs start in order, so wait
+		job->setCores(cores);
+		job->start();
+		nRunning++;
+		nQueued--;
+		coresInUse += cores;
+		memInUse += mem;
+	}
+}
@@ -0,0 +1,89 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef __ALIGNMENT_QUEUE_H_
+#define __ALIGNMENT_QUEUE_H_
+
+#include <QList>
+#include <QObject>
+
+class AlignmentJob;
+
+// Runs queued alignment jobs, as many at once as the core and memory budgets allow.
+// Each job is charged the cores its tool will use: the tool's thread setting, one for a tool
+// without a thread option, or a share of the free cores for a threaded tool left to decide.
+// Jobs start in the order they were queued. A job which is too big for either budget
+// on its own is run when nothing else is running.
+
+class AlignmentQueue:public QObject
+{
+	Q_OBJECT
+	
+	public:
+		
+		AlignmentQueue(QObject *parent=NULL);
+		~AlignmentQueue();
+		
+		void setCoreBudget(int n){if (n > 0) coreBudget_=n;}
+		int coreBudget(){return coreBudget_;}
+		
+		void setMemoryBudget(qint64 b){if (b > 0) memoryBudget_=b;}
+		qint64 memoryBudget(){return memoryBudget_;}
+		
+		static qint64 memoryEstimate(AlignmentJob *);
+		
+		void add(AlignmentJob *);
+		QList<AlignmentJob *> &jobs(){return jobs_;}
+		
+		int numActive(); // queued or running
+		int numRunning();
+		
+		void cancelAll();
+		void removeInactive();
+		
+	signals:
+		
+		void jobAdded(AlignmentJob *);
+		void jobChanged(AlignmentJob *);
+		void jobProgress(AlignmentJob *);
+		void jobFinished(AlignmentJob *);
+		
+	private slots:
+		
+		void finished(AlignmentJob *);
+		
+	private:
+		
+		void schedule();
+		void startJobs();
+		
+		QList<AlignmentJob *> jobs_;
+		bool scheduling_,rescheduleNeeded_;
+		int coreBudget_;
+		qint64 memoryBudget_;
+};
+
+#endif
@@ -24,7 +24,30 @@
 // THE SOFTWARE.
 //
 
+#include <QtDebug>
+#include "DebuggingInfo.h"
+
+#include <QDateTime>
+#include <QDomDocument>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QtConcurrentRun>
+
 #include "AlignmentTool.h"
+#include "Application.h"
+#include "ToolProcess.h"
+#include "XMLHelper.h"
+
+extern Application *app;
+
+#define PROBE_TIMEOUT 10000 // in ms
+
+// Guards the version cache file, since several tools are probed at once
+static QMutex versionCacheMutex;
 
 
 //
@@ -38,10 +61,42 @@ AlignmentTool::AlignmentTool()
 
 AlignmentTool::~AlignmentTool()
 {
+	versionProbe_.waitForFinished();
+}
+
+QString AlignmentTool::version()
+{
+	if (probing_){
+		version_ = versionProbe_.result(); // blocks until the probe finishes
+		probing_=false;
+		qDebug() << trace.header(__PRETTY_FUNCTION__) << name_ << " " << version_;
+	}
+	return version_;
+}
+
+QString AlignmentTool::tierName(int tier)
+{
+	switch (tier){
+		case Draft: return "draft";
+		case Standard: return "standard";
+		case Refined: return "refined";
+	}
+	return "unknown";
 }
 		
-void AlignmentTool::makeCommand(QString &, QString &, QString &, QStringList &)
+void AlignmentTool::makePipeCommand(QString &, QStringList &)
+{
+}
+
+bool AlignmentTool::makeAddCommand(const QString &,int,QString &, QStringList &)
+{
+	return false; // not supported
+}
+
+bool AlignmentTool::align(const QStringList &,QStringList &,QString &errmsg,QAtomicInt *,QAtomicInt *)
 {
+	errmsg = name_ + " can't align in-process";
+	return false;
 }
 
 void AlignmentTool::writeSettings(QDomDocument &,QDomElement &)
@@ -51,6 +106,44 @@ void AlignmentTool::writeSettings(QDomDocument &,QDomElement &)
 void AlignmentTool::readSettings(QDomDocument &)
 {
 }
+
+//
+// Protected
+//
+
+void AlignmentTool::writeResourceSettings(QDomDocument &doc,QDomElement &toolElem)
+{
+	XMLHelper::addElement(doc,toolElem,"threads",QString::number(threads_));
+	XMLHelper::addElement(doc,toolElem,"memory_limit",QString::number(memoryLimit_));
+	XMLHelper::addElement(doc,toolElem,"nice",QString::number(niceLevel_));
+}
+
+// Reads the resource settings from an alignment_tool element
+void AlignmentTool::readResourceSettings(const QDomNode &toolNode)
+{
+	QDomElement elem = toolNode.firstChildElement();
+	while (!elem.isNull()){
+		if (elem.tagName() == "threads")
+			threads_ = qMax(0,elem.text().toInt());
+		else if (elem.tagName() == "memory_limit")
+			memoryLimit_ = qMax(0,elem.text().toInt());
+		else if (elem.tagName() == "nice")
+			niceLevel_ = qBound(0,elem.text().toInt(),19);
+		elem=elem.nextSiblingElement();
+	}
+}
+
+// Starts a background probe of the executable's version, so that start-up doesn't wait on the tool.
+// The parser must not touch the tool, since it runs on the thread pool.
+void AlignmentTool::probeVersion(const QStringList &args,VersionParser parser)
+{
+	if (probing_)
+		versionProbe_.waitForFinished(); // the executable has changed under a running probe
+	version_="";
+	probing_=true;
+	versionProbe_ = QtConcurrent::run(&AlignmentTool::runVersionProbe,executable_,args,parser,
+		app->applicationTmpPath() + "/versions.txt");
+}
 		
 //
 //	Private
@@ -60,4 +153,73 @@ void AlignmentTool::init()
 {
 	preferred_=false;
 	usesStdOut_=false;
-}
\ No newline at end of file
+	threads_=0;
+	memoryLimit_=0;
+	niceLevel_=0;
+	probing_=false;
+}
+
+// Runs on the thread pool.
+// Versions are cached against the executable's path, modification time and size, 
+// so the tool only has to be run again when it is reinstalled or upgraded.
+QString AlignmentTool::runVersionProbe(const QString &exec,const QStringList &args,VersionParser parser,const QString &cacheFile)
+{
+	QFileInfo fi(exec);
+	if (!fi.exists())
+		return "";
+	QString mtime = QString::number(fi.lastModified().toMSecsSinceEpoch());
+	QString size  = QString::number(fi.size());
+	
+	{
+		QMutexLocker lock(&versionCacheMutex);
+		QFile f(cacheFile);
+		if (f.open(QIODevice::ReadOnly)){
+			QTextStream ts(&f);
+			while (!ts.atEnd()){
+				QStringList fields = ts.readLine().split('\t');
+				if (fields.size() == 4 && fields.at(0) == exec && fields.at(1) == mtime && fields.at(2) == size)
+					return fields.at(3);
+			}
+		}
+	}
+	
+	QString ver;
+	ToolProcess getver; // so that a tool running at the same time knows its CPU times include this
+	getver.start(exec,args);
+	if (getver.waitForStarted(PROBE_TIMEOUT)){
+		if (!getver.waitForFinished(PROBE_TIMEOUT)){
+			qWarning() << warning.header(__PRETTY_FUNCTION__) << exec << " timed out";
+			getver.kill();
+			getver.waitForFinished();
+			return ""; // not cached, so it's tried again next time
+		}
+		ver = parser(getver.readAllStandardOutput(),getver.readAllStandardError());
+		ver = ver.simplified(); // one line in the cache
+	}
+	
+	// Rewrite the cache, replacing any stale entry for this executable
+	QMutexLocker lock(&versionCacheMutex);
+	QStringList lines;
+	QFile f(cacheFile);
+	if (f.open(QIODevice::ReadOnly)){
+		QTextStream ts(&f);
+		while (!ts.atEnd()){
+			QString line = ts.readLine();
+			if (!line.startsWith(exec + "\t"))
+				lines.append(line);
+		}
+		f.close();
+	}
+	lines.append(exec + "\t" + mtime + "\t" + size + "\t" + ver);
+	
+	QSaveFile sf(cacheFile);
+	if (sf.open(QIODevice::WriteOnly)){
+		QTextStream ts(&sf);
+		for (int l=0;l<lines.size();l++)
+			ts << lines.at(l) << "\n";
+		ts.flush();
+		sf.commit();
+	}
+	
+	return ver;
+}
@@ -28,20 +28,28 @@
 #ifndef __ALIGNMENT_TOOL_H_
 #define __ALIGNMENT_TOOL_H_
 
+#include <QFuture>
 #include <QString>
+#include <QStringList>
 
+class QAtomicInt;
 class QDomDocument;
 class QDomElement;
+class QDomNode;
+
+class ProgressParser;
 
 class AlignmentTool
 {
 	public:
 		
+		enum QualityTier {Draft=1,Standard,Refined}; // how good an alignment the tool is expected to give
+		
 		AlignmentTool();
 		virtual ~AlignmentTool();
 		
 		QString name(){return name_;}
-		QString version(){return version_;}
+		QString version(); // waits for the version probe, if it is still running
 		QString executable(){return executable_;}
 		
 		void setExecutable(QString e){executable_=e;}
@@ -51,23 +59,55 @@ class AlignmentTool
 		
 		bool usesStdOut(){return usesStdOut_;} // the alignment is written to stdout
 		
-		virtual void makeCommand(QString &, QString &, QString &, QStringList &);
+		// Resources a run may use
+		// A threaded tool's command has a "%threads" placeholder, which the job replaces with the cores it is given
+		int threads(){return threads_;} // 0 uses what the core budget allows
+		void setThreads(int t){threads_=t;}
+		int memoryLimit(){return memoryLimit_;} // in MB, 0 for no limit
+		void setMemoryLimit(int mb){memoryLimit_=mb;}
+		int niceLevel(){return niceLevel_;}
+		void setNiceLevel(int n){niceLevel_=n;}
+		virtual bool threaded(){return false;} // the tool has a thread count option
+		
+		virtual int qualityTier(){return Refined;}
+		static QString tierName(int);
+		
+		virtual void makePipeCommand(QString &, QStringList &); // input on stdin, alignment on stdout
+		virtual bool makeAddCommand(const QString &,int,QString &, QStringList &); // adds the sequences on stdin (how many) to an existing alignment
+		
+		virtual ProgressParser *createProgressParser(){return NULL;} // for following a run from its log output
+		
+		virtual bool inProcess(){return false;} // aligns with align() rather than an external program
+		virtual bool align(const QStringList &,QStringList &,QString &,QAtomicInt *,QAtomicInt *); // cancel flag, progress per mille
 		
 		virtual void writeSettings(QDomDocument &,QDomElement &);
 		virtual void readSettings(QDomDocument &);
 	
 	protected:
 	
+		typedef QString (*VersionParser)(const QByteArray &,const QByteArray &); // stdout, stderr
+		
+		void probeVersion(const QStringList &,VersionParser);
+		
+		void writeResourceSettings(QDomDocument &,QDomElement &);
+		void readResourceSettings(const QDomNode &);
+		
 		QString name_;
 		QString version_;
 		QString executable_;
 		bool preferred_;
 		bool usesStdOut_;
+		int threads_,memoryLimit_,niceLevel_;
 		
 	private:
 	
 		void init();
 		
+		static QString runVersionProbe(const QString &,const QStringList &,VersionParser,const QString &);
+		
+		QFuture<QString> versionProbe_;
+		bool probing_;
+		
 };
 
 #endif
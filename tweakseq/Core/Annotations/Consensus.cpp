@@ -27,47 +27,15 @@
 #include <QtDebug>
 #include "DebuggingInfo.h"
 
+#include <QVector>
+
 #include "Consensus.h"
+#include "ScoringMatrix.h"
 #include "Sequence.h"
 #include "Sequences.h"
- 
-static int BLOSUM62[23][23] = 
-{
-	{  4,-1,-2,-2, 0,-1,-1, 0,-2,-1,-1,-1,-1,-2,-1, 1, 0,-3,-2, 0,-2,-1, 0}, //  0  A 
-	{ -1, 5, 0,-2,-3, 1, 0,-2, 0,-3,-2, 2,-1,-3,-2,-1,-1,-3,-2,-3,-1, 0,-1}, //  1  R
-	{ -2, 0, 6, 1,-3, 0, 0, 0, 1,-3,-3, 0,-2,-3,-2, 1, 0,-4,-2,-3, 3, 0,-1}, //  2  N 
-	{ -2,-2, 1, 6,-3, 0, 2,-1,-1,-3,-4,-1,-3,-3,-1, 0,-1,-4,-3,-3, 4, 1,-1}, //  3  D 
-	{  0,-3,-3,-3, 9,-3,-4,-3,-3,-1,-1,-3,-1,-2,-3,-1,-1,-2,-2,-1,-3,-3,-2}, //  4  C 
-	{ -1, 1, 0, 0,-3, 5, 2,-2, 0,-3,-2, 1, 0,-3,-1, 0,-1,-2,-1,-2, 0, 3,-1}, //  5  Q 
-	{ -1, 0, 0, 2,-4, 2, 5,-2, 0,-3,-3, 1,-2,-3,-1, 0,-1,-3,-2,-2, 1, 4,-1}, //  6  E 
-	{  0,-2, 0,-1,-3,-2,-2, 6,-2,-4,-4,-2,-3,-3,-2, 0,-2,-2,-3,-3,-1,-2,-1}, //  7  G 
-	{ -2, 0, 1,-1,-3, 0, 0,-2, 8,-3,-3,-1,-2,-1,-2,-1,-2,-2, 2,-3, 0, 0,-1}, //  8  H 
-	{ -1,-3,-3,-3,-1,-3,-3,-4,-3, 4, 2,-3, 1, 0,-3,-2,-1,-3,-1, 3,-3,-3,-1}, //  9  I 
-	{ -1,-2,-3,-4,-1,-2,-3,-4,-3, 2, 4,-2, 2, 0,-3,-2,-1,-2,-1, 1,-4,-3,-1}, // 10  L 
-	{ -1, 2, 0,-1,-3, 1, 1,-2,-1,-3,-2, 5,-1,-3,-1, 0,-1,-3,-2,-2, 0, 1,-1}, // 11  K 
-	{ -1,-1,-2,-3,-1, 0,-2,-3,-2, 1, 2,-1, 5, 0,-2,-1,-1,-1,-1, 1,-3,-1,-1}, // 12  M 
-	{ -2,-3,-3,-3,-2,-3,-3,-3,-1, 0, 0,-3, 0, 6,-4,-2,-2, 1, 3,-1,-3,-3,-1}, // 13  F 
-	{ -1,-2,-2,-1,-3,-1,-1,-2,-2,-3,-3,-1,-2,-4, 7,-1,-1,-4,-3,-2,-2,-1,-2}, // 14  P 
-	{  1,-1, 1, 0,-1, 0, 0, 0,-1,-2,-2, 0,-1,-2,-1, 4, 1,-3,-2,-2, 0, 0, 0}, // 15  S 
-	{  0,-1, 0,-1,-1,-1,-1,-2,-2,-1,-1,-1,-1,-2,-1, 1, 5,-2,-2, 0,-1,-1, 0}, // 16  T 
-	{ -3,-3,-4,-4,-2,-2,-3,-2,-2,-3,-2,-3,-1 ,1,-4,-3,-2,11, 2,-3,-4,-3,-2}, // 17  W 
-	{ -2,-2,-2,-3,-2,-1,-2,-3, 2,-1,-1,-2,-1, 3,-3,-2,-2, 2, 7,-1,-3,-2,-1}, // 18  Y 
-	{  0,-3,-3,-3,-1,-2,-2,-3,-3, 3, 1,-2, 1,-1,-2,-2, 0,-3,-1, 4,-3,-2,-1}, // 19  V 
-	{ -2,-1, 3, 4,-3, 0, 1,-1, 0,-3,-4, 0,-3,-3,-2, 0,-1,-4,-3,-3, 4, 1,-1}, // 20  B 
-	{ -1, 0, 0, 1,-3, 3, 4,-2, 0,-3,-3, 1,-1,-3,-1, 0,-1,-3,-2,-2, 1, 4,-1}, // 21  Z 
-	{  0,-1,-1,-1,-2,-1,-1,-1,-1,-1,-1,-1,-1,-1,-2, 0, 0,-2,-1,-1,-1,-1,-1}  // 22  X 
-};
-
-static int BLOSUM62map[26]=
-{
-	0,  20,   4,   3,   6,
- 13,   7,   8,   9,  22,
- 11,  10,  12,   2,  22,
- 14,   5,   1,  15,  16,
- 22,  19,  17,  22,  18,
- 21
-};
 
+#define COLUMN_BLOCK 4096 // columns counted at a time, which bounds the memory used
+ 
 Consensus::Consensus()
 {
 	valid_=false;
@@ -77,6 +45,9 @@ Consensus::~Consensus()
 {
 }
 
+// The score of a residue is the sum of its BLOSUM62 scores against the other residues in the column.
+// Residues with the same matrix row score the same, so the column is reduced to counts of each row,
+// and each row present is scored once, against the counts: O(L.N + L.|alphabet|^2)
 void Consensus::calculate()
 {
 	qDebug() << trace.header(__PRETTY_FUNCTION__);
@@ -85,78 +56,59 @@ void Consensus::calculate()
 	QList<Sequence *> &ss = sequences_->sequences();
 	int slen = ss.at(0)->residues.length();
 	int nseq = ss.size();
-	double *scores = new double[nseq];
-	double matches;
 	
-	// Convert the residues to indices into the scoring matrix 
-	char **rindex = new char*[nseq]; // * 8 bits is enough ...
-	for (int i=0;i<nseq;i++)
-		rindex[i] = new char[slen];
+	int pairScore[NUM_SYMBOLS][NUM_SYMBOLS];
+	makePairScores(pairScore);
 	
-	for (int s=0;s<nseq;s++){
-		Sequence *seq = ss.at(s);
-		for (int c=0;c<slen;c++){
-			QChar pChar = (seq->residues[c].unicode() & 0xff);
-			int idx = pChar.toLatin1()-65;
-			if (idx < 0 || idx > 25)
-				rindex[s][c]=99;
-			else
-				rindex[s][c]=BLOSUM62map[idx];
+	// Counts of each symbol in each column, and the first sequence it occurs in, so that ties are broken 
+	// as they are by the pairwise calculation. The sequences are read row by row, a block of columns at a time
+	QVector<int> counts(COLUMN_BLOCK*NUM_SYMBOLS);
+	QVector<int> firstRow(COLUMN_BLOCK*NUM_SYMBOLS);
+	for (int c0=0;c0<slen;c0+=COLUMN_BLOCK){
+		int ncols = qMin(COLUMN_BLOCK,slen-c0);
+		counts.fill(0);
+		firstRow.fill(-1);
+		for (int s=0;s<nseq;s++){
+			const QString &res = ss.at(s)->residues;
+			int n = res.length();
+			for (int c=0;c<ncols;c++){
+				int i = c*NUM_SYMBOLS + (c0 + c < n ? symbolIndex(res.at(c0 + c)) : GAP_SYMBOL); // a short sequence is padded with gaps
+				if (counts.at(i) == 0)
+					firstRow[i]=s;
+				counts[i]++;
+			}
 		}
-	}
-	
-	for (int c=0;c<slen;c++){ // for each column in the alignment
-		double hiScore=0.0;
-		int riHiScore=0;
-		double riMatches=0; //weighted, so need double
-		for (int ri=0;ri<nseq;ri++){ // for each residue in the column
-			scores[ri]=0.0;
-			matches=0.0;
-			for (int rj=0;rj<nseq;rj++){
-				if (ri==rj) continue;
-				double weight = 1.0;
-				int resi=rindex[ri][c];
-				int resj=rindex[rj][c];
-				if (resi == 99 && resj == 99){
-					scores[ri]+= weight;
-					if (weight > 0)
-						matches += weight;
+		
+		for (int c=0;c<ncols;c++){ // for each column in the block
+			const int *cnt = counts.constData() + c*NUM_SYMBOLS;
+			const int *first = firstRow.constData() + c*NUM_SYMBOLS;
+			double hiScore=0.0;
+			int hiSymbol=-1;
+			double hiMatches=0; // weighted, so need double
+			for (int si=0;si<NUM_SYMBOLS;si++){
+				if (cnt[si] == 0) continue;
+				// against the rest of the column, so a residue's score against itself is taken off
+				double score = -pairScore[si][si];
+				double matches = (pairScore[si][si] > 0 ? -1.0 : 0.0);
+				for (int sj=0;sj<NUM_SYMBOLS;sj++){
+					if (cnt[sj] == 0) continue;
+					score += cnt[sj]*pairScore[si][sj];
+					if (pairScore[si][sj] > 0)
+						matches += cnt[sj];
 				}
-				else if (resi == 99 || resj == 99)
-					scores[ri]+=-4*weight;
-				else{
-					double tmp = BLOSUM62[resi][resj]*weight;
-					scores[ri]+= tmp;
-					if (tmp > 0)
-						matches += weight;
+				if (hiSymbol < 0 || score > hiScore || (score == hiScore && first[si] < first[hiSymbol])){
+					hiScore=score;
+					hiSymbol=si;
+					hiMatches=matches;
 				}
-						
-			}
-			if (ri==0){
-				hiScore = scores[ri];
-				riHiScore=ri;
-				riMatches=matches;
-			}
-			else if (scores[ri] > hiScore){
-				hiScore = scores[ri];
-				riHiScore=ri;
-				riMatches=matches;
 			}
+			if (hiSymbol >= 0 && hiMatches >= plurality_)
+				consensusSequence_[c0 + c]=QChar(ss.at(first[hiSymbol])->residues[c0 + c].unicode() & 0xff);
+			else
+				consensusSequence_[c0 + c]=QChar('?'); // not standard - for internal use
 		}
-		//qDebug() << c << " " << riHiScore << " " << hiScore << " " << riMatches << 
-		//	QChar(ss.at(riHiScore)->residues[c].unicode() & 0xff);
-		if (riMatches >= plurality_)
-			consensusSequence_[c]=QChar(ss.at(riHiScore)->residues[c].unicode() & 0xff);
-		else
-			consensusSequence_[c]=QChar('?'); // not standard - for internal use
 	}
 	
-	delete[] scores;
-	
-	for (int i=0;i<nseq;i++)
-		delete[] rindex[i];
-	delete[] rindex;
-	//qDebug() << consensusSequence_;
 	valid_=true;
 }
 
@@ -189,6 +141,32 @@ QString &Consensus::sequence()
 	return consensusSequence_;
 }
 
+//
+//	Private members
+//	
+
+// Anything other than 'A'..'Z' (gaps, in particular) is one symbol, after the matrix's rows
+int Consensus::symbolIndex(QChar r)
+{
+	int idx = (r.unicode() & 0xff) - 'A';
+	if (idx < 0 || idx > 25)
+		return GAP_SYMBOL;
+	return ScoringMatrix::BLOSUM62map[idx];
+}
+
+// Scores of each pair of symbols: BLOSUM62 for residues, +1 for two gaps and -4 for a gap against a residue
+void Consensus::makePairScores(int scores[NUM_SYMBOLS][NUM_SYMBOLS])
+{
+	for (int i=0;i<NUM_RESIDUE_TYPES;i++)
+		for (int j=0;j<NUM_RESIDUE_TYPES;j++)
+			scores[i][j]=ScoringMatrix::BLOSUM62[i][j];
+	for (int i=0;i<NUM_RESIDUE_TYPES;i++){
+		scores[i][GAP_SYMBOL]=-4;
+		scores[GAP_SYMBOL][i]=-4;
+	}
+	scores[GAP_SYMBOL][GAP_SYMBOL]=1;
+}
+
 
 //
 //
@@ -27,6 +27,14 @@
 #ifndef __CONSENSUS_H_
 #define __CONSENSUS_H_
 
+#include <QChar>
+#include <QString>
+
+#include "ScoringMatrix.h"
+
+#define NUM_SYMBOLS (NUM_RESIDUE_TYPES+1) // the residue types, and a gap
+#define GAP_SYMBOL NUM_RESIDUE_TYPES
+
 class Sequences;
 
 class Consensus{
@@ -52,6 +60,9 @@ class Consensus{
 		
 	private:
 		
+		static int symbolIndex(QChar);
+		static void makePairScores(int [NUM_SYMBOLS][NUM_SYMBOLS]);
+		
 		double plurality_;
 		Sequences *sequences_;
 		QString consensusSequence_;
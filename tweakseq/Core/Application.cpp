@@ -50,7 +50,7 @@ Application::Application(int &argc, char **argv):QApplication(argc,argv)
 	connect(this,SIGNAL(aboutToQuit()),this,SLOT(cleanup()));
 }
 
-bool Application::configure()
+bool Application::configure(bool interactive)
 {
 	// This does first time setup of the application if necessary
 	
@@ -73,6 +73,10 @@ bool Application::configure()
 		return true;
 	}
 	
+	// Without a user to run the wizard, only the built-in aligner is available
+	if (!interactive)
+		return true;
+	
 	// If we get here, then we have to run the wizard
 	SetupWizard sw;
 	sw.addMessage(msg);
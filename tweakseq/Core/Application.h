@@ -52,7 +52,7 @@ class Application : public QApplication
 		
 		QDomDocument & defaultSettings(){return *defaultSettings_;}
 		
-		bool configure();
+		bool configure(bool interactive=true);
 		Clipboard& clipboard(){return clipboard_;}
 		
 		void showAboutDialog(QWidget *);
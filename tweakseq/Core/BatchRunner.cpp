@@ -0,0 +1,257 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <QtDebug>
+#include "DebuggingInfo.h"
+
+#include <iostream>
+
+#include <QEventLoop>
+#include <QFileInfo>
+
+#include "A3MFile.h"
+#include "AlignmentJob.h"
+#include "AlignmentTool.h"
+#include "Application.h"
+#include "BatchRunner.h"
+#include "ClustalFile.h"
+#include "FASTAFile.h"
+#include "Project.h"
+#include "Sequence.h"
+
+//
+//	Public members
+//	
+
+BatchRunner::BatchRunner(QObject *parent):QObject(parent)
+{
+	consensus_=false;
+	lineWidth_=0;
+}
+
+BatchRunner::~BatchRunner()
+{
+}
+
+int BatchRunner::run()
+{
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << inputs_ << toolName_ << output_;
+	
+	QString errmsg;
+	if (inputs_.isEmpty())
+		errmsg = "No input files were given";
+	else if (output_.isEmpty())
+		errmsg = "No output file was given";
+	else if (lineWidth_ < 0)
+		errmsg = "The line width must be a positive number";
+	if (!errmsg.isEmpty()){
+		std::cerr << "tweakseq: " << qPrintable(errmsg) << std::endl << qPrintable(usage());
+		return EXIT_FAILURE;
+	}
+	
+	Project *prj = app->createProject(); // no main window is created
+	bool ok = load(prj,errmsg);
+	if (ok && !toolName_.isEmpty())
+		ok = align(prj,errmsg);
+	if (ok && consensus_)
+		prj->setAligned(true); // this calculates it
+	if (ok)
+		ok = write(prj,errmsg);
+	
+	if (!ok){
+		std::cerr << "tweakseq: " << qPrintable(errmsg) << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+QString BatchRunner::usage()
+{
+	return
+		"usage: tweakseq -x [-a tool] [-k] [-F format] [-L width] -O output input ...\n"
+		"  -x         run without a user interface\n"
+		"  -a tool    align with clustalo, MUSCLE, MAFFT, built-in, or default (the preferred tool)\n"
+		"  -k         calculate the consensus, which is written after the sequences\n"
+		"  -F format  fasta, clustal, a3m or tsq (a project). The default is from the output file's extension\n"
+		"  -L width   residues per line in FASTA and Clustal output. The defaults are 80 and 60\n"
+		"  -O output  the output file\n"
+		"  input      a project, or one or more sequence files\n";
+}
+
+//
+//	Private slots
+//	
+
+// The tool's log and errors both go to stderr, leaving stdout to the pipeline
+void BatchRunner::jobMessage(const QString &msg,bool)
+{
+	std::cerr << qPrintable(msg) << std::endl;
+}
+
+//
+//	Private members
+//	
+
+bool BatchRunner::load(Project *prj,QString &errmsg)
+{
+	for (int f=0;f<inputs_.size();f++){
+		if (!QFileInfo(inputs_.at(f)).isReadable()){
+			errmsg = "Can't read " + inputs_.at(f);
+			return false;
+		}
+	}
+	
+	if (inputs_.size() == 1 && inputs_.first().endsWith(".tsq")){
+		QString fname = inputs_.first();
+		prj->load(fname);
+		if (prj->empty()){
+			errmsg = "No sequences were read from the project " + fname;
+			return false;
+		}
+		return true;
+	}
+	
+	if (!prj->importSequences(inputs_,errmsg))
+		return false;
+	if (prj->empty()){
+		errmsg = "No sequences were read";
+		return false;
+	}
+	return true;
+}
+
+// Runs the tool as an ordinary alignment job, waiting for it here
+bool BatchRunner::align(Project *prj,QString &errmsg)
+{
+	if (toolName_ != "default"){
+		prj->setAlignmentTool(toolName_);
+		if (prj->alignmentTool()->name() != toolName_){
+			errmsg = "The alignment tool " + toolName_ + " is not configured";
+			return false;
+		}
+	}
+	AlignmentTool *tool = prj->alignmentTool();
+	
+	QList<Sequence *> &seqs = prj->sequences.sequences();
+	if (seqs.size() < 2){
+		errmsg = "At least two sequences are needed for an alignment";
+		return false;
+	}
+	
+	QString exec;
+	QStringList args;
+	tool->makePipeCommand(exec,args);
+	
+	AlignmentJob job("all",true);
+	for (int s=0;s<seqs.size();s++)
+		job.addSequence(seqs.at(s)->label,seqs.at(s)->filter(true));
+	job.setCommand(exec,args);
+	job.setLimits(tool->memoryLimit(),tool->niceLevel());
+	job.setThreads(tool->threads(),tool->threaded() || tool->inProcess());
+	job.setProgressParser(tool->createProgressParser());
+	job.setToolInfo(tool->name(),tool->version());
+	if (tool->inProcess())
+		job.setInProcess(tool);
+	
+	QEventLoop loop;
+	connect(&job,SIGNAL(message(const QString &,bool)),this,SLOT(jobMessage(const QString &,bool)));
+	connect(&job,SIGNAL(finished(AlignmentJob *)),&loop,SLOT(quit()));
+	job.start();
+	if (job.state() == AlignmentJob::Running)
+		loop.exec();
+	
+	if (job.state() != AlignmentJob::Finished){
+		prj->runHistory.add(&job);
+		errmsg = "The alignment with " + tool->name() + " failed";
+		return false;
+	}
+	
+	ResourceUsage u = job.usage();
+	std::cerr << "aligned " << seqs.size() << " sequences with " << qPrintable(tool->name()) << ": wall " << u.wall 
+		<< " ms, user " << u.user << " ms, sys " << u.sys << " ms, peak RSS "
+		<< (u.peakRSS > 0 ? qPrintable(QString::number(u.peakRSS) + " kB") : "unknown") << std::endl;
+	prj->runHistory.add(&job);
+	prj->readNewAlignment(job.output().labels(),job.output().sequences(),true);
+	return true;
+}
+
+bool BatchRunner::write(Project *prj,QString &errmsg)
+{
+	QString format = format_.toLower();
+	if (format.isEmpty()){
+		QString suffix = QFileInfo(output_).suffix().toLower();
+		if (suffix == "tsq")
+			format = "tsq";
+		else if (suffix == "aln" || suffix == "clw")
+			format = "clustal";
+		else if (suffix == "a3m")
+			format = "a3m";
+		else
+			format = "fasta";
+	}
+	
+	if (format == "tsq"){
+		QString fname = QFileInfo(output_).absoluteFilePath();
+		if (!prj->save(fname)){
+			errmsg = "Failed to write " + output_;
+			return false;
+		}
+		return true;
+	}
+	
+	SequenceFile *sf;
+	if (format == "fasta")
+		sf = new FASTAFile(output_);
+	else if (format == "clustal")
+		sf = new ClustalFile(output_);
+	else if (format == "a3m")
+		sf = new A3MFile(output_);
+	else{
+		errmsg = "Unknown output format " + format_;
+		return false;
+	}
+	
+	sf->setLineWidth(lineWidth_); // ignored if 0
+	
+	QStringList labels,seqs,comments;
+	QList<Sequence *> &sequences = prj->sequences.sequences();
+	for (int s=0;s<sequences.size();s++){
+		labels.append(sequences.at(s)->label);
+		seqs.append(sequences.at(s)->filter(true));
+		comments.append(sequences.at(s)->comment);
+	}
+	if (consensus_ && prj->consensusSequence.isValid()){
+		labels.append("consensus");
+		seqs.append(prj->consensusSequence.sequence());
+		comments.append("");
+	}
+	
+	bool ok = sf->write(labels,seqs,comments);
+	delete sf;
+	if (!ok)
+		errmsg = "Failed to write " + output_;
+	return ok;
+}
@@ -0,0 +1,77 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef __BATCH_RUNNER_H_
+#define __BATCH_RUNNER_H_
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class Project;
+
+// Runs tweakseq without a user interface, for scripts and batch pipelines.
+// A project or sequence files are loaded, optionally aligned with one of the configured tools
+// and given a consensus, and then written out as FASTA, Clustal, A3M or a project.
+// Messages go to stderr, and run() returns the process's exit status.
+
+class BatchRunner:public QObject
+{
+	Q_OBJECT
+	
+	public:
+		
+		BatchRunner(QObject *parent=NULL);
+		~BatchRunner();
+		
+		void setInputs(const QStringList &files){inputs_=files;}
+		void setAlignmentTool(const QString &t){toolName_=t;} // empty for no alignment, "default" for the preferred tool
+		void setConsensus(bool c){consensus_=c;}
+		void setOutput(const QString &fname,const QString &format){output_=fname;format_=format;} // the format may be empty
+		void setLineWidth(int w){lineWidth_=w;} // residues per line, 0 for the format's default
+		
+		int run();
+		
+		static QString usage();
+		
+	private slots:
+		
+		void jobMessage(const QString &,bool);
+		
+	private:
+		
+		bool load(Project *,QString &);
+		bool align(Project *,QString &);
+		bool write(Project *,QString &);
+		
+		QStringList inputs_;
+		QString toolName_;
+		bool consensus_;
+		QString output_,format_;
+		int lineWidth_;
+};
+
+#endif
@@ -0,0 +1,127 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <cstring>
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+
+#include "BufferedWriter.h"
+#include "Sequence.h"
+
+//
+//	Public members
+//	
+
+BufferedWriter::BufferedWriter(QIODevice *dev,int bufferSize)
+{
+	dev_=dev;
+	size_=bufferSize;
+	buf_ = new char[size_];
+	used_=0;
+	nWritten_=0;
+	ok_=true;
+}
+
+BufferedWriter::~BufferedWriter()
+{
+	flush();
+	delete[] buf_;
+}
+
+void BufferedWriter::write(char c)
+{
+	if (used_ == size_) flush();
+	buf_[used_++]=c;
+}
+
+void BufferedWriter::write(const char *data,int n)
+{
+	if (n > size_){ // too big to bother buffering
+		flush();
+		if (dev_->write(data,n) != n) ok_=false;
+		nWritten_ += n;
+		return;
+	}
+	flushIfFull(n);
+	memcpy(buf_+used_,data,n);
+	used_ += n;
+}
+
+void BufferedWriter::write(const QString &s)
+{
+	// Labels and comments are encoded as QTextStream would by default
+	QByteArray ba = s.toLocal8Bit();
+	write(ba.constData(),ba.size());
+}
+
+void BufferedWriter::writeResidues(const QChar *res,int n)
+{
+	while (n > 0){
+		if (used_ == size_) flush();
+		int nout = qMin(n,size_-used_);
+		char *p = buf_+used_;
+		for (int i=0;i<nout;i++)
+			p[i] = (char) (res[i].unicode() & REMOVE_FLAGS);
+		used_ += nout;
+		res += nout;
+		n -= nout;
+	}
+}
+
+void BufferedWriter::fill(char c,int n)
+{
+	while (n > 0){
+		if (used_ == size_) flush();
+		int nout = qMin(n,size_-used_);
+		memset(buf_+used_,c,nout);
+		used_ += nout;
+		n -= nout;
+	}
+}
+
+bool BufferedWriter::flush()
+{
+	if (used_ > 0){
+		if (dev_->write(buf_,used_) != used_)
+			ok_=false;
+		nWritten_ += used_;
+		used_=0;
+	}
+	return ok_;
+}
+
+//
+//	Private members
+//	
+
+bool BufferedWriter::flushIfFull(int n)
+{
+	if (used_ + n > size_)
+		return flush();
+	return ok_;
+}
@@ -0,0 +1,66 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef __BUFFERED_WRITER_H_
+#define __BUFFERED_WRITER_H_
+
+#include <QtGlobal>
+
+class QIODevice;
+class QString;
+
+// Accumulates output in a large buffer and writes it to the device in big chunks
+// Residues are copied straight from a sequence's storage, with the flag bits stripped
+class BufferedWriter
+{
+	public:
+		
+		BufferedWriter(QIODevice *,int bufferSize=1048576);
+		~BufferedWriter();
+		
+		void write(char);
+		void write(const char *,int);
+		void write(const QString &);
+		void writeResidues(const QChar *,int);
+		void fill(char,int);
+		
+		bool flush();
+		bool ok(){return ok_;}
+		
+		qint64 bytesWritten(){return nWritten_ + used_;}
+		
+	private:
+		
+		bool flushIfFull(int);
+		
+		QIODevice *dev_;
+		char *buf_;
+		int size_,used_;
+		qint64 nWritten_;
+		bool ok_;
+};
+
+#endif
@@ -0,0 +1,94 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <QtDebug>
+#include "DebuggingInfo.h"
+
+#include <QDomDocument>
+#include <QStringList>
+
+#include "BuiltInAligner.h"
+#include "ProgressiveAligner.h"
+#include "Version.h"
+#include "XMLHelper.h"
+
+//
+//	Public
+//
+
+BuiltInAligner::BuiltInAligner()
+{
+	init();
+}
+
+BuiltInAligner::~BuiltInAligner()
+{
+}
+
+bool BuiltInAligner::align(const QStringList &seqs,QStringList &aligned,QString &errmsg,QAtomicInt *cancel,QAtomicInt *progress)
+{
+	ProgressiveAligner pa(ProgressiveAligner::guessScoring(seqs));
+	return pa.align(seqs,aligned,errmsg,cancel,progress);
+}
+
+void BuiltInAligner::writeSettings(QDomDocument &doc,QDomElement &parentElem)
+{
+	QDomElement pelem = doc.createElement("alignment_tool");
+	parentElem.appendChild(pelem);
+	XMLHelper::addElement(doc,pelem,"name",name());
+	XMLHelper::addElement(doc,pelem,"preferred",(preferred() ? "yes":"no"));
+}
+
+void BuiltInAligner::readSettings(QDomDocument &doc)
+{
+	QDomNodeList nl = doc.elementsByTagName("alignment_tool");
+	for (int i=0;i<nl.count();++i){
+		QDomNode gNode = nl.item(i);
+		QDomElement elem = gNode.firstChildElement();
+		while (!elem.isNull()){
+			if (elem.tagName() == "name"){
+				if (elem.text() != name_)
+					break;
+			}
+			if (elem.tagName() == "preferred"){
+				setPreferred(elem.text() == "yes");
+			}
+			elem=elem.nextSiblingElement();
+		}
+	}
+}
+
+//		
+//	Private
+//	
+
+void BuiltInAligner::init()
+{
+	name_="built-in";
+	version_=APP_VERSION;
+	executable_="";
+	usesStdOut_=false;
+}
@@ -0,0 +1,55 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef __BUILT_IN_ALIGNER_H_
+#define __BUILT_IN_ALIGNER_H_
+
+#include "AlignmentTool.h"
+
+// The in-process progressive aligner, as an alignment tool.
+// It is always available, so it is the default when no external tool is configured
+
+class BuiltInAligner: public AlignmentTool
+{
+	public:
+		
+		BuiltInAligner();
+		~BuiltInAligner();
+		
+		virtual bool inProcess(){return true;}
+		virtual int qualityTier(){return Standard;} // no iterative refinement
+		virtual bool align(const QStringList &,QStringList &,QString &,QAtomicInt *,QAtomicInt *);
+		
+		virtual void writeSettings(QDomDocument &,QDomElement &);
+		virtual void readSettings(QDomDocument &);
+		
+	private:
+	
+		void init();
+		
+};
+
+#endif
@@ -27,16 +27,16 @@
 #include <QtDebug>
 #include "DebuggingInfo.h"
 
-#include <cmath>
-
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
 #include <QStringList>
+#include <QTextStream>
 
-#include "Application.h"
+#include "BufferedWriter.h"
 #include "ClustalFile.h"
-
-extern Application *app;
+#include "CompressedDevice.h"
+#include "Version.h"
 
 // Base class for supported sequence alignment formats
 
@@ -50,6 +50,7 @@ ClustalFile::ClustalFile(QString n):SequenceFile(n)
 	ext << "*.aln";
 	setExtensions(ext,SequenceFile::Proteins);
 	setExtensions(ext,SequenceFile::DNA);
+	setLineWidth(60);
 }
 
 ClustalFile::~ClustalFile()
@@ -69,88 +70,100 @@ bool ClustalFile::read(QStringList &seqnames, QStringList &seqs,QStringList &,St
 {
 	QString s;
 	
-	qDebug() << trace.header() << "ClustalFile::read() " << name();
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << name();
 	
 	setError("");
 	
 	QFile f(name());
 	if (!f.open(QIODevice::ReadOnly | QIODevice::Text)){
-		qDebug() << trace.header() << "ClustalFile::read() couldn't open file";
+		qDebug() << trace.header(__PRETTY_FUNCTION__) << "couldn't open file";
 		setError("Couldn't open file");
 		return false;
 	}
 	QTextStream ts (&f);
 	
 	// Eat all lines until we get CLUSTAL (which should be the first line)
-	while (!ts.atEnd()){
-		s = ts.readLine();
-		qDebug() << trace.header() << "line:" << s;
+	bool identified=false;
+	while (ts.readLineInto(&s)){
 		if (s.contains("CLUSTAL")){
 			// CLUSTALW is either "CLUSTALW" or "CLUSTAL W"
 			// CLUSTAL O is
 			// FIXME
-			qDebug() << trace.header() << "ClustalFile::read() identified";
+			identified=true;
 			break;
 		}
 	}
 	
-	if (ts.atEnd()){
+	if (!identified){
 		qDebug() << trace.header(__PRETTY_FUNCTION__) << "not CLUSTAL format";
 		setError("Not CLUSTAL format");
 		return false;
 	}
 	
-	int nblk=0;
-	int seqcnt=0;
-	QRegExp ws = QRegExp("\\s+");
-
 	// FIXME no guess at data type
 	
-	//bool dataTypeIdentified=false;
-	//int dataType=SequenceFile::DNA;
-	//QRegExp regex("[EFIPQZ]");
+	// The layout of the alignment (the number of sequences and their names) is learned from
+	// the first block. Residues from subsequent blocks are appended to the sequences in place, 
+	// using buffers sized from an estimate of the number of blocks in the file 
+	int nseqs=0;
+	int seqcnt=0;
+	bool firstBlock=true;
+	qint64 firstBlockBytes=0;
+	int firstBlockResidues=0;
 	
-	while (!ts.atEnd()){
-		s = ts.readLine().trimmed();
-		if (s.isEmpty()){ // new block follows
-			if (nblk==0)
-				nblk=seqcnt;
-			seqcnt=0;
+	while (ts.readLineInto(&s)){
+		
+		const QChar *line = s.constData();
+		int len = s.size();
+		
+		if (firstBlock)
+			firstBlockBytes += len+1;
+		
+		// Lines starting with whitespace are either empty or contain conservation information
+		// Either way, a block has ended if we have seen any sequences
+		if (len == 0 || line[0].isSpace()){ 
+			if (seqcnt > 0){
+				if (firstBlock){
+					nseqs=seqcnt;
+					firstBlock=false;
+					// Use the first block to estimate the final length of each sequence
+					int nblks = (firstBlockBytes > 0 ? f.size()/firstBlockBytes + 1 : 1);
+					for (int i=0;i<nseqs;i++)
+						seqs[i].reserve(nblks*firstBlockResidues);
+				}
+				seqcnt=0;
+			}
 			continue;
 		}
-		// There's something in the line
-		// If the line contains '.','*',or ':' then it's the conservation information and it is skipped
-		if (s.contains('.') || s.contains('*') || s.contains(':'))
-			continue;
+		
 		// Must be a sequence
-		// Consists of name, sequence and optionally some other stuff, all whitespace separated
-		QStringList strl = s.split(ws);
-		if (nblk==0){ // first
-			seqnames.append(strl.at(0));
-			seqs.append(strl.at(1));
+		// Consists of name, sequence and optionally a residue count, all whitespace separated
+		int i=0;
+		while (i<len && !line[i].isSpace()) i++;
+		int labelEnd=i;
+		while (i<len && line[i].isSpace()) i++;
+		int resStart=i;
+		while (i<len && !line[i].isSpace()) i++;
+		int resEnd=i;
+		
+		if (firstBlock){
+			seqnames.append(QString(line,labelEnd));
+			seqs.append(QString(line+resStart,resEnd-resStart));
+			if (resEnd-resStart > firstBlockResidues)
+				firstBlockResidues = resEnd-resStart;
 		}
 		else{
-			seqs.replace(seqcnt,seqs.at(seqcnt)+strl.at(1));
+			if (seqcnt >= nseqs || QStringRef(&s,0,labelEnd) != seqnames.at(seqcnt)){
+				qDebug() << trace.header(__PRETTY_FUNCTION__) << "unexpected sequence " << s.left(labelEnd);
+				setError("Inconsistent sequences in alignment blocks");
+				return false;
+			}
+			seqs[seqcnt].append(line+resStart,resEnd-resStart);
 		}
-		
-		// Try to identify the sequence data
-		// Protein specific codes are E,F,I,P,Q,Z
-		//if (!dataTypeIdentified){
-		//	if (strl.at(1).contains(regex)){
-		//		dataType=SequenceFile::Proteins;
-		//		dataTypeIdentified=true;
-		//		qDebug() << trace.header(__PRETTY_FUNCTION__) << "data type is PROTEIN";
-		//	}
-		//}
-		//qDebug() << trace.header() << strl.length() << strl.at(0);
-		
 		seqcnt++;
 	}
 	
-	// The sequences are read into a temporary QStringList
-	for (int i=0;i<seqnames.size();i++){
-		qDebug() << trace.header() << seqnames.at(i) << " " << seqs.at(i);
-	}
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << "read " << seqnames.size() << " sequences";
 
 	return true;
 }
@@ -160,21 +173,23 @@ bool ClustalFile::write(QStringList &l,QStringList &s,QStringList &)
 	
 	setError("");
 	
+	QElapsedTimer timer;
+	timer.start();
+	
+	// Output is compressed if the extension asks for it
+	CompressedDevice::Format compression = CompressedDevice::formatForFile(name());
+	QString errmsg;
+	if (!CompressedDevice::available(compression,errmsg)){
+		setError(errmsg);
+		return false;
+	}
 	QFile f(name());
-	if (!f.open(QIODevice::WriteOnly | QIODevice::Text)){
+	if (!f.open(CompressedDevice::fileOpenMode(compression))){
 		qDebug() << trace.header() << "ClustalFile::write() couldn't open file";
 		setError("Couldn't open file");
 		return false;
 	}
 	
-	// Prettify - find the longest label so that this field can be made a constant width
-	int maxlablen =0;
-	for (int li=0;li<l.size();li++){
-		if (l.at(li).size() > maxlablen)
-			maxlablen = l.at(li).size();
-	}
-	maxlablen += 3;
-	
 	// Determine the number of output blocks from the longest sequence
 	int maxseqlen=0;
 	for (int si=0;si<s.size();si++){
@@ -182,29 +197,69 @@ bool ClustalFile::write(QStringList &l,QStringList &s,QStringList &)
 			maxseqlen = s.at(si).size();
 	}
 	
-	int nblks = rint(maxseqlen/60);
-	if (nblks*60 < maxseqlen) nblks++;
-		
-	QTextStream ts (&f);
+	int lw = lineWidth();
+	int nblks = maxseqlen/lw;
+	if (nblks*lw < maxseqlen) nblks++;
 	
-	ts << "CLUSTALW created by tweakseq " << app->version() << endl;
-	ts << endl;
-	ts << endl;
-	
-	for (int b=1;b<=nblks;b++){
-		QString conservationDegree = QString(60,'*');
-		for (int si=0;si<s.size();si++){
-			ts.setFieldAlignment(QTextStream::AlignLeft);
-			ts << qSetFieldWidth(maxlablen) << l.at(si);
-			ts.reset();
-			ts << s.at(si).mid((b-1)*60,60) << endl;
-		}
-		QString p = QString(maxlablen,' ');
-		ts << p << conservationDegree << endl;
-		ts << endl;
+	// Labels are converted once, rather than once per block
+	QList<QByteArray> labels;
+	for (int li=0;li<l.size();li++)
+		labels.append(l.at(li).toLocal8Bit());
+	
+	// Prettify - find the longest label so that this field can be made a constant width
+	int maxlablen =0;
+	for (int li=0;li<labels.size();li++){
+		if (labels.at(li).size() > maxlablen)
+			maxlablen = labels.at(li).size();
 	}
+	maxlablen += 3;
 	
+	CompressedDevice cd(&f,compression);
+	if (!cd.open(QIODevice::WriteOnly)){
+		f.close();
+		setError(cd.errorString());
+		return false;
+	}
+	BufferedWriter bw(&cd);
+	
+	writeHeader(bw);
+	for (int b=0;b<nblks;b++)
+		writeBlock(bw,labels,s,b,maxlablen);
+	
+	bool ok = bw.flush() && cd.finish();
 	f.close();
 	
+	if (!ok){
+		setError("Error while writing file");
+		return false;
+	}
+	
+	qint64 ms = timer.elapsed();
+	qInfo() << benchmark.header(__PRETTY_FUNCTION__) << l.size() << "sequences" << bw.bytesWritten() << "bytes" << ms << "ms"
+		<< (ms > 0 ? bw.bytesWritten()/(1048.576*ms) : 0.0) << "MB/s";
 	return true;
-}
\ No newline at end of file
+}
+
+void ClustalFile::writeHeader(BufferedWriter &bw)
+{
+	bw.write(QString("CLUSTALW created by tweakseq ") + APP_VERSION);
+	bw.write("\n\n\n",3);
+}
+
+// Writes block b of the alignment, padding the labels to labelWidth
+void ClustalFile::writeBlock(BufferedWriter &bw,const QList<QByteArray> &labels,const QStringList &s,int b,int labelWidth)
+{
+	int lw = lineWidth();
+	int start = b*lw;
+	for (int si=0;si<s.size();si++){
+		bw.write(labels.at(si).constData(),labels.at(si).size());
+		bw.fill(' ',labelWidth-labels.at(si).size());
+		int nres = qMin(lw,s.at(si).size()-start);
+		if (nres > 0)
+			bw.writeResidues(s.at(si).constData()+start,nres);
+		bw.write('\n');
+	}
+	bw.fill(' ',labelWidth);
+	bw.fill('*',lw); // FIXME conservation is not calculated 
+	bw.write("\n\n",2);
+}
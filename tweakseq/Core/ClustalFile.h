@@ -27,8 +27,13 @@
 #ifndef __CLUSTAL_FILE_
 #define __CLUSTAL_FILE_
 
+#include <QByteArray>
+#include <QList>
+
 #include "SequenceFile.h"
 
+class BufferedWriter;
+
 class ClustalFile:public SequenceFile{
 	public:
 		
@@ -39,6 +44,9 @@ class ClustalFile:public SequenceFile{
 		
 		virtual bool read(QStringList &,QStringList &,QStringList &,Structure *s=NULL);
 		virtual bool write(QStringList &,QStringList &,QStringList &);
+		
+		void writeHeader(BufferedWriter &);
+		void writeBlock(BufferedWriter &,const QList<QByteArray> &,const QStringList &,int,int);
 	
 	private:
 		
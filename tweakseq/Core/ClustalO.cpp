@@ -28,9 +28,9 @@
 #include "DebuggingInfo.h"
 
 #include <QDomDocument>
-#include <QProcess>
 
 #include "ClustalO.h"
+#include "ProgressParser.h"
 #include "XMLHelper.h"
 //
 //	Public
@@ -45,10 +45,24 @@ ClustalO::~ClustalO()
 {
 }
 		
-void ClustalO::makeCommand(QString &fin, QString &fout, QString &exec, QStringList &arglist)
+void ClustalO::makePipeCommand(QString &exec, QStringList &arglist)
 {
 	exec = executable_;
-	arglist << "--force" << "-v" << "--outfmt=fa" << "--output-order=tree-order" << "-i" << fin << "-o" << fout;
+	// "-" is stdin and with no -o, the alignment goes to stdout (after the log messages)
+	arglist << "-v" << "--outfmt=fa" << "--output-order=tree-order" << "-i" << "-" << "--threads=%threads";
+}
+
+bool ClustalO::makeAddCommand(const QString &alignment,int,QString &exec, QStringList &arglist)
+{
+	exec = executable_;
+	// The sequences on stdin are aligned to the profile
+	arglist << "-v" << "--outfmt=fa" << "--profile1=" + alignment << "-i" << "-" << "--threads=%threads";
+	return true;
+}
+
+ProgressParser *ClustalO::createProgressParser()
+{
+	return new ClustalOProgressParser();
 }
 
 void ClustalO::writeSettings(QDomDocument &doc,QDomElement &parentElem)
@@ -58,6 +72,7 @@ void ClustalO::writeSettings(QDomDocument &doc,QDomElement &parentElem)
 	XMLHelper::addElement(doc,pelem,"name",name());
 	XMLHelper::addElement(doc,pelem,"path",executable());
 	XMLHelper::addElement(doc,pelem,"preferred",(preferred() ? "yes":"no"));
+	writeResourceSettings(doc,pelem);
 }
 
 void ClustalO::readSettings(QDomDocument &doc)
@@ -70,6 +85,7 @@ void ClustalO::readSettings(QDomDocument &doc)
 			if (elem.tagName() == "name"){
 				if (elem.text() != name_)
 					break;
+				readResourceSettings(gNode);
 			}
 			if (elem.tagName() == "path"){
 				executable_=elem.text();
@@ -81,7 +97,7 @@ void ClustalO::readSettings(QDomDocument &doc)
 		}
 	}
 	
-	getVersion();
+	probeVersion(QStringList() << "--version",&ClustalO::parseVersion);
 	
 }
 
@@ -97,16 +113,8 @@ void ClustalO::init()
 	
 }
 
-void ClustalO::getVersion()
+QString ClustalO::parseVersion(const QByteArray &out,const QByteArray &)
 {
-	QProcess getver;
-	getver.start(executable_, QStringList() << "--version");
-	if (getver.waitForStarted()){
-		getver.waitForReadyRead();
-		getver.waitForFinished();
-		version_ = QString(getver.readAll());
-		version_=version_.trimmed();
-	}
-	qDebug() << trace.header(__PRETTY_FUNCTION__) << name_ << " " << version_;
+	return QString(out).trimmed();
 }
 
@@ -36,14 +36,17 @@ class ClustalO: public AlignmentTool
 		ClustalO();
 		~ClustalO();
 		
-		virtual void makeCommand(QString &, QString &, QString &, QStringList &);
+		virtual void makePipeCommand(QString &, QStringList &);
+		virtual bool makeAddCommand(const QString &,int,QString &, QStringList &);
+		virtual bool threaded(){return true;}
+		virtual ProgressParser *createProgressParser();
 		virtual void writeSettings(QDomDocument &,QDomElement &);
 		virtual void readSettings(QDomDocument &);
 		
 	private:
 	
 		void init();
-		void getVersion();
+		static QString parseVersion(const QByteArray &,const QByteArray &);
 		
 };
 
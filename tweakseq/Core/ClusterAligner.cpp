@@ -0,0 +1,395 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <QtDebug>
+#include "DebuggingInfo.h"
+
+#include <algorithm>
+
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QPair>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+
+#include "BufferedWriter.h"
+#include "ClusterAligner.h"
+#include "FASTAFile.h"
+#include "FASTAStreamParser.h"
+#include "ProgressiveAligner.h"
+#include "ToolProcess.h"
+
+#define PARTITION_SHARE 0.1 // of the run time, for reporting progress
+#define MERGE_SHARE 0.2
+#define TOOL_POLL 500 // ms, between checks for cancellation while a tool runs
+
+//
+//	Public members
+//	
+
+ClusterAligner::ClusterAligner(AlignmentTool *tool,int maxClusterSize)
+{
+	tool_=tool;
+	maxClusterSize_=qMax(2,maxClusterSize);
+	name_ = tool->name() + " in clusters of " + QString::number(maxClusterSize_);
+	version_ = tool->version();
+	executable_ = tool->executable();
+	usesStdOut_=false;
+	
+	// The command is made here, in the GUI thread, since the tool's settings may change while the job runs
+	toolThreads_ = qMax(1,tool->threads());
+	if (!tool->inProcess()){
+		tool->makePipeCommand(pipeExec_,pipeArgs_);
+		pipeArgs_.replaceInStrings("%threads",QString::number(toolThreads_));
+	}
+	memoryLimit_ = tool->memoryLimit();
+	niceLevel_ = tool->niceLevel();
+	
+	seqs_=NULL;
+	isDNA_=false;
+	k_=4;
+	seed_=seedIndex_=-1;
+	cancel_=NULL;
+	progress_=NULL;
+}
+
+ClusterAligner::~ClusterAligner()
+{
+}
+
+void ClusterAligner::makePipeCommand(QString &exec,QStringList &args)
+{
+	exec=pipeExec_;
+	args=pipeArgs_;
+}
+
+bool ClusterAligner::align(const QStringList &seqs,QStringList &aligned,QString &errmsg,QAtomicInt *cancel,QAtomicInt *progress)
+{
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << seqs.size() << "sequences" << name_;
+	
+	cancel_=cancel;
+	progress_=progress;
+	seqs_=&seqs;
+	aligned.clear();
+	if (seqs.size() < 2){
+		errmsg = "At least two sequences are needed";
+		return false;
+	}
+	
+	QElapsedTimer timer;
+	timer.start();
+	setProgress(0.0);
+	
+	PairwiseAligner::Scoring scoring = ProgressiveAligner::guessScoring(seqs);
+	isDNA_ = (scoring == PairwiseAligner::DNA);
+	k_ = isDNA_ ? 12 : 4;
+	
+	QList<Cluster> clusters;
+	partition(clusters);
+	qint64 tPartition = timer.elapsed();
+	if (cancelled()){
+		errmsg = "Cancelled";
+		return false;
+	}
+	setProgress(PARTITION_SHARE);
+	
+	// Each run of an external tool uses its own threads, so only as many clusters are aligned at once
+	// as fit in the job's threads
+	int nthreads = (threads_ > 0) ? threads_ : qMax(1,QThread::idealThreadCount());
+	QThreadPool pool;
+	pool.setMaxThreadCount(tool_->inProcess() ? nthreads : qMax(1,nthreads/toolThreads_));
+	seqsAligned_=0;
+	QList<QFuture<void> > runs;
+	for (int c=0;c<clusters.size();c++)
+		runs.append(QtConcurrent::run(&pool,alignCluster,&clusters[c]));
+	for (int r=0;r<runs.size();r++)
+		runs[r].waitForFinished();
+	qint64 tClusters = timer.elapsed();
+	if (cancelled()){
+		errmsg = "Cancelled";
+		return false;
+	}
+	
+	QList<QStringList> profiles;
+	for (int c=0;c<clusters.size();c++){
+		if (!clusters.at(c).ok){
+			errmsg = clusters.at(c).errmsg;
+			return false;
+		}
+		profiles.append(clusters.at(c).aligned);
+		clusters[c].aligned.clear();
+	}
+	
+	ProgressiveAligner pa(scoring);
+	pa.setProgressRange(1.0 - MERGE_SHARE,1.0);
+	QStringList merged;
+	if (!pa.mergeProfiles(profiles,merged,errmsg,cancel,progress))
+		return false;
+	
+	// Back to the input order
+	QVector<QString> out(seqs.size());
+	int r=0;
+	for (int c=0;c<clusters.size();c++){
+		const QVector<int> &members = clusters.at(c).members;
+		for (int m=0;m<members.size();m++)
+			out[members.at(m)] = merged.at(r++);
+	}
+	for (int s=0;s<out.size();s++)
+		aligned.append(out.at(s));
+	
+	seqs_=NULL;
+	qInfo() << benchmark.header(__PRETTY_FUNCTION__) << seqs.size() << "sequences" << clusters.size() << "clusters"
+		<< "partition" << tPartition << "ms" << "clusters" << tClusters - tPartition << "ms" << "total" << timer.elapsed() << "ms";
+	return true;
+}
+
+//
+//	Private members
+//	
+
+// Sorted k-mers of a sequence, without repeats
+void ClusterAligner::findKmers(Task &t)
+{
+	ClusterAligner *ca = t.aligner;
+	const QString &seq = ca->seqs_->at(t.index);
+	QVector<quint32> &km = ca->kmers_[t.index];
+	km.clear();
+	
+	// Nucleotides take 2 bits, other residues 5. Ambiguous nucleotides break the k-mer
+	int bits = ca->isDNA_ ? 2 : 5;
+	quint32 mask = (1u << (bits*ca->k_)) - 1;
+	quint32 h=0;
+	int len=0;
+	for (int i=0;i<seq.size();i++){
+		char c = seq.at(i).toUpper().toLatin1();
+		if (c == '-' || c == '.') continue;
+		quint32 code;
+		if (ca->isDNA_){
+			switch (c){
+				case 'A':code=0;break;
+				case 'C':code=1;break;
+				case 'G':code=2;break;
+				case 'T':case 'U':code=3;break;
+				default:len=0;continue;
+			}
+		}
+		else
+			code = (c - 'A') & 0x1F;
+		h = ((h << bits) | code) & mask;
+		if (++len >= ca->k_)
+			km.append(h);
+	}
+	std::sort(km.begin(),km.end());
+	km.erase(std::unique(km.begin(),km.end()),km.end());
+}
+
+// Updates a sequence's nearest seed with the current seed
+void ClusterAligner::seedDistance(Task &t)
+{
+	ClusterAligner *ca = t.aligner;
+	float d = kmerDistance(ca->kmers_.at(t.index),ca->kmers_.at(ca->seed_));
+	if (d < ca->nearestDist_.at(t.index)){
+		ca->nearestDist_[t.index]=d;
+		ca->nearestSeed_[t.index]=ca->seedIndex_;
+	}
+}
+
+// Runs on the cluster pool
+void ClusterAligner::alignCluster(Cluster *cl)
+{
+	Cluster &c = *cl;
+	ClusterAligner *ca = c.aligner;
+	c.ok=false;
+	if (ca->cancelled()) return;
+	
+	QStringList seqs;
+	for (int m=0;m<c.members.size();m++)
+		seqs.append(ca->seqs_->at(c.members.at(m)));
+	
+	if (seqs.size() == 1){ // nothing to align
+		c.aligned=seqs;
+		c.ok=true;
+	}
+	else if (ca->tool_->inProcess())
+		c.ok = ca->tool_->align(seqs,c.aligned,c.errmsg,ca->cancel_,NULL);
+	else
+		c.ok = ca->runTool(seqs,c.aligned,c.errmsg);
+	
+	int done = ca->seqsAligned_.fetchAndAddOrdered(seqs.size()) + seqs.size();
+	ca->setProgress(PARTITION_SHARE + (1.0 - PARTITION_SHARE - MERGE_SHARE)*done/ca->seqs_->size());
+}
+
+// The fraction of k-mers not shared, relative to the smaller set
+float ClusterAligner::kmerDistance(const QVector<quint32> &ki,const QVector<quint32> &kj)
+{
+	int shared=0;
+	int a=0,b=0;
+	while (a < ki.size() && b < kj.size()){
+		if (ki.at(a) < kj.at(b))
+			a++;
+		else if (kj.at(b) < ki.at(a))
+			b++;
+		else{
+			shared++;
+			a++;
+			b++;
+		}
+	}
+	int nmin = qMin(ki.size(),kj.size());
+	return (nmin > 0) ? 1.0 - (float) shared/nmin : 1.0;
+}
+
+// Picks one seed per cluster, each as far as possible from the seeds before it, so that every sequence
+// is compared with the seeds only. Each sequence goes to its nearest seed, and clusters which are still
+// too big are split, keeping the sequences closest to the seed together
+void ClusterAligner::partition(QList<Cluster> &clusters)
+{
+	int n = seqs_->size();
+	int nseeds = (n + maxClusterSize_ - 1)/maxClusterSize_;
+	
+	QVector<Task> tasks(n);
+	for (int s=0;s<n;s++){
+		tasks[s].aligner=this;
+		tasks[s].index=s;
+	}
+	kmers_.resize(n);
+	QtConcurrent::blockingMap(tasks,findKmers);
+	
+	nearestDist_.fill(2.0,n);
+	nearestSeed_.fill(0,n);
+	
+	// The first seed is the longest sequence
+	int next=0;
+	for (int s=1;s<n;s++){
+		if (seqs_->at(s).size() > seqs_->at(next).size())
+			next=s;
+	}
+	for (int sd=0;sd<nseeds && !cancelled();sd++){
+		seed_=next;
+		seedIndex_=sd;
+		QtConcurrent::blockingMap(tasks,seedDistance);
+		for (int s=0;s<n;s++){
+			if (nearestDist_.at(s) > nearestDist_.at(next))
+				next=s;
+		}
+		setProgress(PARTITION_SHARE*(sd+1)/nseeds);
+	}
+	kmers_.clear();
+	
+	QVector<QVector<int> > members(nseeds);
+	for (int s=0;s<n;s++)
+		members[nearestSeed_.at(s)].append(s);
+	
+	clusters.clear();
+	for (int sd=0;sd<nseeds;sd++){
+		QVector<int> &m = members[sd];
+		if (m.isEmpty()) continue;
+		if (m.size() > maxClusterSize_){
+			QVector<QPair<float,int> > byDist;
+			for (int i=0;i<m.size();i++)
+				byDist.append(qMakePair(nearestDist_.at(m.at(i)),m.at(i)));
+			std::sort(byDist.begin(),byDist.end());
+			for (int i=0;i<m.size();i++)
+				m[i]=byDist.at(i).second;
+		}
+		for (int start=0;start<m.size();start+=maxClusterSize_){
+			Cluster c;
+			c.aligner=this;
+			c.members = m.mid(start,maxClusterSize_);
+			c.ok=false;
+			clusters.append(c);
+		}
+	}
+	nearestDist_.clear();
+	nearestSeed_.clear();
+	
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << n << "sequences" << nseeds << "seeds" << clusters.size() << "clusters";
+}
+
+// Aligns a cluster with the external tool, in this thread
+bool ClusterAligner::runTool(const QStringList &seqs,QStringList &aligned,QString &errmsg)
+{
+	ToolProcess proc;
+	proc.setMemoryLimit(memoryLimit_);
+	proc.setNiceLevel(niceLevel_);
+	proc.setStandardErrorFile(QProcess::nullDevice());
+	proc.start(pipeExec_,pipeArgs_);
+	if (!proc.waitForStarted(-1)){
+		errmsg = "Failed to start " + pipeExec_;
+		return false;
+	}
+	
+	// The labels are the row numbers, so that the output can be put back in order
+	FASTAFile ff;
+	BufferedWriter bw(&proc);
+	for (int s=0;s<seqs.size();s++)
+		ff.writeRecord(bw,QString::number(s),seqs.at(s),"");
+	bw.flush();
+	proc.closeWriteChannel(); // once the input has all been written
+	
+	FASTAStreamParser output;
+	while (!proc.waitForFinished(TOOL_POLL) && proc.state() != QProcess::NotRunning){
+		output.addData(proc.readAllStandardOutput());
+		if (cancelled()){
+			proc.kill();
+			proc.waitForFinished(-1);
+			errmsg = "Cancelled";
+			return false;
+		}
+	}
+	output.addData(proc.readAllStandardOutput());
+	output.finish();
+	
+	if (proc.exitStatus() != QProcess::NormalExit || proc.exitCode() != 0 || output.size() != seqs.size()){
+		errmsg = tool_->name() + " failed on a cluster of " + QString::number(seqs.size()) + " sequences";
+		if (memoryLimit_ > 0)
+			errmsg += " (it may have run out of memory, the limit is " + QString::number(memoryLimit_) + " MB)";
+		return false;
+	}
+	
+	QVector<QString> rows(seqs.size());
+	for (int r=0;r<output.size();r++){
+		bool ok;
+		int s = output.labels().at(r).toInt(&ok);
+		if (!ok || s < 0 || s >= rows.size() || !rows.at(s).isNull()){
+			errmsg = tool_->name() + " returned an unexpected sequence " + output.labels().at(r);
+			return false;
+		}
+		rows[s] = output.sequences().at(r);
+	}
+	aligned.clear();
+	for (int s=0;s<rows.size();s++)
+		aligned.append(rows.at(s));
+	return true;
+}
+
+void ClusterAligner::setProgress(double f)
+{
+	if (progress_ != NULL)
+		progress_->store(qRound(f*1000.0));
+}
@@ -0,0 +1,108 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef __CLUSTER_ALIGNER_H_
+#define __CLUSTER_ALIGNER_H_
+
+#include <QAtomicInt>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "AlignmentTool.h"
+
+#define DEFAULT_CLUSTER_SIZE 1000
+
+// Divide-and-conquer alignment, for sets of sequences too large to align in one run of a tool.
+// The sequences are partitioned into clusters of bounded size by k-mer similarity, using farthest-first seeds,
+// each cluster is aligned with another tool, concurrently, and the cluster alignments are then merged
+// by profile-profile alignment. The whole pipeline runs in-process, as one job; an external tool
+// is run once for each cluster, with as many runs at once as the job's threads allow.
+
+class ClusterAligner: public AlignmentTool
+{
+	public:
+		
+		ClusterAligner(AlignmentTool *,int maxClusterSize=DEFAULT_CLUSTER_SIZE);
+		~ClusterAligner();
+		
+		int maxClusterSize(){return maxClusterSize_;}
+		
+		virtual void makePipeCommand(QString &, QStringList &); // the cluster tool's command
+		
+		virtual bool inProcess(){return true;}
+		virtual bool threaded(){return true;}
+		virtual int qualityTier(){return Draft;} // the merge only sees cluster profiles
+		virtual bool align(const QStringList &,QStringList &,QString &,QAtomicInt *,QAtomicInt *);
+		
+	private:
+		
+		struct Task
+		{
+			ClusterAligner *aligner;
+			int index;
+		};
+		
+		struct Cluster
+		{
+			ClusterAligner *aligner;
+			QVector<int> members;
+			QStringList aligned;
+			QString errmsg;
+			bool ok;
+		};
+		
+		static void findKmers(Task &);
+		static void seedDistance(Task &);
+		static void alignCluster(Cluster *);
+		static float kmerDistance(const QVector<quint32> &,const QVector<quint32> &);
+		
+		void partition(QList<Cluster> &);
+		bool runTool(const QStringList &,QStringList &,QString &);
+		bool cancelled(){return cancel_ != NULL && cancel_->load() != 0;}
+		void setProgress(double);
+		
+		AlignmentTool *tool_;
+		int maxClusterSize_;
+		QString pipeExec_;
+		QStringList pipeArgs_;
+		int toolThreads_; // for each run of the tool
+		
+		const QStringList *seqs_;
+		bool isDNA_;
+		int k_;
+		QVector<QVector<quint32> > kmers_;
+		QVector<float> nearestDist_; // to the seeds
+		QVector<int> nearestSeed_;
+		int seed_,seedIndex_; // the current seed, for the workers
+		
+		QAtomicInt *cancel_;
+		QAtomicInt *progress_; // per mille
+		QAtomicInt seqsAligned_;
+};
+
+#endif
@@ -0,0 +1,321 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <QtDebug>
+#include "DebuggingInfo.h"
+
+#include <cstring>
+
+#include <QFileInfo>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include "CompressedDevice.h"
+
+#define GZIP_OUT_SIZE 262144
+#define BGZF_BLOCK_SIZE 0xff00 // input per block, as used by bgzip
+#define BGZF_MAX_BLOCK_SIZE 65536
+#define ZSTD_LEVEL 3 // zstd's default
+#define ZSTD_UNAVAILABLE "zstd compression is not available in this build"
+
+// A BGZF block with no data marks the end of the file
+static const char BGZF_EOF[28] = {
+	'\x1f','\x8b','\x08','\x04','\0','\0','\0','\0','\0','\xff','\x06','\0','\x42','\x43','\x02','\0',
+	'\x1b','\0','\x03','\0','\0','\0','\0','\0','\0','\0','\0','\0'};
+
+//
+//	Public members
+//	
+
+CompressedDevice::CompressedDevice(QIODevice *dev,Format format):QIODevice()
+{
+	dev_=dev;
+	format_=format;
+	ok_=true;
+	finished_=false;
+	zsInitialized_=false;
+	memset(&zs_,0,sizeof(zs_));
+	
+	// Enough blocks to keep all the threads busy
+	batchBytes_ = BGZF_BLOCK_SIZE * qMax(1,QThreadPool::globalInstance()->maxThreadCount()) * 4;
+	
+#ifdef HAVE_ZSTD
+	zc_=NULL;
+#endif
+}
+
+CompressedDevice::~CompressedDevice()
+{
+	if (zsInitialized_)
+		deflateEnd(&zs_);
+#ifdef HAVE_ZSTD
+	if (zc_ != NULL)
+		ZSTD_freeCCtx(zc_);
+#endif
+}
+
+CompressedDevice::Format CompressedDevice::formatForFile(const QString &fname)
+{
+	QString suffix = QFileInfo(fname).suffix().toLower();
+	if (suffix == "gz")
+		return Gzip;
+	if (suffix == "bgz")
+		return BGZF;
+	if (suffix == "zst")
+		return Zstd;
+	return None;
+}
+
+// Compressed output must not have line endings translated
+QIODevice::OpenMode CompressedDevice::fileOpenMode(Format format)
+{
+	if (format == None)
+		return QIODevice::WriteOnly | QIODevice::Text;
+	return QIODevice::WriteOnly;
+}
+
+bool CompressedDevice::available(Format format,QString &errmsg)
+{
+	if (format == Zstd){
+#ifndef HAVE_ZSTD
+		errmsg = ZSTD_UNAVAILABLE;
+		return false;
+#endif
+	}
+	return true;
+}
+
+bool CompressedDevice::open(OpenMode mode)
+{
+	if (mode & QIODevice::ReadOnly){
+		setErrorString("CompressedDevice is write only");
+		return false;
+	}
+	
+	if (format_ == Gzip){
+		// windowBits of 15+16 gives a gzip header and trailer
+		if (deflateInit2(&zs_,Z_DEFAULT_COMPRESSION,Z_DEFLATED,15+16,8,Z_DEFAULT_STRATEGY) != Z_OK){
+			setErrorString("Couldn't initialize compression");
+			return false;
+		}
+		zsInitialized_=true;
+		out_.resize(GZIP_OUT_SIZE);
+	}
+	else if (format_ == BGZF)
+		pending_.reserve(batchBytes_);
+	else if (format_ == Zstd){
+#ifdef HAVE_ZSTD
+		zc_ = ZSTD_createCCtx();
+		if (zc_ == NULL){
+			setErrorString("Couldn't initialize compression");
+			return false;
+		}
+		ZSTD_CCtx_setParameter(zc_,ZSTD_c_compressionLevel,ZSTD_LEVEL);
+		// Fails harmlessly if libzstd was built without threading, and compression is then single-threaded
+		ZSTD_CCtx_setParameter(zc_,ZSTD_c_nbWorkers,QThread::idealThreadCount());
+		out_.resize(ZSTD_CStreamOutSize());
+#else
+		setErrorString(ZSTD_UNAVAILABLE);
+		ok_=false;
+		return false;
+#endif
+	}
+	
+	return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+// Flushes any compressed data and writes the end of the stream
+bool CompressedDevice::finish()
+{
+	if (finished_) return ok_;
+	finished_=true;
+	
+	switch (format_){
+		case Gzip:
+			ok_ = ok_ && deflateGzip(NULL,0,Z_FINISH);
+			break;
+		case BGZF:
+			ok_ = ok_ && compressBGZFBlocks(true);
+			if (ok_ && dev_->write(BGZF_EOF,sizeof(BGZF_EOF)) != sizeof(BGZF_EOF))
+				ok_=false;
+			break;
+		case Zstd:
+			ok_ = ok_ && compressZstd(NULL,0,true);
+			break;
+		default:
+			break;
+	}
+	return ok_;
+}
+
+//
+//	Protected members
+//	
+
+qint64 CompressedDevice::readData(char *,qint64)
+{
+	return -1;
+}
+
+qint64 CompressedDevice::writeData(const char *data,qint64 len)
+{
+	if (!ok_ || finished_) return -1;
+	
+	switch (format_){
+		case Gzip:
+			ok_ = deflateGzip(data,len,Z_NO_FLUSH);
+			break;
+		case BGZF:
+			pending_.append(data,len);
+			if (pending_.size() >= batchBytes_)
+				ok_ = compressBGZFBlocks(false);
+			break;
+		case Zstd:
+			ok_ = compressZstd(data,len,false);
+			break;
+		default:
+			ok_ = (dev_->write(data,len) == len);
+			break;
+	}
+	return ok_ ? len : -1;
+}
+
+//
+//	Private members
+//	
+
+bool CompressedDevice::deflateGzip(const char *data,qint64 len,int flush)
+{
+	zs_.next_in = (Bytef *) data;
+	zs_.avail_in = (uInt) len;
+	int ret;
+	do {
+		zs_.next_out = (Bytef *) out_.data();
+		zs_.avail_out = out_.size();
+		ret = deflate(&zs_,flush);
+		if (ret == Z_STREAM_ERROR){
+			setErrorString("Compression failed");
+			return false;
+		}
+		qint64 nout = out_.size() - zs_.avail_out;
+		if (nout > 0 && dev_->write(out_.constData(),nout) != nout)
+			return false;
+	} while (zs_.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+	return true;
+}
+
+// The frame is ended on the last call
+bool CompressedDevice::compressZstd(const char *data,qint64 len,bool last)
+{
+#ifdef HAVE_ZSTD
+	ZSTD_inBuffer in = {data,(size_t) len,0};
+	ZSTD_EndDirective mode = last ? ZSTD_e_end : ZSTD_e_continue;
+	size_t remaining;
+	do {
+		ZSTD_outBuffer out = {out_.data(),(size_t) out_.size(),0};
+		remaining = ZSTD_compressStream2(zc_,&out,&in,mode);
+		if (ZSTD_isError(remaining)){
+			setErrorString(QString("Compression failed: ") + ZSTD_getErrorName(remaining));
+			return false;
+		}
+		if (out.pos > 0 && dev_->write(out_.constData(),out.pos) != (qint64) out.pos)
+			return false;
+	} while (last ? remaining != 0 : in.pos < in.size);
+	return true;
+#else
+	Q_UNUSED(data);
+	Q_UNUSED(len);
+	Q_UNUSED(last);
+	return false;
+#endif
+}
+
+// Compresses whole blocks of pending input in parallel, and writes them in order
+// A partial block at the end is kept back unless this is the last call
+bool CompressedDevice::compressBGZFBlocks(bool last)
+{
+	QList<QByteArray> blocks;
+	int pos=0;
+	while (pending_.size() - pos >= BGZF_BLOCK_SIZE || (last && pos < pending_.size())){
+		int n = qMin(BGZF_BLOCK_SIZE,pending_.size() - pos);
+		blocks.append(pending_.mid(pos,n));
+		pos += n;
+	}
+	pending_.remove(0,pos);
+	
+	if (blocks.isEmpty()) return true;
+	
+	QList<QByteArray> compressed = QtConcurrent::blockingMapped(blocks,compressBGZFBlock);
+	for (int b=0;b<compressed.size();b++){
+		const QByteArray &cb = compressed.at(b);
+		if (cb.isEmpty()){
+			setErrorString("Compression failed");
+			return false;
+		}
+		if (dev_->write(cb) != cb.size())
+			return false;
+	}
+	return true;
+}
+
+// Returns an empty array on failure
+QByteArray CompressedDevice::compressBGZFBlock(const QByteArray &in)
+{
+	QByteArray block(BGZF_MAX_BLOCK_SIZE,0);
+	unsigned char *b = (unsigned char *) block.data();
+	
+	// gzip header with the BC extra field, which holds the block size
+	const unsigned char header[18] = {0x1f,0x8b,0x08,0x04,0,0,0,0,0,0xff,0x06,0,'B','C',0x02,0,0,0};
+	memcpy(b,header,18);
+	
+	z_stream zs;
+	memset(&zs,0,sizeof(zs));
+	if (deflateInit2(&zs,Z_DEFAULT_COMPRESSION,Z_DEFLATED,-15,8,Z_DEFAULT_STRATEGY) != Z_OK) // raw deflate
+		return QByteArray();
+	zs.next_in = (Bytef *) in.constData();
+	zs.avail_in = in.size();
+	zs.next_out = b + 18;
+	zs.avail_out = BGZF_MAX_BLOCK_SIZE - 18 - 8;
+	int ret = deflate(&zs,Z_FINISH);
+	int clen = BGZF_MAX_BLOCK_SIZE - 18 - 8 - zs.avail_out;
+	deflateEnd(&zs);
+	if (ret != Z_STREAM_END)
+		return QByteArray();
+	
+	int bsize = 18 + clen + 8;
+	b[16] = (bsize-1) & 0xff;
+	b[17] = ((bsize-1) >> 8) & 0xff;
+	
+	unsigned long crc = crc32(0L,(const Bytef *) in.constData(),in.size());
+	unsigned char *t = b + 18 + clen;
+	for (int i=0;i<4;i++) t[i] = (crc >> (8*i)) & 0xff;
+	unsigned int isize = in.size();
+	for (int i=0;i<4;i++) t[4+i] = (isize >> (8*i)) & 0xff;
+	
+	block.truncate(bsize);
+	return block;
+}
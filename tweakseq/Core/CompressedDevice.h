@@ -0,0 +1,97 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef __COMPRESSED_DEVICE_H_
+#define __COMPRESSED_DEVICE_H_
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QList>
+
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+// A write-only device which compresses its output on to another device
+// The format is chosen from the file extension:
+//   .gz  : gzip (single stream)
+//   .bgz : BGZF, as written by bgzip. Blocks are independent so these are compressed in parallel
+//   .zst : zstd, compressed with libzstd's worker threads. Only if built with libzstd (HAVE_ZSTD)
+// Any other extension is passed through uncompressed.
+// finish() must be called after the last write.
+
+class CompressedDevice:public QIODevice
+{
+	Q_OBJECT
+	
+	public:
+		
+		enum Format {None,Gzip,BGZF,Zstd};
+		
+		CompressedDevice(QIODevice *,Format);
+		~CompressedDevice();
+		
+		static Format formatForFile(const QString &);
+		static OpenMode fileOpenMode(Format);
+		static bool available(Format,QString &); // so the target isn't opened for output that can't be written
+		
+		Format format(){return format_;}
+		
+		virtual bool open(OpenMode);
+		virtual bool isSequential() const {return true;}
+		
+		bool finish();
+		
+	protected:
+		
+		virtual qint64 readData(char *,qint64);
+		virtual qint64 writeData(const char *,qint64);
+		
+	private:
+		
+		bool deflateGzip(const char *,qint64,int);
+		bool compressBGZFBlocks(bool);
+		static QByteArray compressBGZFBlock(const QByteArray &);
+		bool compressZstd(const char *,qint64,bool);
+		
+		QIODevice *dev_;
+		Format format_;
+		bool ok_,finished_;
+		
+		z_stream zs_;
+		bool zsInitialized_;
+		QByteArray out_;
+		
+		QByteArray pending_; // BGZF input not yet compressed
+		int batchBytes_;
+		
+#ifdef HAVE_ZSTD
+		ZSTD_CCtx *zc_;
+#endif
+};
+
+#endif
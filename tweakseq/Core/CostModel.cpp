@@ -0,0 +1,184 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <cmath>
+
+#include <QList>
+#include <QtDebug>
+#include "DebuggingInfo.h"
+
+#include "CostModel.h"
+#include "RunHistory.h"
+
+// Typical exponents of N and L, towards which the fits are pulled
+#define TIME_EXPONENT_N 1.5
+#define TIME_EXPONENT_L 1.5
+#define MEMORY_EXPONENT_N 1.0
+#define MEMORY_EXPONENT_L 1.0
+#define RIDGE 0.5 // the weight of the prior exponents, comparable to one run
+
+//
+//	Public members
+//	
+
+CostModel::CostModel()
+{
+}
+
+CostModel::~CostModel()
+{
+}
+
+void CostModel::fit(RunHistory &history)
+{
+	fits_.clear();
+	
+	// Successful runs only: a failed or cancelled run says little about the cost of finishing
+	QHash<QString,QList<int> > toolRuns;
+	for (int i=0;i<history.size();i++){
+		const RunRecord &r = history.at(i);
+		if (!r.ok || r.nseqs < 2 || r.residues < 1 || r.usage.wall <= 0) continue;
+		toolRuns[r.tool].append(i);
+	}
+	
+	QHashIterator<QString,QList<int> > it(toolRuns);
+	while (it.hasNext()){
+		it.next();
+		const QList<int> &runs = it.value();
+		QVector<double> lnN,lnL,lnT,memN,memL,lnM;
+		for (int i=0;i<runs.size();i++){
+			const RunRecord &r = history.at(runs.at(i));
+			double n = log((double) r.nseqs);
+			double l = log((double) r.residues/r.nseqs);
+			lnN.append(n);
+			lnL.append(l);
+			lnT.append(log(r.usage.wall/1000.0));
+			if (r.usage.peakRSS > 0){
+				memN.append(n);
+				memL.append(l);
+				lnM.append(log(r.usage.peakRSS/1024.0));
+			}
+		}
+		Fit f;
+		f.runs = runs.size();
+		f.memoryRuns = lnM.size();
+		fitLogLinear(lnN,lnL,lnT,TIME_EXPONENT_N,TIME_EXPONENT_L,f.time);
+		if (f.memoryRuns > 0)
+			fitLogLinear(memN,memL,lnM,MEMORY_EXPONENT_N,MEMORY_EXPONENT_L,f.memory);
+		fits_.insert(it.key(),f);
+		qDebug() << trace.header(__PRETTY_FUNCTION__) << it.key() << f.runs << "runs, time" 
+			<< f.time[0] << f.time[1] << f.time[2];
+	}
+}
+
+int CostModel::numRuns(const QString &tool)
+{
+	if (!fits_.contains(tool)) return 0;
+	return fits_.value(tool).runs;
+}
+
+bool CostModel::predict(const QString &tool,int nseqs,double meanLength,double &seconds,double &mb)
+{
+	if (!fits_.contains(tool) || nseqs < 1 || meanLength <= 0.0) return false;
+	
+	const Fit &f = fits_[tool];
+	double n = log((double) nseqs);
+	double l = log(meanLength);
+	seconds = exp(f.time[0] + f.time[1]*n + f.time[2]*l);
+	if (f.memoryRuns > 0)
+		mb = exp(f.memory[0] + f.memory[1]*n + f.memory[2]*l);
+	else
+		mb = -1.0;
+	return true;
+}
+
+QString CostModel::formatCost(double seconds,double mb)
+{
+	qint64 t = qRound64(seconds + 0.5);
+	QString txt = QString("%1:%2").arg((t/60) % 60).arg(t % 60,2,10,QChar('0'));
+	if (t >= 3600)
+		txt = QString("%1:%2").arg(t/3600).arg(txt.rightJustified(5,'0'));
+	if (mb >= 0.0)
+		txt += ", " + QString::number(qRound64(mb)) + " MB";
+	return txt;
+}
+
+//
+//	Private members
+//	
+
+// Least squares fit of y = c0 + c1 x1 + c2 x2, with a ridge penalty pulling c1 and c2 towards the priors.
+// The penalty also keeps the normal equations solvable when all the runs are the same size.
+void CostModel::fitLogLinear(const QVector<double> &x1,const QVector<double> &x2,const QVector<double> &y,
+	double prior1,double prior2,double coeffs[])
+{
+	double a[3][4]; // augmented normal equations
+	for (int i=0;i<3;i++)
+		for (int j=0;j<4;j++)
+			a[i][j]=0.0;
+	
+	for (int k=0;k<y.size();k++){
+		double x[3] = {1.0,x1.at(k),x2.at(k)};
+		for (int i=0;i<3;i++){
+			for (int j=0;j<3;j++)
+				a[i][j] += x[i]*x[j];
+			a[i][3] += x[i]*y.at(k);
+		}
+	}
+	a[1][1] += RIDGE; a[1][3] += RIDGE*prior1;
+	a[2][2] += RIDGE; a[2][3] += RIDGE*prior2;
+	
+	// Gaussian elimination, with partial pivoting
+	for (int c=0;c<3;c++){
+		int pivot=c;
+		for (int r=c+1;r<3;r++)
+			if (fabs(a[r][c]) > fabs(a[pivot][c])) pivot=r;
+		if (pivot != c){
+			for (int j=0;j<4;j++){
+				double tmp=a[c][j];
+				a[c][j]=a[pivot][j];
+				a[pivot][j]=tmp;
+			}
+		}
+		if (fabs(a[c][c]) < 1.0E-12){ // no data: fall back to the priors, through the origin
+			coeffs[0]=0.0;
+			coeffs[1]=prior1;
+			coeffs[2]=prior2;
+			return;
+		}
+		for (int r=c+1;r<3;r++){
+			double f = a[r][c]/a[c][c];
+			for (int j=c;j<4;j++)
+				a[r][j] -= f*a[c][j];
+		}
+	}
+	for (int r=2;r>=0;r--){
+		double s=a[r][3];
+		for (int j=r+1;j<3;j++)
+			s -= a[r][j]*coeffs[j];
+		coeffs[r]=s/a[r][r];
+	}
+}
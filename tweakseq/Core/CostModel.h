@@ -0,0 +1,80 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef __COST_MODEL_H_
+#define __COST_MODEL_H_
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+#include "AlignmentTool.h"
+
+class RunHistory;
+
+// Limits on an alignment run, used to choose a tool and to warn before a run
+struct AlignmentBudget
+{
+	AlignmentBudget():seconds(0),mb(0),tier(AlignmentTool::Standard){}
+	int seconds; // 0 for no limit
+	int mb; // 0 for no limit
+	int tier; // the lowest acceptable quality tier
+};
+
+// Predicts the wall time and peak memory of a run of each tool, from the number of sequences N
+// and their mean length L, by fitting ln(cost) = a + b ln(N) + c ln(L) to the tool's recorded runs.
+// The exponents are pulled towards typical values for progressive alignment, so that a tool
+// with only a few runs, on inputs of similar size, still extrapolates sensibly.
+
+class CostModel
+{
+	public:
+		
+		CostModel();
+		~CostModel();
+		
+		void fit(RunHistory &);
+		
+		int numRuns(const QString &); // the runs the tool's fit is based on
+		bool predict(const QString &,int,double,double &,double &); // tool, N, L -> seconds, MB (-1 if unknown)
+		
+		static QString formatCost(double,double); // eg "2:05, 350 MB"
+		
+	private:
+		
+		struct Fit
+		{
+			int runs,memoryRuns;
+			double time[3],memory[3];
+		};
+		
+		static void fitLogLinear(const QVector<double> &,const QVector<double> &,const QVector<double> &,
+			double,double,double []);
+		
+		QHash<QString,Fit> fits_;
+};
+
+#endif
@@ -79,5 +79,6 @@ class DebuggingInfo
 extern DebuggingInfo trace;
 extern DebuggingInfo warning;
 extern DebuggingInfo fixme;
+extern DebuggingInfo benchmark;
 
 #endif
\ No newline at end of file
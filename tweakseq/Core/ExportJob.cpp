@@ -0,0 +1,257 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <QtDebug>
+#include "DebuggingInfo.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QSaveFile>
+#include <QStringList>
+#include <QtConcurrentRun>
+
+#include "A3MFile.h"
+#include "BufferedWriter.h"
+#include "ClustalFile.h"
+#include "CompressedDevice.h"
+#include "ExportJob.h"
+#include "FASTAFile.h"
+#include "Project.h"
+#include "Sequence.h"
+
+//
+//	Public members
+//	
+
+ExportJob::ExportJob(const QString &fname,int format,bool removeExclusions,QObject *parent):QObject(parent)
+{
+	fname_=fname;
+	format_=format;
+	removeExclusions_=removeExclusions;
+	lineWidth_=0;
+	cancelled_=0;
+	progressStep_=1;
+	lastProgress_=0;
+	connect(&watcher_,SIGNAL(finished()),this,SLOT(workerFinished()));
+}
+
+ExportJob::~ExportJob()
+{
+	cancel();
+	wait();
+}
+
+void ExportJob::addRecord(const QString &label,const QString &residues,const QString &comment)
+{
+	Record r;
+	r.label=label;
+	r.residues=residues;
+	r.comment=comment;
+	records_.append(r);
+}
+
+void ExportJob::start()
+{
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << fname_ << records_.size() << "sequences";
+	cancelled_=0;
+	err_="";
+	progressStep_ = qMax(1,records_.size()/100); // progress is reported in 1% steps
+	lastProgress_ = 0;
+	watcher_.setFuture(QtConcurrent::run(this,&ExportJob::run));
+}
+
+void ExportJob::cancel()
+{
+	cancelled_=1;
+}
+
+void ExportJob::wait()
+{
+	watcher_.waitForFinished();
+}
+
+bool ExportJob::isRunning()
+{
+	return watcher_.isRunning();
+}
+
+//
+//	Private slots
+//	
+
+void ExportJob::workerFinished()
+{
+	bool ok = watcher_.result();
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << "ok=" << ok << "cancelled=" << cancelled();
+	emit finished(ok);
+}
+
+//
+//	Private members
+//	
+
+// Runs on the worker thread
+bool ExportJob::run()
+{
+	QElapsedTimer timer;
+	timer.start();
+	
+	// Output is compressed if the extension asks for it
+	CompressedDevice::Format compression = CompressedDevice::formatForFile(fname_);
+	if (!CompressedDevice::available(compression,err_))
+		return false;
+	QSaveFile f(fname_);
+	if (!f.open(CompressedDevice::fileOpenMode(compression))){
+		err_ = "Couldn't open file";
+		return false;
+	}
+	
+	CompressedDevice cd(&f,compression);
+	if (!cd.open(QIODevice::WriteOnly)){
+		f.cancelWriting();
+		err_ = cd.errorString();
+		return false;
+	}
+	BufferedWriter bw(&cd);
+	bool ok=false;
+	switch (format_){
+		case FASTA:ok = writeFASTA(bw);break;
+		case CLUSTALW:ok = writeClustalW(bw);break;
+		case A3M:ok = writeA3M(bw);break;
+		default:err_="Unknown export format";break;
+	}
+	
+	if (ok && !cancelled())
+		ok = bw.flush() && cd.finish();
+	
+	if (!ok || cancelled()){
+		f.cancelWriting(); // the target is left untouched
+		if (cancelled())
+			err_="Export cancelled";
+		else if (err_.isEmpty())
+			err_="Error while writing file";
+		return false;
+	}
+	
+	if (!f.commit()){
+		err_="Error while writing file";
+		return false;
+	}
+	
+	qint64 ms = timer.elapsed();
+	qInfo() << benchmark.header(__PRETTY_FUNCTION__) << records_.size() << "sequences" << bw.bytesWritten() << "bytes" << ms << "ms"
+		<< (ms > 0 ? bw.bytesWritten()/(1048.576*ms) : 0.0) << "MB/s";
+	return true;
+}
+
+bool ExportJob::writeFASTA(BufferedWriter &bw)
+{
+	FASTAFile ff(fname_);
+	ff.setLineWidth(lineWidth_);
+	for (int i=0;i<records_.size();i++){
+		if (cancelled()) return false;
+		const Record &r = records_.at(i);
+		ff.writeRecord(bw,r.label,r.residues,r.comment,removeExclusions_);
+		if (!bw.ok()) return false;
+		reportProgress(i+1);
+	}
+	return true;
+}
+
+bool ExportJob::writeClustalW(BufferedWriter &bw)
+{
+	ClustalFile cf(fname_);
+	cf.setLineWidth(lineWidth_);
+	
+	// Blocks interleave all of the sequences, so the filtered sequences are needed up front
+	QStringList s;
+	QList<QByteArray> labels;
+	int maxseqlen=0,maxlablen=0;
+	for (int i=0;i<records_.size();i++){
+		if (cancelled()) return false;
+		s.append(filter(records_.at(i).residues));
+		labels.append(records_.at(i).label.toLocal8Bit());
+		maxseqlen = qMax(maxseqlen,s.last().size());
+		maxlablen = qMax(maxlablen,labels.last().size());
+	}
+	maxlablen += 3;
+	
+	int lw = cf.lineWidth();
+	int nblks = maxseqlen/lw;
+	if (nblks*lw < maxseqlen) nblks++;
+	
+	// Progress is counted in blocks here
+	progressStep_ = qMax(1,nblks/100);
+	cf.writeHeader(bw);
+	for (int b=0;b<nblks;b++){
+		if (cancelled()) return false;
+		cf.writeBlock(bw,labels,s,b,maxlablen);
+		if (!bw.ok()) return false;
+		if ((b+1) % progressStep_ == 0 || b+1 == nblks)
+			emit progress(b+1,nblks);
+	}
+	return true;
+}
+
+bool ExportJob::writeA3M(BufferedWriter &bw)
+{
+	if (records_.isEmpty()) return true;
+	
+	// The first sequence is used as the master sequence
+	A3MFile af(fname_);
+	QString master = filter(records_.at(0).residues);
+	for (int i=0;i<records_.size();i++){
+		if (cancelled()) return false;
+		const Record &r = records_.at(i);
+		af.writeRecord(bw,r.label,(i==0 ? master : filter(r.residues)),r.comment,master);
+		if (!bw.ok()) return false;
+		reportProgress(i+1);
+	}
+	return true;
+}
+
+// As for Sequence::filter()
+QString ExportJob::filter(const QString &residues)
+{
+	if (!removeExclusions_) return residues; // flags are stripped by the writer
+	QString r;
+	r.reserve(residues.size());
+	for (int i=0;i<residues.size();i++){
+		QChar qch=residues.at(i);
+		if (qch.unicode() & EXCLUDE_CELL)
+			continue;
+		r.append(QChar(qch.unicode() & REMOVE_FLAGS));
+	}
+	return r;
+}
+
+void ExportJob::reportProgress(int n)
+{
+	if (n - lastProgress_ >= progressStep_ || n == records_.size()){
+		lastProgress_=n;
+		emit progress(n,records_.size());
+	}
+}
@@ -0,0 +1,103 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef __EXPORT_JOB_H_
+#define __EXPORT_JOB_H_
+
+#include <QAtomicInt>
+#include <QFutureWatcher>
+#include <QList>
+#include <QObject>
+#include <QString>
+
+class BufferedWriter;
+
+// Writes an alignment to file on a worker thread
+// The job works from a snapshot of the sequences, taken when it is created.
+// QString is implicitly shared, so the snapshot is cheap and later edits in the
+// editor do not affect it.
+// Output goes to a temporary file which only replaces the target if the export
+// completes, so cancelling leaves no partial file.
+
+class ExportJob:public QObject
+{
+	Q_OBJECT
+	
+	public:
+		
+		struct Record{
+			QString label,residues,comment;
+		};
+		
+		ExportJob(const QString &,int,bool,QObject *parent=NULL);
+		~ExportJob();
+		
+		void addRecord(const QString &,const QString &,const QString &);
+		void setLineWidth(int w){lineWidth_=w;} // residues per line, 0 for the format's default
+		
+		void start();
+		void cancel();
+		void wait();
+		
+		bool isRunning();
+		bool cancelled(){return cancelled_.load() != 0;}
+		
+		QString fileName(){return fname_;}
+		QString lastError(){return err_;}
+		
+	signals:
+		
+		void progress(int,int);
+		void finished(bool);
+		
+	private slots:
+		
+		void workerFinished();
+		
+	private:
+		
+		bool run();
+		bool writeFASTA(BufferedWriter &);
+		bool writeClustalW(BufferedWriter &);
+		bool writeA3M(BufferedWriter &);
+		
+		QString filter(const QString &);
+		void reportProgress(int);
+		
+		QString fname_;
+		int format_;
+		bool removeExclusions_;
+		int lineWidth_;
+		QList<Record> records_;
+		
+		QAtomicInt cancelled_;
+		int progressStep_,lastProgress_;
+		QString err_;
+		
+		QFutureWatcher<bool> watcher_;
+};
+
+#endif
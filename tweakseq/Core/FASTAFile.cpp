@@ -27,14 +27,16 @@
 #include <QtDebug>
 #include "DebuggingInfo.h"
 
-#include <cmath>
-
+#include <QElapsedTimer>
 #include <QFile>
 #include <QStringList>
 #include <QFileInfo>
 #include <QStringList>
 
+#include "BufferedWriter.h"
+#include "CompressedDevice.h"
 #include "FASTAFile.h"
+#include "Sequence.h"
 
 // Base class for supported sequence alignment formats
 
@@ -150,26 +152,82 @@ bool FASTAFile::write(QStringList &l,QStringList &s,QStringList &c)
 {
 	setError("");
 	
+	QElapsedTimer timer;
+	timer.start();
+	
+	// Output is compressed if the extension asks for it
+	CompressedDevice::Format compression = CompressedDevice::formatForFile(name());
+	QString errmsg;
+	if (!CompressedDevice::available(compression,errmsg)){
+		setError(errmsg);
+		return false;
+	}
 	QFile f(name());
-	if (!f.open(QIODevice::WriteOnly | QIODevice::Text)){
+	if (!f.open(CompressedDevice::fileOpenMode(compression))){
 		qDebug() << trace.header() << "FASTAFile::write() couldn't open file";
 		setError("Couldn't open file");
 		return false;
 	}
-	QTextStream ts (&f);
 	
-	for (int i=0;i<l.size();i++){
-		ts << c.at(i) << endl;
-		int nlines = rint(s.at(i).size()/80);
-		if (nlines*80 < s.at(i).size()) nlines++;
-		for (int j=0;j<nlines;j++){
-			ts << s.at(i).mid(j*80,80) << endl; // ok, mid() will return last bit of the string
-		}
+	CompressedDevice cd(&f,compression);
+	if (!cd.open(QIODevice::WriteOnly)){
+		f.close();
+		setError(cd.errorString());
+		return false;
 	}
+	BufferedWriter bw(&cd);
+	for (int i=0;i<l.size();i++)
+		writeRecord(bw,l.at(i),s.at(i),(i < c.size() ? c.at(i) : QString()));
+	bool ok = bw.flush() && cd.finish();
 	f.close();
+	
+	if (!ok){
+		setError("Error while writing file");
+		return false;
+	}
+	
+	qint64 ms = timer.elapsed();
+	qInfo() << benchmark.header(__PRETTY_FUNCTION__) << l.size() << "sequences" << bw.bytesWritten() << "bytes" << ms << "ms"
+		<< (ms > 0 ? bw.bytesWritten()/(1048.576*ms) : 0.0) << "MB/s";
 	return true;
 }
 
+// Writes a single record. If applyExclusions is true, excluded residues are skipped as they are written
+void FASTAFile::writeRecord(BufferedWriter &bw,const QString &label,const QString &residues,const QString &comment,bool applyExclusions)
+{
+	if (!comment.isEmpty())
+		bw.write(comment);
+	else{ // eg imported from a format without comments
+		bw.write('>');
+		bw.write(label);
+	}
+	bw.write('\n');
+	
+	int lw = lineWidth();
+	const QChar *res = residues.constData();
+	int nres = residues.size();
+	int col=0;
+	int i=0;
+	while (i<nres){
+		if (applyExclusions && (res[i].unicode() & EXCLUDE_CELL)){
+			i++;
+			continue;
+		}
+		// Find the run of residues to output, up to the end of the line
+		int j=i;
+		while (j<nres && j-i < lw-col && !(applyExclusions && (res[j].unicode() & EXCLUDE_CELL))) j++;
+		bw.writeResidues(res+i,j-i);
+		col += j-i;
+		i=j;
+		if (col == lw){
+			bw.write('\n');
+			col=0;
+		}
+	}
+	if (col > 0)
+		bw.write('\n');
+}
+
 //
 // Private members
 //
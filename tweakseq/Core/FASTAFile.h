@@ -29,6 +29,8 @@
 
 #include "SequenceFile.h"
 
+class BufferedWriter;
+
 class FASTAFile:public SequenceFile{
 	public:
 		
@@ -39,6 +41,8 @@ class FASTAFile:public SequenceFile{
 		
 		virtual bool read(QStringList &,QStringList &,QStringList &,Structure *s=NULL);
 		virtual bool write(QStringList &,QStringList &,QStringList &);
+		
+		void writeRecord(BufferedWriter &,const QString &,const QString &,const QString &,bool applyExclusions=false);
 	
 	private:
 		
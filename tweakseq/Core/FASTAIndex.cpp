@@ -0,0 +1,388 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <QtDebug>
+#include "DebuggingInfo.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QPair>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cctype>
+
+#include "FASTAIndex.h"
+
+#define CHUNK_SIZE 4194304
+
+//
+//	Public members
+//	
+
+FASTAIndex::FASTAIndex(const QString &fname)
+{
+	fname_=fname;
+	cancelled_=0;
+	progress_=0;
+}
+
+FASTAIndex::~FASTAIndex()
+{
+}
+
+// Loads the index from disk, provided that it is newer than the FASTA file
+bool FASTAIndex::load()
+{
+	err_="";
+	entries_.clear();
+	lookup_.clear();
+	
+	QFileInfo fi(fname_);
+	QFileInfo faifi(indexFileName());
+	if (!faifi.exists()){
+		err_="No index";
+		return false;
+	}
+	if (faifi.lastModified() < fi.lastModified()){
+		qDebug() << trace.header(__PRETTY_FUNCTION__) << "stale index " << indexFileName();
+		err_="Index is out of date";
+		return false;
+	}
+	
+	QFile f(indexFileName());
+	if (!f.open(QIODevice::ReadOnly | QIODevice::Text)){
+		err_="Couldn't open " + indexFileName();
+		return false;
+	}
+	
+	QTextStream ts(&f);
+	QString s;
+	int lineNum=0;
+	while (ts.readLineInto(&s)){
+		lineNum++;
+		if (s.isEmpty()) continue;
+		QStringList fields = s.split('\t');
+		if (fields.size() < 5){
+			err_="Bad index file at line " + QString::number(lineNum);
+			entries_.clear();
+			lookup_.clear();
+			return false;
+		}
+		Entry e;
+		bool ok[4];
+		e.name=fields.at(0);
+		e.length=fields.at(1).toLongLong(&ok[0]);
+		e.offset=fields.at(2).toLongLong(&ok[1]);
+		e.lineBases=fields.at(3).toInt(&ok[2]);
+		e.lineBytes=fields.at(4).toInt(&ok[3]);
+		if (!(ok[0] && ok[1] && ok[2] && ok[3])){
+			err_="Bad index file at line " + QString::number(lineNum);
+			entries_.clear();
+			lookup_.clear();
+			return false;
+		}
+		addEntry(e);
+	}
+	
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << "loaded " << entries_.size() << " entries";
+	return true;
+}
+
+// Builds the index in one pass over the file and saves it next to the file
+// Failing to save the index is not an error, since it can still be used
+bool FASTAIndex::build()
+{
+	err_="";
+	entries_.clear();
+	lookup_.clear();
+	progress_=0;
+	
+	QFile f(fname_);
+	if (!f.open(QIODevice::ReadOnly)){ // binary, so that offsets are byte offsets
+		err_="Couldn't open " + fname_;
+		return false;
+	}
+	
+	qint64 fsize = f.size();
+	QByteArray buf(CHUNK_SIZE,0);
+	
+	Entry cur;
+	QByteArray name;
+	bool haveRecord=false,inHeader=false,nameDone=false,atLineStart=true,shortLine=false;
+	int lineBases=0,lineBytes=0;
+	qint64 pos=0;
+	
+	while (true){
+		
+		if (cancelled_.load()){
+			err_="Indexing was cancelled";
+			return false;
+		}
+		
+		qint64 nread = f.read(buf.data(),buf.size());
+		if (nread < 0){
+			err_="Error while reading " + fname_;
+			return false;
+		}
+		
+		const char *p=buf.constData();
+		// The extra iteration at the end of the file finishes off a last line without a terminator
+		for (qint64 i=0;i<=nread;i++,pos++){
+			
+			bool eof = (i==nread);
+			if (eof && nread > 0) break;
+			char c = eof ? '\n' : p[i];
+			
+			if (atLineStart && c == '>'){
+				if (haveRecord)
+					addEntry(cur);
+				if (!err_.isEmpty()) return false;
+				haveRecord=inHeader=true;
+				nameDone=false;
+				name.clear();
+				atLineStart=false;
+				continue;
+			}
+			
+			if (inHeader){
+				if (c == '\n'){
+					inHeader=false;
+					atLineStart=true;
+					cur.name=QString::fromLocal8Bit(name);
+					cur.length=0;
+					cur.offset=pos+1;
+					cur.lineBases=cur.lineBytes=0;
+					shortLine=false;
+					lineBases=lineBytes=0;
+				}
+				else if (!nameDone){
+					if (isspace(c))
+						nameDone=true;
+					else
+						name.append(c);
+				}
+				continue;
+			}
+			
+			if (!haveRecord){ // skip anything before the first record
+				atLineStart = (c=='\n');
+				continue;
+			}
+			
+			if (!eof)
+				lineBytes++;
+			else if (lineBases > 0) // a last line without a terminator is treated as though it has one
+				lineBytes = lineBases + (cur.lineBases > 0 ? cur.lineBytes - cur.lineBases : 1);
+			if (c != '\n'){
+				if (c != '\r') lineBases++;
+				atLineStart=false;
+				continue;
+			}
+			
+			// End of a sequence line
+			atLineStart=true;
+			if (lineBases == 0){
+				if (cur.length == 0)
+					cur.offset = pos+1; // skip blank lines before the sequence
+				else
+					shortLine=true;
+			}
+			else{
+				if (shortLine || (lineBases > cur.lineBases && cur.lineBases > 0) || 
+					(lineBases == cur.lineBases && lineBytes != cur.lineBytes)){
+					err_="Lines of different lengths in " + cur.name;
+					return false;
+				}
+				if (cur.lineBases == 0){
+					cur.lineBases=lineBases;
+					cur.lineBytes=lineBytes;
+				}
+				else if (lineBases < cur.lineBases)
+					shortLine=true;
+				cur.length += lineBases;
+			}
+			lineBases=lineBytes=0;
+		}
+		
+		if (nread == 0) break;
+		
+		if (fsize > 0)
+			progress_ = (int) ((100*pos)/fsize);
+	}
+	
+	if (inHeader) // a header at the very end of the file
+		cur.name=QString::fromLocal8Bit(name);
+	if (haveRecord)
+		addEntry(cur);
+	if (!err_.isEmpty()) return false;
+	
+	progress_=100;
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << "indexed " << entries_.size() << " records";
+	
+	if (!save())
+		qWarning() << warning.header(__PRETTY_FUNCTION__) << "couldn't save " << indexFileName();
+	err_="";
+	return true;
+}
+
+QStringList FASTAIndex::names()
+{
+	QStringList n;
+	n.reserve(entries_.size());
+	for (int i=0;i<entries_.size();i++)
+		n.append(entries_.at(i).name);
+	return n;
+}
+
+QStringList FASTAIndex::match(const QRegularExpression &re)
+{
+	QStringList n;
+	for (int i=0;i<entries_.size();i++){
+		if (re.match(entries_.at(i).name).hasMatch())
+			n.append(entries_.at(i).name);
+	}
+	return n;
+}
+
+// Fetches the named records, by random access
+// Records are read in file order, but returned in the order requested
+bool FASTAIndex::fetch(const QStringList &names,QStringList &seqnames,QStringList &seqs,QStringList &comments)
+{
+	err_="";
+	
+	QVector<QPair<qint64,int> > order; // (offset, index into names)
+	order.reserve(names.size());
+	for (int i=0;i<names.size();i++){
+		if (!lookup_.contains(names.at(i))){
+			err_="No record named " + names.at(i);
+			return false;
+		}
+		order.append(qMakePair(entries_.at(lookup_.value(names.at(i))).offset,i));
+	}
+	std::sort(order.begin(),order.end());
+	
+	QFile f(fname_);
+	if (!f.open(QIODevice::ReadOnly)){
+		err_="Couldn't open " + fname_;
+		return false;
+	}
+	
+	QVector<QString> fetched(names.size()),headers(names.size());
+	for (int o=0;o<order.size();o++){
+		const Entry &e = entries_.at(lookup_.value(names.at(order.at(o).second)));
+		if (!readHeader(f,e,headers[order.at(o).second]))
+			return false;
+		
+		qint64 nbytes = 0;
+		if (e.lineBases > 0)
+			nbytes = (e.length/e.lineBases)*e.lineBytes + e.length % e.lineBases;
+		if (!f.seek(e.offset)){
+			err_="Error while reading " + e.name;
+			return false;
+		}
+		QByteArray raw = f.read(nbytes); // may be short if the last line has no terminator
+		
+		// Strip the line terminators in place
+		char *d = raw.data();
+		int n=0;
+		for (int i=0;i<raw.size();i++){
+			if (d[i] != '\n' && d[i] != '\r')
+				d[n++]=d[i];
+		}
+		raw.truncate(n);
+		if (n != e.length){
+			err_="Error while reading " + e.name + " - is the index out of date ?";
+			return false;
+		}
+		fetched[order.at(o).second]=QString::fromLatin1(raw);
+	}
+	
+	for (int i=0;i<names.size();i++){
+		seqnames.append(names.at(i));
+		seqs.append(fetched.at(i));
+		comments.append(headers.at(i));
+	}
+	
+	return true;
+}
+
+//
+//	Private members
+//	
+
+bool FASTAIndex::save()
+{
+	QSaveFile f(indexFileName());
+	if (!f.open(QIODevice::WriteOnly | QIODevice::Text))
+		return false;
+	QTextStream ts(&f);
+	for (int i=0;i<entries_.size();i++){
+		const Entry &e = entries_.at(i);
+		ts << e.name << '\t' << e.length << '\t' << e.offset << '\t' << e.lineBases << '\t' << e.lineBytes << '\n';
+	}
+	ts.flush();
+	return f.commit();
+}
+
+void FASTAIndex::addEntry(const Entry &e)
+{
+	if (lookup_.contains(e.name)){
+		err_="Duplicate record name " + e.name;
+		return;
+	}
+	lookup_.insert(e.name,entries_.size());
+	entries_.append(e);
+}
+
+// The header is not in the index, but it immediately precedes the sequence
+// so it is found by reading backwards from the sequence
+bool FASTAIndex::readHeader(QIODevice &f,const Entry &e,QString &header)
+{
+	qint64 start = e.offset;
+	QByteArray chunk;
+	while (start > 0){
+		qint64 n = qMin((qint64) 65536,start);
+		start -= n;
+		if (!f.seek(start)){
+			err_="Error while reading " + e.name;
+			return false;
+		}
+		chunk.prepend(f.read(n));
+		QByteArray line = chunk.trimmed(); // removes the terminator and any blank lines
+		int nl = line.lastIndexOf('\n');
+		if (nl >= 0 || start == 0){
+			chunk = line.mid(nl+1);
+			break;
+		}
+	}
+	header = QString::fromLocal8Bit(chunk).trimmed();
+	if (!header.startsWith('>'))
+		header = ">" + e.name;
+	return true;
+}
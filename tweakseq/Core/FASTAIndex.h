@@ -0,0 +1,88 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef __FASTA_INDEX_H_
+#define __FASTA_INDEX_H_
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class QRegularExpression;
+
+// A samtools-compatible index (.fai) of a FASTA file, kept next to the file.
+// Each record's sequence can then be read with a single seek, so that a few records 
+// can be pulled out of a very large file without parsing the whole file.
+// Each record must have lines of equal length (except for the last line)
+
+class FASTAIndex
+{
+	public:
+		
+		struct Entry{
+			QString name;
+			qint64 length;    // number of residues
+			qint64 offset;    // of the first residue
+			int lineBases;    // residues per line
+			int lineBytes;    // bytes per line, including the line terminator
+		};
+		
+		FASTAIndex(const QString &);
+		~FASTAIndex();
+		
+		QString fileName(){return fname_;}
+		QString indexFileName(){return fname_ + ".fai";}
+		QString error(){return err_;}
+		
+		bool load();
+		bool build();
+		void cancel(){cancelled_=1;}
+		int  progress(){return progress_.load();} // percent, while building
+		
+		int size(){return entries_.size();}
+		const Entry &entry(int i){return entries_.at(i);}
+		QStringList names();
+		QStringList match(const QRegularExpression &);
+		bool contains(const QString &n){return lookup_.contains(n);}
+		
+		bool fetch(const QStringList &,QStringList &,QStringList &,QStringList &);
+		
+	private:
+		
+		bool save();
+		void addEntry(const Entry &);
+		bool readHeader(QIODevice &,const Entry &,QString &);
+		
+		QString fname_;
+		QString err_;
+		QVector<Entry> entries_;
+		QHash<QString,int> lookup_;
+		QAtomicInt cancelled_,progress_;
+};
+
+#endif
@@ -0,0 +1,113 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <QtDebug>
+#include "DebuggingInfo.h"
+
+#include <cctype>
+
+#include "FASTAStreamParser.h"
+
+//
+//	Public members
+//	
+
+FASTAStreamParser::FASTAStreamParser()
+{
+	inRecord_=false;
+}
+
+FASTAStreamParser::~FASTAStreamParser()
+{
+}
+
+void FASTAStreamParser::addData(const QByteArray &data)
+{
+	partial_.append(data);
+	
+	const char *p = partial_.constData();
+	int start=0;
+	int nl;
+	while ((nl = partial_.indexOf('\n',start)) >= 0){
+		parseLine(p+start,nl-start);
+		start = nl+1;
+	}
+	partial_.remove(0,start);
+}
+
+// Parses any final line without a terminator
+void FASTAStreamParser::finish()
+{
+	if (!partial_.isEmpty()){
+		parseLine(partial_.constData(),partial_.size());
+		partial_.clear();
+	}
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << "parsed " << seqnames_.size() << " sequences";
+}
+
+QStringList FASTAStreamParser::takeMessages()
+{
+	QStringList m = messages_;
+	messages_.clear();
+	return m;
+}
+
+void FASTAStreamParser::clear()
+{
+	partial_.clear();
+	inRecord_=false;
+	seqnames_.clear();
+	seqs_.clear();
+	comments_.clear();
+	messages_.clear();
+}
+
+//
+//	Private members
+//	
+
+void FASTAStreamParser::parseLine(const char *line,int len)
+{
+	// trim, as FASTAFile::read() does
+	while (len > 0 && isspace(line[len-1])) len--;
+	while (len > 0 && isspace(line[0])){line++;len--;}
+	
+	if (len == 0) return;
+	
+	if (line[0] == '>'){
+		inRecord_=true;
+		QString c = QString::fromLocal8Bit(line,len);
+		comments_.append(c);
+		// The label is the comment up to the first space
+		int index = c.indexOf(QChar(' '),1);
+		seqnames_.append(index == -1 ? c.mid(1) : c.mid(1,index-1));
+		seqs_.append(QString());
+	}
+	else if (!inRecord_)
+		messages_.append(QString::fromLocal8Bit(line,len));
+	else if (line[0] != ';') // FIXME other comments are skipped
+		seqs_.last().append(QString::fromLatin1(line,len));
+}
@@ -0,0 +1,65 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef __FASTA_STREAM_PARSER_H_
+#define __FASTA_STREAM_PARSER_H_
+
+#include <QByteArray>
+#include <QStringList>
+
+// Parses FASTA as it arrives, eg from an aligner's stdout, so that the output
+// doesn't have to go through a file.
+// Anything before the first record (some tools log to stdout) is kept as messages.
+
+class FASTAStreamParser
+{
+	public:
+		
+		FASTAStreamParser();
+		~FASTAStreamParser();
+		
+		void addData(const QByteArray &);
+		void finish();
+		
+		QStringList takeMessages();
+		
+		int size(){return seqnames_.size();}
+		QStringList &labels(){return seqnames_;}
+		QStringList &sequences(){return seqs_;}
+		QStringList &comments(){return comments_;}
+		
+		void clear();
+		
+	private:
+		
+		void parseLine(const char *,int);
+		
+		QByteArray partial_; // an incomplete line
+		bool inRecord_;
+		QStringList seqnames_,seqs_,comments_,messages_;
+};
+
+#endif
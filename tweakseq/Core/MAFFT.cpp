@@ -28,10 +28,9 @@
 #include "DebuggingInfo.h"
 
 #include <QDomDocument>
-#include <QProcess>
-#include <QThread>
 
 #include "MAFFT.h"
+#include "ProgressParser.h"
 #include "XMLHelper.h"
 //
 //	Public
@@ -46,10 +45,24 @@ MAFFT::~MAFFT()
 {
 }
 		
-void MAFFT::makeCommand(QString &fin, QString &fout, QString &exec, QStringList &arglist)
+void MAFFT::makePipeCommand(QString &exec, QStringList &arglist)
 {
 	exec = executable_;
-	arglist << "--auto" << "--thread" << "-1" << fin; // ouput is to stdout
+	// MAFFT needs an input file name but copies the input before reading it, so /dev/stdin works
+	arglist << "--auto" << "--thread" << "%threads" << "/dev/stdin";
+}
+
+bool MAFFT::makeAddCommand(const QString &alignment,int,QString &exec, QStringList &arglist)
+{
+	exec = executable_;
+	// --keeplength drops insertions in the new sequences so the existing columns are unchanged
+	arglist << "--add" << "/dev/stdin" << "--keeplength" << "--thread" << "%threads" << alignment;
+	return true;
+}
+
+ProgressParser *MAFFT::createProgressParser()
+{
+	return new MAFFTProgressParser();
 }
 
 void MAFFT::writeSettings(QDomDocument &doc,QDomElement &parentElem)
@@ -59,6 +72,7 @@ void MAFFT::writeSettings(QDomDocument &doc,QDomElement &parentElem)
 	XMLHelper::addElement(doc,pelem,"name",name());
 	XMLHelper::addElement(doc,pelem,"path",executable());
 	XMLHelper::addElement(doc,pelem,"preferred",(preferred() ? "yes":"no"));
+	writeResourceSettings(doc,pelem);
 }
 
 void MAFFT::readSettings(QDomDocument &doc)
@@ -71,6 +85,7 @@ void MAFFT::readSettings(QDomDocument &doc)
 			if (elem.tagName() == "name"){
 				if (elem.text() != name_)
 					break;
+				readResourceSettings(gNode);
 			}
 			if (elem.tagName() == "path"){
 				executable_=elem.text();
@@ -82,7 +97,7 @@ void MAFFT::readSettings(QDomDocument &doc)
 		}
 	}
 	
-	getVersion();
+	probeVersion(QStringList() << "--version",&MAFFT::parseVersion);
 	
 }
 
@@ -96,22 +111,10 @@ void MAFFT::init()
 	version_="";
 	executable_="/usr/local/bin/mafft";
 	usesStdOut_=true; // annoying
-	idealThreadCount_ = QThread::idealThreadCount();
-	qDebug() << trace.header(__PRETTY_FUNCTION__) << "threads " << idealThreadCount_;
 }
 
-void MAFFT::getVersion()
+QString MAFFT::parseVersion(const QByteArray &,const QByteArray &err)
 {
-	QProcess getver;
-	qDebug() << executable_;
-	getver.start(executable_, QStringList() << "--version");
-	if (getver.waitForStarted()){
-		getver.waitForReadyRead();
-		getver.waitForFinished();
-		version_ = QString(getver.readAllStandardError());
-		qDebug() << version_;
-		version_=version_.trimmed();
-	}
-	qDebug() << trace.header(__PRETTY_FUNCTION__) << name_ << " " << version_;
+	return QString(err).trimmed();
 }
 
@@ -36,16 +36,17 @@ class MAFFT: public AlignmentTool
 		MAFFT();
 		~MAFFT();
 		
-		virtual void makeCommand(QString &, QString &, QString &, QStringList &);
+		virtual void makePipeCommand(QString &, QStringList &);
+		virtual bool makeAddCommand(const QString &,int,QString &, QStringList &);
+		virtual bool threaded(){return true;}
+		virtual ProgressParser *createProgressParser();
 		virtual void writeSettings(QDomDocument &,QDomElement &);
 		virtual void readSettings(QDomDocument &);
 		
 	private:
 	
 		void init();
-		void getVersion();
-		
-		int idealThreadCount_;
+		static QString parseVersion(const QByteArray &,const QByteArray &);
 		
 };
 
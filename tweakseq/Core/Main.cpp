@@ -31,6 +31,7 @@
 #include <fstream>
 
 #include "Application.h"
+#include "BatchRunner.h"
 #include "DebuggingInfo.h"
 #include "Project.h"
 
@@ -58,6 +59,7 @@ void myMessageOutput(QtMsgType type, const QMessageLogContext &, const QString &
 				qCritical() << msg;
 				break;
 		case QtInfoMsg:
+				if (benchmarkOn) qInfo().noquote() << msg;
 				break;
 		case QtFatalMsg:
 				qFatal(msg.toLocal8Bit().constData());
@@ -73,7 +75,11 @@ int main(int argc, char **argv){
 	
 	//trace.showThread(true);
 
-	while ((c=getopt(argc,argv,"tbfow")) != EOF)
+	bool headless=false,batchConsensus=false;
+	int batchLineWidth=0;
+	QString batchTool,batchOutput,batchFormat;
+	
+	while ((c=getopt(argc,argv,"tbfowxa:kO:F:L:")) != EOF)
   {
 		switch (c)
 		{
@@ -83,12 +89,37 @@ int main(int argc, char **argv){
 			case 'w':warningOn=true;break;
 			case 'o': // debugging to file
 			break;
+			case 'x':headless=true;break;
+			case 'a':batchTool=optarg;break;
+			case 'k':batchConsensus=true;break;
+			case 'O':batchOutput=optarg;break;
+			case 'F':batchFormat=optarg;break;
+			case 'L':batchLineWidth=(QString(optarg).toInt() > 0 ? QString(optarg).toInt() : -1);break; // -1 is refused
 		}
 	}
 	qInstallMessageHandler(myMessageOutput);
 	
 	qDebug() << trace.header(__PRETTY_FUNCTION__) << "application starting ...";
 	
+	if (headless){
+		// No window is ever created, so Qt's minimal platform will do and no display is needed
+		if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+			qputenv("QT_QPA_PLATFORM","minimal");
+		Application a(argc, argv);
+		if (!a.configure(false))
+			return EXIT_FAILURE;
+		QStringList inputs;
+		for (int i=optind;i<argc;i++)
+			inputs.append(argv[i]);
+		BatchRunner batch;
+		batch.setInputs(inputs);
+		batch.setAlignmentTool(batchTool);
+		batch.setConsensus(batchConsensus);
+		batch.setOutput(batchOutput,batchFormat);
+		batch.setLineWidth(batchLineWidth);
+		return batch.run();
+	}
+	
 	Application a(argc, argv);
 	if (a.configure()){
 		Project *prj = a.createProject();
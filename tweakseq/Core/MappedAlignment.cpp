@@ -0,0 +1,120 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <QtDebug>
+#include "DebuggingInfo.h"
+
+#include "MappedAlignment.h"
+#include "Sequence.h"
+
+#define MAX_CACHED_ROWS 1024 // a few screens' worth
+
+//
+//	Public members
+//	
+
+MappedAlignment::MappedAlignment(const QString &fname):index_(fname),file_(fname)
+{
+	map_=NULL;
+	mapSize_=0;
+	maxLen_=0;
+	cache_.setMaxCost(MAX_CACHED_ROWS);
+}
+
+MappedAlignment::~MappedAlignment()
+{
+	cache_.clear();
+	if (map_ != NULL)
+		file_.unmap(map_);
+}
+
+// The index must have been loaded (or built) first
+bool MappedAlignment::open()
+{
+	err_="";
+	if (!file_.open(QIODevice::ReadOnly)){
+		err_="Couldn't open " + file_.fileName();
+		return false;
+	}
+	
+	mapSize_ = file_.size();
+	if (mapSize_ > 0){
+		map_ = file_.map(0,mapSize_);
+		if (map_ == NULL){
+			err_="Couldn't map " + file_.fileName();
+			return false;
+		}
+	}
+	
+	maxLen_=0;
+	for (int i=0;i<index_.size();i++){
+		const FASTAIndex::Entry &e = index_.entry(i);
+		if (e.length > maxLen_)
+			maxLen_ = (int) e.length;
+		if (e.lineBases > 0 && e.offset + (e.length/e.lineBases)*e.lineBytes + e.length % e.lineBases > mapSize_){
+			err_= file_.fileName() + " is shorter than its index - is the index out of date ?";
+			return false;
+		}
+	}
+	
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << index_.size() << "rows" << maxLen_ << "columns";
+	return true;
+}
+
+Sequence *MappedAlignment::sequenceAt(int i)
+{
+	if (i < 0 || i >= index_.size()) return NULL;
+	
+	Sequence *seq = cache_.object(i);
+	if (seq == NULL){
+		const FASTAIndex::Entry &e = index_.entry(i);
+		seq = new Sequence(e.name,decode(e),">" + e.name,file_.fileName(),true);
+		cache_.insert(i,seq);
+	}
+	return seq;
+}
+
+//
+//	Private members
+//	
+
+QString MappedAlignment::decode(const FASTAIndex::Entry &e)
+{
+	QString r((int) e.length,QChar('-'));
+	if (map_ == NULL || e.lineBases == 0) return r;
+	
+	QChar *d = r.data();
+	const uchar *p = map_ + e.offset;
+	qint64 nres=0;
+	while (nres < e.length){
+		int n = qMin((qint64) e.lineBases,e.length - nres);
+		for (int j=0;j<n;j++)
+			d[nres+j] = QChar(p[j]);
+		nres += n;
+		p += e.lineBytes;
+	}
+	return r;
+}
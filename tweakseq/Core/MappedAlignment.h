@@ -0,0 +1,73 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef __MAPPED_ALIGNMENT_H_
+#define __MAPPED_ALIGNMENT_H_
+
+#include <QCache>
+#include <QFile>
+#include <QString>
+
+#include "FASTAIndex.h"
+
+class Sequence;
+
+// A read-only view of a FASTA alignment which is too big to load.
+// The file is memory-mapped and rows are located via its .fai index,
+// so a row is only decoded when it is needed. Decoded rows are cached.
+
+class MappedAlignment
+{
+	public:
+		
+		MappedAlignment(const QString &);
+		~MappedAlignment();
+		
+		FASTAIndex &index(){return index_;}
+		
+		bool open();
+		QString error(){return err_;}
+		QString fileName(){return file_.fileName();}
+		
+		int size(){return index_.size();}
+		int maxLength(){return maxLen_;}
+		
+		Sequence *sequenceAt(int);
+		
+	private:
+		
+		QString decode(const FASTAIndex::Entry &);
+		
+		FASTAIndex index_;
+		QFile file_;
+		uchar *map_;
+		qint64 mapSize_;
+		int maxLen_;
+		QString err_;
+		QCache<int,Sequence> cache_;
+};
+
+#endif
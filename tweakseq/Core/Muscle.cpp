@@ -28,9 +28,10 @@
 #include "DebuggingInfo.h"
 
 #include <QDomDocument>
-#include <QProcess>
+#include <QRegExp>
 
 #include "Muscle.h"
+#include "ProgressParser.h"
 #include "XMLHelper.h"
 
 //
@@ -46,10 +47,26 @@ Muscle::~Muscle()
 {
 }
 		
-void Muscle::makeCommand(QString &fin, QString &fout, QString &exec, QStringList &arglist)
+void Muscle::makePipeCommand(QString &exec, QStringList &arglist)
 {
 	exec = executable_;
-	arglist <<  "-in" << fin << "-out" << fout;
+	// MUSCLE reads stdin and writes stdout by default. Progress goes to stderr
+	arglist.clear();
+}
+
+bool Muscle::makeAddCommand(const QString &alignment,int nAdded,QString &exec, QStringList &arglist)
+{
+	// MUSCLE aligns two profiles, and the new sequences aren't aligned to each other,
+	// so only a single sequence, which is its own profile, can be added
+	if (nAdded > 1) return false;
+	exec = executable_;
+	arglist << "-profile" << "-in1" << alignment << "-in2" << "/dev/stdin";
+	return true;
+}
+
+ProgressParser *Muscle::createProgressParser()
+{
+	return new MuscleProgressParser();
 }
 
 void Muscle::writeSettings(QDomDocument &doc,QDomElement &parentElem)
@@ -59,6 +76,7 @@ void Muscle::writeSettings(QDomDocument &doc,QDomElement &parentElem)
 	XMLHelper::addElement(doc,pelem,"name",name());
 	XMLHelper::addElement(doc,pelem,"path",executable());
 	XMLHelper::addElement(doc,pelem,"preferred",(preferred() ? "yes":"no"));
+	writeResourceSettings(doc,pelem);
 }
 
 void Muscle::readSettings(QDomDocument &doc)
@@ -71,6 +89,7 @@ void Muscle::readSettings(QDomDocument &doc)
 			if (elem.tagName() == "name"){
 				if (elem.text() != name_)
 					break;
+				readResourceSettings(gNode);
 			}
 			if (elem.tagName() == "path"){
 				executable_=elem.text();
@@ -82,7 +101,7 @@ void Muscle::readSettings(QDomDocument &doc)
 		}
 	}
 	
-	getVersion();
+	probeVersion(QStringList() << "-version",&Muscle::parseVersion);
 }
 
 //		
@@ -97,17 +116,11 @@ void Muscle::init()
 	
 }
 
-void Muscle::getVersion()
+QString Muscle::parseVersion(const QByteArray &out,const QByteArray &)
 {
-	QProcess getver;
-	getver.start(executable_, QStringList() << "-version");
-	if (getver.waitForStarted()){
-		getver.waitForReadyRead();
-		getver.waitForFinished();
-		version_ = QString(getver.readAll());
-		QStringList sl = version_.split(QRegExp("\\s+"));
-		if (version_.size() >= 1)
-			version_=sl.at(1);
-	}
-	qDebug() << trace.header(__PRETTY_FUNCTION__) << name_ << " " << version_;
+	// eg "MUSCLE v3.8.31 by Robert C. Edgar"
+	QStringList sl = QString(out).split(QRegExp("\\s+"),QString::SkipEmptyParts);
+	if (sl.size() >= 2)
+		return sl.at(1);
+	return "";
 }
\ No newline at end of file
@@ -36,14 +36,16 @@ class Muscle: public AlignmentTool
 		Muscle();
 		~Muscle();
 		
-		virtual void makeCommand(QString &, QString &, QString &, QStringList &);
+		virtual void makePipeCommand(QString &, QStringList &);
+		virtual bool makeAddCommand(const QString &,int,QString &, QStringList &);
+		virtual ProgressParser *createProgressParser();
 		virtual void writeSettings(QDomDocument &,QDomElement &);
 		virtual void readSettings(QDomDocument &);
 		
 	private:
 	
 		void init();
-		void getVersion();
+		static QString parseVersion(const QByteArray &,const QByteArray &);
 };
 
 #endif
\ No newline at end of file
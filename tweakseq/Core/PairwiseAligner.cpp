@@ -0,0 +1,826 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <QtDebug>
+#include "DebuggingInfo.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <QElapsedTimer>
+#include <QVector>
+
+#include "PairwiseAligner.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PAIRWISE_SIMD
+#include <immintrin.h>
+#endif
+
+#define MAX_TRACEBACK_CELLS 268435456 // a byte each
+#define MAX_STRIPED_BYTES 268435456 // for H and E of every cell, 4 bytes each
+#define MAX_LANE_SCORE 32000 // below the 16-bit limit by more than a substitution or a gap opening
+
+static int simdLimit=16; // lanes
+
+// The score of a gap of k residues, 0 for none
+static inline int gapScore(int k,int gapOpen,int gapExtend)
+{
+	return (k > 0) ? -(gapOpen + (k-1)*gapExtend) : 0;
+}
+
+// Smith-Waterman score in linear space. Used when there is no SIMD, or the 16-bit lanes saturate
+static int swScalar(const unsigned char *a,int alen,const unsigned char *b,int blen,
+	const int (*matrix)[NUM_RESIDUE_TYPES],int gapOpen,int gapExtend)
+{
+	int *H = new int[alen+1];
+	int *E = new int[alen+1];
+	for (int i=0;i<=alen;i++){
+		H[i]=0;
+		E[i]=-gapOpen;
+	}
+	int best=0;
+	for (int j=1;j<=blen;j++){
+		int diag=0,F=-gapOpen;
+		H[0]=0;
+		for (int i=1;i<=alen;i++){
+			// E: gap in a, F: gap in b
+			E[i] = qMax(H[i] - gapOpen,E[i] - gapExtend);
+			F = qMax(H[i-1] - gapOpen,F - gapExtend);
+			int h = diag + matrix[a[i-1]][b[j-1]];
+			h = qMax(h,qMax(E[i],F));
+			h = qMax(h,0);
+			diag = H[i];
+			H[i] = h;
+			if (h > best) best=h;
+		}
+	}
+	delete[] H;
+	delete[] E;
+	return best;
+}
+
+#if defined(PAIRWISE_SIMD)
+
+static inline qint16 clamp16(int v)
+{
+	return (qint16) qBound(-32768,v,32767);
+}
+
+static int maxLane(const qint16 *lanes,int n)
+{
+	int best=lanes[0];
+	for (int l=1;l<n;l++)
+		best = qMax(best,(int) lanes[l]);
+	return best;
+}
+
+// Query profile for the striped kernels: a residue type's scores against the query, in striped order
+static qint16 *stripedProfile(const unsigned char *a,int alen,int lanes,int segLen,const int (*matrix)[NUM_RESIDUE_TYPES])
+{
+	qint16 *profile = (qint16 *) _mm_malloc(NUM_RESIDUE_TYPES*segLen*lanes*sizeof(qint16),32);
+	for (int r=0;r<NUM_RESIDUE_TYPES;r++){
+		for (int i=0;i<segLen;i++){
+			for (int l=0;l<lanes;l++){
+				int q = l*segLen + i;
+				profile[(r*segLen + i)*lanes + l] = (q < alen) ? matrix[a[q]][r] : 0;
+			}
+		}
+	}
+	return profile;
+}
+
+// Striped Smith-Waterman (Farrar, Bioinformatics 23:156, 2007), in saturating 16-bit lanes.
+// The query profile holds, for each residue type, segLen vectors of substitution scores.
+// Query position q is in lane q / segLen of vector q % segLen.
+// With global set, the matrix has Needleman-Wunsch boundaries, and no floor at zero.
+// If hOut is given, H and E of every cell are stored in eOut and hOut, a column of b at a time in striped order,
+// and the maximum of each column in colMax. Returns the maximum of H over the whole matrix.
+__attribute__((target("sse2")))
+static int swStripedSSE2(const unsigned char *b,int blen,const qint16 *profile,int segLen,int gapOpen,int gapExtend,
+	bool global,qint16 *hOut,qint16 *eOut,int *colMax)
+{
+	const __m128i *vProfile = (const __m128i *) profile;
+	__m128i *vHStore = (__m128i *) _mm_malloc(segLen*sizeof(__m128i),16);
+	__m128i *vHLoad  = (__m128i *) _mm_malloc(segLen*sizeof(__m128i),16);
+	__m128i *vE      = (__m128i *) _mm_malloc(segLen*sizeof(__m128i),16);
+	
+	__m128i vZero = _mm_setzero_si128();
+	__m128i vNegInf = _mm_set1_epi16(-32768);
+	__m128i vNegLane0 = _mm_insert_epi16(vZero,-32768,0);
+	__m128i vGapO = _mm_set1_epi16(gapOpen);
+	__m128i vGapE = _mm_set1_epi16(gapExtend);
+	__m128i vFloor = global ? vNegInf : vZero; // a local alignment can start anywhere
+	__m128i vMax = vFloor;
+	
+	for (int i=0;i<segLen;i++){
+		if (global){ // a gap down the side, then E opens a gap from it
+			qint16 h[8];
+			for (int l=0;l<8;l++)
+				h[l] = clamp16(gapScore(l*segLen + i + 1,gapOpen,gapExtend));
+			vHStore[i] = _mm_loadu_si128((const __m128i *) h);
+			vE[i] = _mm_subs_epi16(vHStore[i],vGapO);
+		}
+		else{
+			vHStore[i]=vZero;
+			vE[i]=vNegInf;
+		}
+		vHLoad[i]=vHStore[i];
+	}
+	
+	for (int j=0;j<blen;j++){
+		const __m128i *vScore = vProfile + b[j]*segLen;
+		__m128i vF = vNegInf;
+		// H from the previous column, shifted down one query position
+		__m128i vH = _mm_slli_si128(vHStore[segLen-1],2);
+		if (global){ // from the gap along the top
+			vH = _mm_insert_epi16(vH,clamp16(gapScore(j,gapOpen,gapExtend)),0);
+			vF = _mm_insert_epi16(vF,clamp16(gapScore(j+1,gapOpen,gapExtend) - gapOpen),0);
+		}
+		__m128i *tmp = vHLoad; vHLoad = vHStore; vHStore = tmp;
+		__m128i *eCol = (hOut != NULL) ? (__m128i *) eOut + (size_t) j*segLen : NULL;
+		__m128i vColMax = vFloor;
+		
+		for (int i=0;i<segLen;i++){
+			vH = _mm_adds_epi16(vH,vScore[i]);
+			__m128i e = vE[i];
+			if (eCol != NULL)
+				eCol[i]=e;
+			vH = _mm_max_epi16(vH,e);
+			vH = _mm_max_epi16(vH,vF);
+			vH = _mm_max_epi16(vH,vFloor);
+			vColMax = _mm_max_epi16(vColMax,vH);
+			vHStore[i] = vH;
+			
+			vH = _mm_subs_epi16(vH,vGapO);
+			e = _mm_subs_epi16(e,vGapE);
+			vE[i] = _mm_max_epi16(e,vH);
+			vF = _mm_subs_epi16(vF,vGapE);
+			vF = _mm_max_epi16(vF,vH);
+			
+			vH = vHLoad[i];
+		}
+		
+		// Lazy F loop: carry F across the segment boundaries until it can no longer change H
+		vF = _mm_or_si128(_mm_slli_si128(vF,2),vNegLane0);
+		int i=0;
+		while (_mm_movemask_epi8(_mm_cmpgt_epi16(vF,_mm_subs_epi16(vHStore[i],vGapO)))){
+			vH = _mm_max_epi16(vHStore[i],vF);
+			vHStore[i] = vH;
+			vColMax = _mm_max_epi16(vColMax,vH);
+			vE[i] = _mm_max_epi16(vE[i],_mm_subs_epi16(vH,vGapO));
+			vF = _mm_subs_epi16(vF,vGapE);
+			if (++i >= segLen){
+				i=0;
+				vF = _mm_or_si128(_mm_slli_si128(vF,2),vNegLane0);
+			}
+		}
+		
+		vMax = _mm_max_epi16(vMax,vColMax);
+		if (hOut != NULL){
+			memcpy(hOut + (size_t) j*segLen*8,vHStore,segLen*sizeof(__m128i));
+			qint16 lanes[8];
+			_mm_storeu_si128((__m128i *) lanes,vColMax);
+			colMax[j] = maxLane(lanes,8);
+		}
+	}
+	
+	qint16 lanes[8];
+	_mm_storeu_si128((__m128i *) lanes,vMax);
+	
+	_mm_free(vHStore);
+	_mm_free(vHLoad);
+	_mm_free(vE);
+	return maxLane(lanes,8);
+}
+
+// Shifts a 256-bit vector up by one 16-bit lane, across the 128-bit halves
+#define AVX2_SHIFT_LANE(v) _mm256_alignr_epi8((v),_mm256_permute2x128_si256((v),(v),0x08),14)
+
+__attribute__((target("avx2")))
+static int swStripedAVX2(const unsigned char *b,int blen,const qint16 *profile,int segLen,int gapOpen,int gapExtend,
+	bool global,qint16 *hOut,qint16 *eOut,int *colMax)
+{
+	const __m256i *vProfile = (const __m256i *) profile;
+	__m256i *vHStore = (__m256i *) _mm_malloc(segLen*sizeof(__m256i),32);
+	__m256i *vHLoad  = (__m256i *) _mm_malloc(segLen*sizeof(__m256i),32);
+	__m256i *vE      = (__m256i *) _mm_malloc(segLen*sizeof(__m256i),32);
+	
+	__m256i vZero = _mm256_setzero_si256();
+	__m256i vNegInf = _mm256_set1_epi16(-32768);
+	__m256i vNegLane0 = _mm256_insert_epi16(vZero,-32768,0);
+	__m256i vGapO = _mm256_set1_epi16(gapOpen);
+	__m256i vGapE = _mm256_set1_epi16(gapExtend);
+	__m256i vFloor = global ? vNegInf : vZero;
+	__m256i vMax = vFloor;
+	
+	for (int i=0;i<segLen;i++){
+		if (global){
+			qint16 h[16];
+			for (int l=0;l<16;l++)
+				h[l] = clamp16(gapScore(l*segLen + i + 1,gapOpen,gapExtend));
+			vHStore[i] = _mm256_loadu_si256((const __m256i *) h);
+			vE[i] = _mm256_subs_epi16(vHStore[i],vGapO);
+		}
+		else{
+			vHStore[i]=vZero;
+			vE[i]=vNegInf;
+		}
+		vHLoad[i]=vHStore[i];
+	}
+	
+	for (int j=0;j<blen;j++){
+		const __m256i *vScore = vProfile + b[j]*segLen;
+		__m256i vF = vNegInf;
+		__m256i vH = AVX2_SHIFT_LANE(vHStore[segLen-1]);
+		if (global){
+			vH = _mm256_insert_epi16(vH,clamp16(gapScore(j,gapOpen,gapExtend)),0);
+			vF = _mm256_insert_epi16(vF,clamp16(gapScore(j+1,gapOpen,gapExtend) - gapOpen),0);
+		}
+		__m256i *tmp = vHLoad; vHLoad = vHStore; vHStore = tmp;
+		__m256i *eCol = (hOut != NULL) ? (__m256i *) eOut + (size_t) j*segLen : NULL;
+		__m256i vColMax = vFloor;
+		
+		for (int i=0;i<segLen;i++){
+			vH = _mm256_adds_epi16(vH,vScore[i]);
+			__m256i e = vE[i];
+			if (eCol != NULL)
+				eCol[i]=e;
+			vH = _mm256_max_epi16(vH,e);
+			vH = _mm256_max_epi16(vH,vF);
+			vH = _mm256_max_epi16(vH,vFloor);
+			vColMax = _mm256_max_epi16(vColMax,vH);
+			vHStore[i] = vH;
+			
+			vH = _mm256_subs_epi16(vH,vGapO);
+			e = _mm256_subs_epi16(e,vGapE);
+			vE[i] = _mm256_max_epi16(e,vH);
+			vF = _mm256_subs_epi16(vF,vGapE);
+			vF = _mm256_max_epi16(vF,vH);
+			
+			vH = vHLoad[i];
+		}
+		
+		vF = _mm256_or_si256(AVX2_SHIFT_LANE(vF),vNegLane0);
+		int i=0;
+		while (_mm256_movemask_epi8(_mm256_cmpgt_epi16(vF,_mm256_subs_epi16(vHStore[i],vGapO)))){
+			vH = _mm256_max_epi16(vHStore[i],vF);
+			vHStore[i] = vH;
+			vColMax = _mm256_max_epi16(vColMax,vH);
+			vE[i] = _mm256_max_epi16(vE[i],_mm256_subs_epi16(vH,vGapO));
+			vF = _mm256_subs_epi16(vF,vGapE);
+			if (++i >= segLen){
+				i=0;
+				vF = _mm256_or_si256(AVX2_SHIFT_LANE(vF),vNegLane0);
+			}
+		}
+		
+		vMax = _mm256_max_epi16(vMax,vColMax);
+		if (hOut != NULL){
+			memcpy(hOut + (size_t) j*segLen*16,vHStore,segLen*sizeof(__m256i));
+			qint16 lanes[16];
+			_mm256_storeu_si256((__m256i *) lanes,vColMax);
+			colMax[j] = maxLane(lanes,16);
+		}
+	}
+	
+	qint16 lanes[16];
+	_mm256_storeu_si256((__m256i *) lanes,vMax);
+	
+	_mm_free(vHStore);
+	_mm_free(vHLoad);
+	_mm_free(vE);
+	return maxLane(lanes,16);
+}
+
+// H and E of the cells filled by the striped kernels, indexed like gotoh()'s matrix: i along a and j along b,
+// with row and column 0 the boundary
+struct StripedCells
+{
+	const qint16 *h,*e;
+	int segLen,lanes;
+	int gapOpen,gapExtend;
+	bool global;
+	
+	int H(int i,int j) const
+	{
+		if (i == 0) return global ? gapScore(j,gapOpen,gapExtend) : 0;
+		if (j == 0) return global ? gapScore(i,gapOpen,gapExtend) : 0;
+		return h[((size_t)(j-1)*segLen + (i-1) % segLen)*lanes + (i-1)/segLen];
+	}
+	int E(int i,int j) const
+	{
+		return e[((size_t)(j-1)*segLen + (i-1) % segLen)*lanes + (i-1)/segLen];
+	}
+};
+
+#endif
+
+// Traceback flags, one byte per cell
+#define TB_H_DIAG 0x00
+#define TB_H_E    0x01
+#define TB_H_F    0x02
+#define TB_H_ZERO 0x03
+#define TB_H_MASK 0x03
+#define TB_E_EXT  0x04 // the gap in E continues in the previous column
+#define TB_F_EXT  0x08 // the gap in F continues in the previous row
+
+#define NEG_INF (-1000000000)
+
+// Gotoh's affine gap algorithm, keeping a byte per cell for the traceback.
+// Rows are residues of a, columns are residues of b.
+// E is a residue of b against a gap (a horizontal move), F is a residue of a against a gap (a vertical move).
+// The alignment is returned as a string of operations: 'M' (aligned pair), 'I' (residue of a against a gap),
+// 'D' (residue of b against a gap), together with the aligned region of a and b.
+static int gotoh(const unsigned char *a,int alen,const unsigned char *b,int blen,
+	const int (*matrix)[NUM_RESIDUE_TYPES],int gapOpen,int gapExtend,bool local,
+	QByteArray &ops,int &aStart,int &aStop,int &bStart,int &bStop)
+{
+	int w = blen+1;
+	unsigned char *tb = new unsigned char[(size_t)(alen+1)*w];
+	int *H = new int[w];
+	int *F = new int[w];
+	
+	// Row 0
+	H[0]=0;
+	F[0]=NEG_INF;
+	tb[0]=TB_H_ZERO;
+	for (int j=1;j<=blen;j++){
+		F[j]=NEG_INF;
+		if (local){
+			H[j]=0;
+			tb[j]=TB_H_ZERO;
+		}
+		else{
+			H[j] = -gapOpen - (j-1)*gapExtend;
+			tb[j] = TB_H_E | (j > 1 ? TB_E_EXT : 0);
+		}
+	}
+	
+	int best=0,bestI=0,bestJ=0;
+	for (int i=1;i<=alen;i++){
+		unsigned char *tbRow = tb + (size_t) i*w;
+		int diag = H[0]; // H(i-1,j-1)
+		if (local){
+			H[0]=0;
+			tbRow[0]=TB_H_ZERO;
+		}
+		else{
+			H[0] = -gapOpen - (i-1)*gapExtend;
+			tbRow[0] = TB_H_F | (i > 1 ? TB_F_EXT : 0);
+		}
+		int E=NEG_INF;
+		const int *score = matrix[a[i-1]];
+		for (int j=1;j<=blen;j++){
+			unsigned char t=0;
+			
+			int eOpen = H[j-1] - gapOpen; // H(i,j-1)
+			int eExt = E - gapExtend;
+			if (eExt > eOpen){
+				E=eExt;
+				t |= TB_E_EXT;
+			}
+			else
+				E=eOpen;
+			
+			int fOpen = H[j] - gapOpen; // H(i-1,j)
+			int fExt = F[j] - gapExtend;
+			if (fExt > fOpen){
+				F[j]=fExt;
+				t |= TB_F_EXT;
+			}
+			else
+				F[j]=fOpen;
+			
+			int h = diag + score[b[j-1]];
+			if (E > h){
+				h=E;
+				t |= TB_H_E;
+			}
+			if (F[j] > h){
+				h=F[j];
+				t = (t & ~TB_H_MASK) | TB_H_F;
+			}
+			if (local && h <= 0){
+				h=0;
+				t |= TB_H_ZERO;
+			}
+			
+			diag = H[j];
+			H[j]=h;
+			tbRow[j]=t;
+			
+			if (local && h > best){
+				best=h;
+				bestI=i;
+				bestJ=j;
+			}
+		}
+	}
+	
+	int i,j;
+	if (local){
+		i=bestI;
+		j=bestJ;
+	}
+	else{
+		best = H[blen];
+		i=alen;
+		j=blen;
+	}
+	aStop=i;
+	bStop=j;
+	
+	ops.clear();
+	int state=TB_H_DIAG; // 0 is H, otherwise the gap matrix
+	while (i > 0 || j > 0){
+		unsigned char t = tb[(size_t) i*w + j];
+		if (state == TB_H_DIAG){
+			int src = t & TB_H_MASK;
+			if (src == TB_H_ZERO)
+				break;
+			else if (src == TB_H_DIAG){
+				ops.append('M');
+				i--;
+				j--;
+			}
+			else
+				state = src;
+		}
+		else if (state == TB_H_E){
+			ops.append('D');
+			j--;
+			if (!(t & TB_E_EXT)) state=TB_H_DIAG;
+		}
+		else{
+			ops.append('I');
+			i--;
+			if (!(t & TB_F_EXT)) state=TB_H_DIAG;
+		}
+	}
+	aStart=i;
+	bStart=j;
+	std::reverse(ops.begin(),ops.end());
+	
+	delete[] tb;
+	delete[] H;
+	delete[] F;
+	return best;
+}
+
+// Returns the number of 16-bit lanes of the best instruction set on this CPU, up to the limit, or 0
+static int simdLanes()
+{
+#if defined(PAIRWISE_SIMD)
+	if (simdLimit >= 16 && __builtin_cpu_supports("avx2"))
+		return 16;
+	if (simdLimit >= 8 && __builtin_cpu_supports("sse2"))
+		return 8;
+#endif
+	return 0;
+}
+
+//
+//	Public members
+//	
+
+PairwiseAligner::PairwiseAligner(Scoring s)
+{
+	scoring_=s;
+	mode_=Global;
+	alignmentScore_=0;
+	maxMatrixScore_=0;
+	minMatrixScore_=0;
+	striped_=false;
+	
+	for (int i=0;i<NUM_RESIDUE_TYPES;i++){
+		for (int j=0;j<NUM_RESIDUE_TYPES;j++){
+			if (scoring_ == Protein)
+				matrix_[i][j]=ScoringMatrix::BLOSUM62[i][j];
+			else if (i < 4 && j < 4) // A,C,G,T
+				matrix_[i][j]= (i == j) ? 5 : -4;
+			else
+				matrix_[i][j]=-1;
+			maxMatrixScore_ = qMax(maxMatrixScore_,matrix_[i][j]);
+			minMatrixScore_ = qMin(minMatrixScore_,matrix_[i][j]);
+		}
+	}
+	
+	if (scoring_ == Protein)
+		setGapPenalties(11,1);
+	else
+		setGapPenalties(10,1);
+}
+
+PairwiseAligner::~PairwiseAligner()
+{
+}
+
+void PairwiseAligner::setGapPenalties(int open,int extend)
+{
+	// The SIMD code uses 16-bit lanes
+	gapOpen_ = qBound(1,open,1000);
+	gapExtend_ = qBound(0,extend,gapOpen_);
+}
+
+// Local alignment score. Gaps in the input are ignored
+int PairwiseAligner::score(const QString &a,const QString &b)
+{
+	QByteArray ca,cb;
+	QString ra,rb;
+	encode(a,ca,ra);
+	encode(b,cb,rb);
+	
+	QElapsedTimer timer;
+	timer.start();
+	int s = swScore(ca,cb);
+	qint64 ns = timer.nsecsElapsed();
+	
+	double cells = (double) ca.size()*cb.size();
+	qInfo() << benchmark.header(__PRETTY_FUNCTION__) << ca.size() << "x" << cb.size() << simdName() << ns/1000000.0 << "ms"
+		<< (ns > 0 ? cells/ns : 0.0) << "GCUPS";
+	return s;
+}
+
+// Aligns a and b. Gaps in the input are ignored.
+// For a local alignment, only the aligned regions are returned
+bool PairwiseAligner::align(const QString &a,const QString &b,QString &alignedA,QString &alignedB,QString &errmsg)
+{
+	QByteArray ca,cb;
+	QString ra,rb;
+	encode(a,ca,ra);
+	encode(b,cb,rb);
+	
+	QElapsedTimer timer;
+	timer.start();
+	
+	QByteArray ops;
+	int aStart,bStart;
+	if (!alignCodes(ca,cb,ops,aStart,bStart,errmsg))
+		return false;
+	
+	alignedA.clear();
+	alignedB.clear();
+	alignedA.reserve(ops.size());
+	alignedB.reserve(ops.size());
+	int i=aStart,j=bStart;
+	for (int o=0;o<ops.size();o++){
+		switch (ops.at(o)){
+			case 'M':alignedA.append(ra.at(i++));alignedB.append(rb.at(j++));break;
+			case 'I':alignedA.append(ra.at(i++));alignedB.append(QChar('-'));break;
+			case 'D':alignedA.append(QChar('-'));alignedB.append(rb.at(j++));break;
+		}
+	}
+	
+	qint64 ns = timer.nsecsElapsed();
+	double cells = (double) ca.size()*cb.size();
+	qInfo() << benchmark.header(__PRETTY_FUNCTION__) << ca.size() << "x" << cb.size() << (striped_ ? simdName() : "scalar")
+		<< ns/1000000.0 << "ms" << (ns > 0 ? cells/ns : 0.0) << "GCUPS";
+	
+	return true;
+}
+
+// Aligns two sequences of residue types, from encode(). The alignment is returned as operations:
+// 'M' (aligned pair), 'I' (residue of a against a gap), 'D' (residue of b against a gap).
+// For a local alignment, the aligned region starts at aStart and bStart
+bool PairwiseAligner::alignCodes(const QByteArray &a,const QByteArray &b,QByteArray &ops,int &aStart,int &bStart,QString &errmsg)
+{
+	if (a.isEmpty() || b.isEmpty()){
+		errmsg = "Both sequences must contain residues";
+		return false;
+	}
+	
+	striped_ = alignStriped(a,b,ops,aStart,bStart);
+	if (striped_)
+		return true;
+	
+	if ((qint64) (a.size()+1)*(b.size()+1) > MAX_TRACEBACK_CELLS){
+		errmsg = "The sequences are too long to align in memory";
+		return false;
+	}
+	
+	int aStop,bStop;
+	alignmentScore_ = gotoh((const unsigned char *) a.constData(),a.size(),(const unsigned char *) b.constData(),b.size(),
+		matrix_,gapOpen_,gapExtend_,mode_ == Local,ops,aStart,aStop,bStart,bStop);
+	return true;
+}
+
+QString PairwiseAligner::simdName()
+{
+	switch (simdLanes()){
+		case 16:return "AVX2";
+		case 8:return "SSE2";
+	}
+	return "scalar";
+}
+
+void PairwiseAligner::limitSimd(int lanes)
+{
+	simdLimit = lanes;
+}
+
+//
+//	Private members
+//	
+
+// Converts residues to rows of the scoring matrix, dropping gaps.
+// The residues themselves are kept for the output
+void PairwiseAligner::encode(const QString &s,QByteArray &codes,QString &residues)
+{
+	codes.reserve(s.size());
+	residues.reserve(s.size());
+	for (int i=0;i<s.size();i++){
+		char c = s.at(i).toLatin1();
+		if (c == '-' || c == '.' || c == ' ') continue;
+		residues.append(s.at(i));
+		if (scoring_ == Protein)
+			codes.append((char) ScoringMatrix::BLOSUM62index(c));
+		else{
+			switch (c){
+				case 'A':case 'a':codes.append((char) 0);break;
+				case 'C':case 'c':codes.append((char) 1);break;
+				case 'G':case 'g':codes.append((char) 2);break;
+				case 'T':case 't':case 'U':case 'u':codes.append((char) 3);break;
+				default:codes.append((char) 4);break;
+			}
+		}
+	}
+}
+
+int PairwiseAligner::swScore(const QByteArray &a,const QByteArray &b)
+{
+	const unsigned char *pa = (const unsigned char *) a.constData();
+	const unsigned char *pb = (const unsigned char *) b.constData();
+	int alen = a.size();
+	int blen = b.size();
+	if (alen == 0 || blen == 0) return 0;
+	
+#if defined(PAIRWISE_SIMD)
+	int lanes = simdLanes();
+	if (lanes > 0){
+		int segLen = (alen + lanes - 1)/lanes;
+		qint16 *profile = stripedProfile(pa,alen,lanes,segLen,matrix_);
+		int s;
+		if (lanes == 16)
+			s = swStripedAVX2(pb,blen,profile,segLen,gapOpen_,gapExtend_,false,NULL,NULL,NULL);
+		else
+			s = swStripedSSE2(pb,blen,profile,segLen,gapOpen_,gapExtend_,false,NULL,NULL,NULL);
+		_mm_free(profile);
+		if (s < 32767 - maxMatrixScore_)
+			return s;
+		// otherwise the lanes may have saturated
+	}
+#endif
+	return swScalar(pa,alen,pb,blen,matrix_,gapOpen_,gapExtend_);
+}
+
+// Fills the matrix with the striped kernel, keeping H and E for every cell, and traces back through them,
+// making the same choices as gotoh(). Returns false, for gotoh() to do the alignment instead,
+// when there is no SIMD, the matrix is too big, or the 16-bit lanes could saturate
+bool PairwiseAligner::alignStriped(const QByteArray &a,const QByteArray &b,QByteArray &ops,int &aStart,int &bStart)
+{
+#if defined(PAIRWISE_SIMD)
+	int lanes = simdLanes();
+	if (lanes == 0) return false;
+	
+	const unsigned char *pa = (const unsigned char *) a.constData();
+	const unsigned char *pb = (const unsigned char *) b.constData();
+	int alen = a.size();
+	int blen = b.size();
+	int segLen = (alen + lanes - 1)/lanes;
+	qint64 cells = (qint64) segLen*lanes*blen;
+	if (cells*2*sizeof(qint16) > MAX_STRIPED_BYTES) return false;
+	
+	// Every cell of a global alignment scores at least as well as the gaps along two edges
+	bool global = (mode_ == Global);
+	if (global && 3*gapOpen_ + (qint64)(alen + blen)*gapExtend_ - minMatrixScore_ > MAX_LANE_SCORE)
+		return false;
+	
+	qint16 *profile = stripedProfile(pa,alen,lanes,segLen,matrix_);
+	qint16 *H = (qint16 *) _mm_malloc(cells*sizeof(qint16),32);
+	qint16 *E = (qint16 *) _mm_malloc(cells*sizeof(qint16),32);
+	QVector<int> colMax(blen);
+	int best;
+	if (lanes == 16)
+		best = swStripedAVX2(pb,blen,profile,segLen,gapOpen_,gapExtend_,global,H,E,colMax.data());
+	else
+		best = swStripedSSE2(pb,blen,profile,segLen,gapOpen_,gapExtend_,global,H,E,colMax.data());
+	_mm_free(profile);
+	if (best > MAX_LANE_SCORE){
+		_mm_free(H);
+		_mm_free(E);
+		return false;
+	}
+	
+	StripedCells sc;
+	sc.h=H;
+	sc.e=E;
+	sc.segLen=segLen;
+	sc.lanes=lanes;
+	sc.gapOpen=gapOpen_;
+	sc.gapExtend=gapExtend_;
+	sc.global=global;
+	
+	int i=0,j=0;
+	if (global){
+		i=alen;
+		j=blen;
+		alignmentScore_ = sc.H(alen,blen);
+	}
+	else{
+		// gotoh() ends at the first best cell by row of a, then by column of b
+		alignmentScore_ = best;
+		for (int c=1;c<=blen && best > 0;c++){
+			if (colMax.at(c-1) != best) continue;
+			int last = (i > 0) ? i-1 : alen;
+			for (int r=1;r<=last;r++){
+				if (sc.H(r,c) == best){
+					i=r;
+					j=c;
+					break;
+				}
+			}
+		}
+	}
+	
+	// H is from a diagonal step, E or F, preferred in that order, and a gap is extended only when that
+	// is strictly better than opening it
+	ops.clear();
+	int state=TB_H_DIAG;
+	int f=0; // F of the current cell
+	while (i > 0 || j > 0){
+		if (state == TB_H_DIAG){
+			if (i == 0 || j == 0){ // the boundary, which is a gap in a global alignment
+				if (!global) break;
+				ops.append(QByteArray(i+j,i > 0 ? 'I' : 'D'));
+				i=j=0;
+				break;
+			}
+			int h = sc.H(i,j);
+			if (!global && h == 0)
+				break;
+			if (h == sc.H(i-1,j-1) + matrix_[pa[i-1]][pb[j-1]]){
+				ops.append('M');
+				i--;
+				j--;
+			}
+			else if (h == sc.E(i,j))
+				state=TB_H_E;
+			else{
+				state=TB_H_F;
+				f=h;
+			}
+		}
+		else if (state == TB_H_E){
+			ops.append('D');
+			bool extended = sc.E(i,j) > sc.H(i,j-1) - gapOpen_;
+			j--;
+			if (!extended) state=TB_H_DIAG;
+		}
+		else{
+			ops.append('I');
+			bool extended = f > sc.H(i-1,j) - gapOpen_;
+			i--;
+			f += gapExtend_;
+			if (!extended) state=TB_H_DIAG;
+		}
+	}
+	aStart=i;
+	bStart=j;
+	std::reverse(ops.begin(),ops.end());
+	
+	_mm_free(H);
+	_mm_free(E);
+	return true;
+#else
+	Q_UNUSED(a);
+	Q_UNUSED(b);
+	Q_UNUSED(ops);
+	Q_UNUSED(aStart);
+	Q_UNUSED(bStart);
+	return false;
+#endif
+}
@@ -0,0 +1,83 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef __PAIRWISE_ALIGNER_H_
+#define __PAIRWISE_ALIGNER_H_
+
+#include <QByteArray>
+#include <QString>
+
+#include "ScoringMatrix.h"
+
+// Aligns two sequences in-process, with affine gap penalties.
+// A gap of length k costs gapOpen + (k-1)*gapExtend.
+// score() computes a local (Smith-Waterman) score using striped SIMD (AVX2 or SSE2) where available.
+// align() does a global (Needleman-Wunsch) or local alignment with Gotoh's algorithm, and a traceback.
+// The matrix is filled by the striped SIMD code too, when it fits in memory and in the 16-bit lanes.
+
+class PairwiseAligner
+{
+	public:
+		
+		enum Mode {Global,Local};
+		enum Scoring {Protein,DNA};
+		
+		PairwiseAligner(Scoring s=Protein);
+		~PairwiseAligner();
+		
+		void setMode(Mode m){mode_=m;}
+		Mode mode(){return mode_;}
+		
+		void setGapPenalties(int,int);
+		int gapOpen(){return gapOpen_;}
+		int gapExtend(){return gapExtend_;}
+		
+		int score(const QString &,const QString &);
+		bool align(const QString &,const QString &,QString &,QString &,QString &);
+		bool alignCodes(const QByteArray &,const QByteArray &,QByteArray &,int &,int &,QString &); // encoded residues
+		int alignmentScore(){return alignmentScore_;}
+		
+		static QString simdName();
+		static void limitSimd(int lanes); // 16 for AVX2, 8 for SSE2, 0 for none; for benchmarking
+		
+		void encode(const QString &,QByteArray &,QString &);
+		int substitution(int r1,int r2){return matrix_[r1][r2];}
+		
+	private:
+		
+		int swScore(const QByteArray &,const QByteArray &);
+		bool alignStriped(const QByteArray &,const QByteArray &,QByteArray &,int &,int &);
+		
+		Scoring scoring_;
+		Mode mode_;
+		int gapOpen_,gapExtend_;
+		int matrix_[NUM_RESIDUE_TYPES][NUM_RESIDUE_TYPES];
+		int maxMatrixScore_,minMatrixScore_;
+		int alignmentScore_;
+		bool striped_; // the last alignment used the SIMD code
+};
+
+#endif
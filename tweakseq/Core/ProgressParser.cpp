@@ -0,0 +1,339 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <QtDebug>
+#include "DebuggingInfo.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QTextStream>
+
+#include "Application.h"
+#include "ProgressParser.h"
+
+extern Application *app;
+
+#define MIN_LEARNING_TIME 2000 // ms; shorter runs are dominated by start-up
+#define LEARNING_RATE 0.3
+
+QHash<QString,double> ProgressParser::history_;
+bool ProgressParser::historyLoaded_=false;
+
+//
+//	Public
+//
+
+ProgressParser::ProgressParser(const QString &toolName)
+{
+	toolName_=toolName;
+	current_=-1;
+	within_=0.0;
+	reported_=-1.0;
+	changed_=false;
+	timer_.start();
+	if (!historyLoaded_)
+		loadHistory();
+}
+
+ProgressParser::~ProgressParser()
+{
+}
+
+// Lines may end with '\r' as well as '\n', since progress counters are usually overwritten in place
+void ProgressParser::addData(const QByteArray &data,QStringList &messages)
+{
+	partial_.append(data);
+	parseLines(false,messages);
+}
+
+void ProgressParser::flush(QStringList &messages)
+{
+	parseLines(true,messages);
+}
+
+bool ProgressParser::takeChanged()
+{
+	double f = fraction();
+	if (changed_ || qAbs(f - reported_) >= 0.005){
+		reported_=f;
+		changed_=false;
+		return true;
+	}
+	return false;
+}
+
+double ProgressParser::fraction()
+{
+	if (current_ < 0) return -1.0;
+	
+	double total=0.0,done=0.0;
+	for (int s=0;s<stages_.size();s++){
+		total += stages_.at(s).share;
+		if (s < current_)
+			done += stages_.at(s).share;
+	}
+	if (total <= 0.0) return -1.0;
+	done += stages_.at(current_).share * within_;
+	return done/total;
+}
+
+QString ProgressParser::stage()
+{
+	if (current_ < 0) return "";
+	return stages_.at(current_).name;
+}
+
+qint64 ProgressParser::eta(qint64 elapsed)
+{
+	double f = fraction();
+	if (f < 0.02) return -1; // too early to extrapolate
+	return (qint64) (elapsed*(1.0-f)/f);
+}
+
+// Updates the learnt stage shares with this run's timings
+void ProgressParser::finish(qint64 elapsed)
+{
+	if (current_ < 0 || elapsed < MIN_LEARNING_TIME) return;
+	
+	for (int s=0;s<stages_.size();s++){
+		double observed=0.0;
+		if (stages_.at(s).start >= 0){
+			qint64 end = elapsed;
+			for (int n=s+1;n<stages_.size();n++){
+				if (stages_.at(n).start >= 0){
+					end = stages_.at(n).start;
+					break;
+				}
+			}
+			observed = qMax((qint64) 0,end - stages_.at(s).start)/(double) elapsed;
+		}
+		double share = (1.0-LEARNING_RATE)*stages_.at(s).share + LEARNING_RATE*observed;
+		history_.insert(toolName_ + "\t" + stages_.at(s).name,share);
+	}
+	saveHistory();
+}
+
+//
+//	Protected
+//
+
+// Stages are added in the order they run, with a default share of the run time
+void ProgressParser::addStage(const QString &name,double defaultShare)
+{
+	Stage s;
+	s.name=name;
+	s.share=history_.value(toolName_ + "\t" + name,defaultShare);
+	s.start=-1;
+	stages_.append(s);
+}
+
+void ProgressParser::setProgress(const QString &name,double within)
+{
+	int s=0;
+	while (s < stages_.size() && stages_.at(s).name != name)
+		s++;
+	if (s == stages_.size() || s < current_) return; // unknown, or already past it
+	
+	if (s > current_){ // stages in between were skipped, and keep start=-1
+		stages_[s].start = timer_.elapsed();
+		current_=s;
+		changed_=true;
+	}
+	within_ = qBound(0.0,within,1.0);
+}
+
+//
+//	Private
+//
+
+void ProgressParser::parseLines(bool final,QStringList &messages)
+{
+	int start=0;
+	for (int i=0;i<partial_.size();i++){
+		char c = partial_.at(i);
+		if (c == '\n' || c == '\r'){
+			QString line = QString::fromLocal8Bit(partial_.constData() + start,i-start).trimmed();
+			if (!line.isEmpty() && !parseLine(line))
+				messages.append(line);
+			start=i+1;
+		}
+	}
+	partial_.remove(0,start);
+	
+	if (final && !partial_.isEmpty()){
+		QString line = QString::fromLocal8Bit(partial_).trimmed();
+		if (!line.isEmpty() && !parseLine(line))
+			messages.append(line);
+		partial_.clear();
+	}
+}
+
+void ProgressParser::loadHistory()
+{
+	historyLoaded_=true;
+	QFile f(app->applicationTmpPath() + "/progress.txt");
+	if (!f.open(QIODevice::ReadOnly)) return;
+	QTextStream ts(&f);
+	while (!ts.atEnd()){
+		QStringList fields = ts.readLine().split('\t');
+		if (fields.size() == 3)
+			history_.insert(fields.at(0) + "\t" + fields.at(1),fields.at(2).toDouble());
+	}
+}
+
+void ProgressParser::saveHistory()
+{
+	QSaveFile f(app->applicationTmpPath() + "/progress.txt");
+	if (!f.open(QIODevice::WriteOnly)){
+		qWarning() << warning.header(__PRETTY_FUNCTION__) << f.errorString();
+		return;
+	}
+	QTextStream ts(&f);
+	QHash<QString,double>::const_iterator it;
+	for (it=history_.constBegin();it!=history_.constEnd();++it)
+		ts << it.key() << "\t" << it.value() << "\n";
+	ts.flush();
+	f.commit();
+}
+
+//
+//	ClustalOProgressParser
+//
+
+// eg "Progressive alignment progress: 45 % (44 out of 97)" and "Progressive alignment progress done. CPU time: ..."
+ClustalOProgressParser::ClustalOProgressParser():ProgressParser("clustalo"),progressRx_("^(.+) progress(?:: (\\d+) %| done)")
+{
+	addStage("Ktuple-distance calculation",0.3);
+	addStage("Distance calculation within sub-clusters",0.1);
+	addStage("Progressive alignment",0.6);
+}
+
+bool ClustalOProgressParser::parseLine(const QString &line)
+{
+	if (progressRx_.indexIn(line) != 0) return false;
+	
+	bool done = progressRx_.cap(2).isEmpty();
+	setProgress(progressRx_.cap(1),done ? 1.0 : progressRx_.cap(2).toInt()/100.0);
+	return !done; // the "done" line, with its timing, is worth keeping
+}
+
+//
+//	MAFFTProgressParser
+//
+
+// MAFFT prints a heading for each stage, followed by counters like "  10 / 100" or "STEP    10 / 99 f".
+// The FFT-NS-2 strategy makes two passes, each building a guide tree and aligning along it.
+MAFFTProgressParser::MAFFTProgressParser():ProgressParser("MAFFT"),
+	counterRx_("^(\\d+)\\s*/\\s*(\\d+)"),stepRx_("^STEP\\s+(\\d+)\\s*/\\s*(\\d+)"),iterationRx_("^STEP\\s+\\d+-\\d+-\\d+")
+{
+	pass_=1;
+	addStage("distance 1",0.2);
+	addStage("tree 1",0.05);
+	addStage("progressive 1",0.25);
+	addStage("distance 2",0.2);
+	addStage("tree 2",0.05);
+	addStage("progressive 2",0.25);
+	addStage("refinement",0.0); // the number of iterations isn't known, so this is learnt
+}
+
+bool MAFFTProgressParser::parseLine(const QString &line)
+{
+	if (iterationRx_.indexIn(line) == 0){
+		setProgress("refinement",0.0);
+		return true;
+	}
+	if (stepRx_.indexIn(line) == 0 || counterRx_.indexIn(line) == 0){
+		QRegExp &rx = (stepRx_.matchedLength() > 0 ? stepRx_ : counterRx_);
+		int total = rx.cap(2).toInt();
+		if (!heading_.isEmpty() && total > 0)
+			setProgress(heading_,rx.cap(1).toDouble()/total);
+		return true;
+	}
+	
+	if (line.startsWith("Making a distance matrix")){
+		if (line.contains("from msa"))
+			pass_=2;
+		heading_ = "distance " + QString::number(pass_);
+	}
+	else if (line.startsWith("Constructing a UPGMA tree"))
+		heading_ = "tree " + QString::number(pass_);
+	else if (line.startsWith("Progressive alignment")){
+		QRegExp passRx("(\\d+)/\\d+");
+		if (passRx.indexIn(line) >= 0)
+			pass_ = qBound(1,passRx.cap(1).toInt(),2);
+		heading_ = "progressive " + QString::number(pass_);
+	}
+	else
+		return false;
+	
+	setProgress(heading_,0.0);
+	return false; // headings are kept in the log
+}
+
+//
+//	MuscleProgressParser
+//
+
+// eg "00:00:01    11 MB(1%)  Iter   1  100.00%  K-mer dist pass 1"
+// Iteration 1 is the progressive alignment, 2 refines the tree and 3 onwards (up to -maxiters, 16 by default)
+// refine the alignment
+MuscleProgressParser::MuscleProgressParser():ProgressParser("MUSCLE"),iterRx_("Iter\\s+(\\d+)\\s+([\\d.]+)%\\s+(.+)$")
+{
+	addStage("k-mer distances",0.1);
+	addStage("progressive",0.4);
+	addStage("tree refinement",0.2);
+	addStage("iterative refinement",0.3);
+}
+
+bool MuscleProgressParser::parseLine(const QString &line)
+{
+	if (iterRx_.indexIn(line) < 0) return false;
+	
+	int iter = iterRx_.cap(1).toInt();
+	double pct = iterRx_.cap(2).toDouble()/100.0;
+	QString what = iterRx_.cap(3).trimmed();
+	
+	if (iter == 1){
+		if (what.startsWith("K-mer dist pass"))
+			setProgress("k-mer distances",(what.endsWith("2") ? 0.5 : 0.0) + 0.5*pct);
+		else if (what.startsWith("Align node"))
+			setProgress("progressive",pct);
+		else if (what.startsWith("Root alignment"))
+			setProgress("progressive",1.0);
+	}
+	else if (iter == 2){
+		if (what.startsWith("Refine tree"))
+			setProgress("tree refinement",0.1*pct);
+		else if (what.startsWith("Align node"))
+			setProgress("tree refinement",0.1 + 0.9*pct);
+		else if (what.startsWith("Root alignment"))
+			setProgress("tree refinement",1.0);
+	}
+	else
+		setProgress("iterative refinement",qMin(1.0,(iter - 3 + pct)/14.0));
+	
+	return true;
+}
@@ -0,0 +1,143 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef __PROGRESS_PARSER_H_
+#define __PROGRESS_PARSER_H_
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QRegExp>
+#include <QString>
+#include <QStringList>
+
+// Follows an aligner's progress from its log output.
+// A run is divided into stages, each with a share of the total run time. The shares start from defaults
+// and are then learnt from the timings of previous runs, so the estimated fraction done, and the ETA, 
+// improve with use. Output is fed in as it arrives; lines which are not progress reports are passed back
+// as messages.
+
+class ProgressParser
+{
+	public:
+		
+		ProgressParser(const QString &);
+		virtual ~ProgressParser();
+		
+		void addData(const QByteArray &,QStringList &);
+		void flush(QStringList &);
+		
+		bool takeChanged(); // true if the progress has changed noticeably since the last call
+		
+		double fraction(); // of the run, -1 if unknown
+		QString stage();
+		qint64 eta(qint64); // remaining time in ms, given the elapsed time, -1 if unknown
+		
+		void finish(qint64); // the run finished, taking the given time in ms
+		
+	protected:
+	
+		virtual bool parseLine(const QString &)=0; // returns true if the line was a progress report
+		
+		void addStage(const QString &,double);
+		void setProgress(const QString &,double);
+		
+	private:
+	
+		struct Stage
+		{
+			QString name;
+			double share;
+			qint64 start; // ms, -1 if not reached
+		};
+		
+		void parseLines(bool,QStringList &);
+		
+		static void loadHistory();
+		static void saveHistory();
+		
+		QString toolName_;
+		QByteArray partial_;
+		QList<Stage> stages_;
+		int current_;
+		double within_;
+		double reported_;
+		bool changed_;
+		QElapsedTimer timer_;
+		
+		static QHash<QString,double> history_; // learnt shares, keyed by tool and stage
+		static bool historyLoaded_;
+};
+
+class ClustalOProgressParser:public ProgressParser
+{
+	public:
+		
+		ClustalOProgressParser();
+		
+	protected:
+		
+		virtual bool parseLine(const QString &);
+	
+	private:
+		
+		QRegExp progressRx_;
+};
+
+class MAFFTProgressParser:public ProgressParser
+{
+	public:
+		
+		MAFFTProgressParser();
+		
+	protected:
+		
+		virtual bool parseLine(const QString &);
+	
+	private:
+		
+		QString heading_;
+		int pass_;
+		QRegExp counterRx_,stepRx_,iterationRx_;
+};
+
+class MuscleProgressParser:public ProgressParser
+{
+	public:
+		
+		MuscleProgressParser();
+		
+	protected:
+		
+		virtual bool parseLine(const QString &);
+	
+	private:
+		
+		QRegExp iterRx_;
+};
+
+#endif
@@ -0,0 +1,597 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <QtDebug>
+#include "DebuggingInfo.h"
+
+#include <algorithm>
+
+#include <QElapsedTimer>
+#include <QtConcurrentMap>
+
+#include "ProgressiveAligner.h"
+
+#define GAP_CODE 0xFF
+#define MAX_PROFILE_CELLS 268435456 // a byte each for the traceback
+#define MAX_PAIRWISE_CELLS 8388608 // 32 MB for the pairwise aligner's H and E, per thread
+
+// Traceback flags, one byte per cell
+#define TB_H_DIAG 0x00
+#define TB_H_E    0x01
+#define TB_H_F    0x02
+#define TB_H_MASK 0x03
+#define TB_E_EXT  0x04
+#define TB_F_EXT  0x08
+
+#define NEG_INF (-1.0e30f)
+
+#define DISTANCE_SHARE 0.2 // of the run time, for reporting progress
+
+// Global alignment of two profiles with affine gaps (Gotoh).
+// sx holds, for each column of x, the expected substitution score against each residue type,
+// and fy holds the residue frequencies of each column of y, so that a column pair scores their dot product.
+// The alignment is returned as operations: 'M' (columns aligned), 'I' (column of x against gaps),
+// 'D' (column of y against gaps)
+static float profileGotoh(const float *sx,int xlen,const float *fy,int ylen,float gapOpen,float gapExtend,QByteArray &ops)
+{
+	int w = ylen+1;
+	unsigned char *tb = new unsigned char[(size_t)(xlen+1)*w];
+	float *H = new float[w];
+	float *F = new float[w];
+	
+	H[0]=0;
+	F[0]=NEG_INF;
+	tb[0]=TB_H_DIAG;
+	for (int j=1;j<=ylen;j++){
+		H[j] = -gapOpen - (j-1)*gapExtend;
+		F[j] = NEG_INF;
+		tb[j] = TB_H_E | (j > 1 ? TB_E_EXT : 0);
+	}
+	
+	for (int i=1;i<=xlen;i++){
+		unsigned char *tbRow = tb + (size_t) i*w;
+		const float *sxi = sx + (size_t)(i-1)*NUM_RESIDUE_TYPES;
+		float diag = H[0];
+		H[0] = -gapOpen - (i-1)*gapExtend;
+		tbRow[0] = TB_H_F | (i > 1 ? TB_F_EXT : 0);
+		float E=NEG_INF;
+		for (int j=1;j<=ylen;j++){
+			unsigned char t=0;
+			
+			float eOpen = H[j-1] - gapOpen;
+			float eExt = E - gapExtend;
+			if (eExt > eOpen){
+				E=eExt;
+				t |= TB_E_EXT;
+			}
+			else
+				E=eOpen;
+			
+			float fOpen = H[j] - gapOpen;
+			float fExt = F[j] - gapExtend;
+			if (fExt > fOpen){
+				F[j]=fExt;
+				t |= TB_F_EXT;
+			}
+			else
+				F[j]=fOpen;
+			
+			const float *fyj = fy + (size_t)(j-1)*NUM_RESIDUE_TYPES;
+			float s=0;
+			for (int r=0;r<NUM_RESIDUE_TYPES;r++)
+				s += sxi[r]*fyj[r];
+			
+			float h = diag + s;
+			if (E > h){
+				h=E;
+				t |= TB_H_E;
+			}
+			if (F[j] > h){
+				h=F[j];
+				t = (t & ~TB_H_MASK) | TB_H_F;
+			}
+			diag = H[j];
+			H[j]=h;
+			tbRow[j]=t;
+		}
+	}
+	
+	float best = H[ylen];
+	
+	ops.clear();
+	int i=xlen,j=ylen;
+	int state=TB_H_DIAG;
+	while (i > 0 || j > 0){
+		unsigned char t = tb[(size_t) i*w + j];
+		if (state == TB_H_DIAG){
+			int src = t & TB_H_MASK;
+			if (src == TB_H_DIAG){
+				ops.append('M');
+				i--;
+				j--;
+			}
+			else
+				state=src;
+		}
+		else if (state == TB_H_E){
+			ops.append('D');
+			j--;
+			if (!(t & TB_E_EXT)) state=TB_H_DIAG;
+		}
+		else{
+			ops.append('I');
+			i--;
+			if (!(t & TB_F_EXT)) state=TB_H_DIAG;
+		}
+	}
+	std::reverse(ops.begin(),ops.end());
+	
+	delete[] tb;
+	delete[] H;
+	delete[] F;
+	return best;
+}
+
+//
+//	Public members
+//	
+
+ProgressiveAligner::ProgressiveAligner(PairwiseAligner::Scoring s):pairwise_(s)
+{
+	k_ = (s == PairwiseAligner::Protein) ? 3 : 6;
+	dist_=NULL;
+	nodeData_=NULL;
+	cancel_=NULL;
+	progress_=NULL;
+	progressFrom_=0.0;
+	progressTo_=1.0;
+}
+
+ProgressiveAligner::~ProgressiveAligner()
+{
+	delete[] dist_;
+}
+
+// Guesses the sequence type: mostly A,C,G,T/U and N is DNA
+PairwiseAligner::Scoring ProgressiveAligner::guessScoring(const QStringList &seqs)
+{
+	qint64 nres=0,nNucleotides=0;
+	for (int s=0;s<seqs.size();s++){
+		const QString &seq = seqs.at(s);
+		for (int i=0;i<seq.size();i++){
+			char c = seq.at(i).toUpper().toLatin1();
+			if (c == '-' || c == '.') continue;
+			nres++;
+			if (c == 'A' || c == 'C' || c == 'G' || c == 'T' || c == 'U' || c == 'N')
+				nNucleotides++;
+		}
+	}
+	return (nres > 0 && nNucleotides >= 0.9*nres) ? PairwiseAligner::DNA : PairwiseAligner::Protein;
+}
+
+// Aligns seqs, returning the aligned sequences in the same order.
+// Gaps in the input are ignored
+bool ProgressiveAligner::align(const QStringList &seqs,QStringList &aligned,QString &errmsg,QAtomicInt *cancel,QAtomicInt *progress)
+{
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << seqs.size() << "sequences";
+	
+	cancel_=cancel;
+	progress_=progress;
+	int n = seqs.size();
+	aligned.clear();
+	if (n == 0){
+		errmsg = "There are no sequences to align";
+		return false;
+	}
+	
+	QVector<QByteArray> codes(n);
+	residues_.resize(n);
+	kmers_.resize(n);
+	nodes_.clear();
+	nodes_.reserve(2*n-1);
+	for (int s=0;s<n;s++){
+		pairwise_.encode(seqs.at(s),codes[s],residues_[s]);
+		kmers_[s].clear();
+		findKmers(codes.at(s),kmers_[s]);
+		std::sort(kmers_[s].begin(),kmers_[s].end());
+		
+		Node leaf;
+		leaf.left=leaf.right=-1;
+		leaf.height=0;
+		leaf.members.append(s);
+		leaf.rows.append(codes.at(s));
+		nodes_.append(leaf);
+	}
+	
+	return alignLeaves(aligned,errmsg);
+}
+
+// Merges alignments, each given as rows of equal length, by aligning them as profiles.
+// The columns within each alignment are kept. The rows are returned in the order given
+bool ProgressiveAligner::mergeProfiles(const QList<QStringList> &profiles,QStringList &aligned,QString &errmsg,
+	QAtomicInt *cancel,QAtomicInt *progress)
+{
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << profiles.size() << "profiles";
+	
+	cancel_=cancel;
+	progress_=progress;
+	int np = profiles.size();
+	aligned.clear();
+	if (np == 0){
+		errmsg = "There are no alignments to merge";
+		return false;
+	}
+	
+	residues_.clear();
+	kmers_.resize(np);
+	nodes_.clear();
+	nodes_.reserve(2*np-1);
+	for (int p=0;p<np;p++){
+		const QStringList &prof = profiles.at(p);
+		if (prof.isEmpty()){
+			errmsg = "An alignment to be merged is empty";
+			return false;
+		}
+		int len = prof.first().size();
+		
+		Node leaf;
+		leaf.left=leaf.right=-1;
+		leaf.height=0;
+		// The k-mers of the whole alignment, without repeats, so that a large alignment doesn't dominate
+		QVector<quint32> &km = kmers_[p];
+		km.clear();
+		for (int r=0;r<prof.size();r++){
+			const QString &row = prof.at(r);
+			if (row.size() != len){
+				errmsg = "The rows of an alignment to be merged differ in length";
+				return false;
+			}
+			QByteArray codes;
+			QString res;
+			pairwise_.encode(row,codes,res);
+			findKmers(codes,km);
+			
+			QByteArray gapped(len,(char) GAP_CODE);
+			int k=0;
+			for (int c=0;c<len;c++){
+				char ch = row.at(c).toLatin1();
+				if (ch != '-' && ch != '.' && ch != ' ')
+					gapped[c] = codes.at(k++);
+			}
+			leaf.members.append(residues_.size());
+			leaf.rows.append(gapped);
+			residues_.append(res);
+		}
+		std::sort(km.begin(),km.end());
+		km.erase(std::unique(km.begin(),km.end()),km.end());
+		nodes_.append(leaf);
+	}
+	
+	return alignLeaves(aligned,errmsg);
+}
+
+//
+//	Private members
+//	
+
+// Builds the guide tree over the leaves in nodes_, from their k-mers, and aligns up it
+bool ProgressiveAligner::alignLeaves(QStringList &aligned,QString &errmsg)
+{
+	tooLong_=0;
+	int n = nodes_.size();
+	
+	QElapsedTimer timer;
+	timer.start();
+	setProgress(0.0);
+	
+	QVector<Task> tasks(n);
+	for (int s=0;s<n;s++){
+		tasks[s].aligner=this;
+		tasks[s].index=s;
+	}
+	
+	delete[] dist_;
+	dist_ = new float[(size_t) n*n];
+	QtConcurrent::blockingMap(tasks,distanceRow);
+	kmers_.clear();
+	qint64 tDist = timer.elapsed();
+	
+	if (cancelled()){
+		errmsg = "Cancelled";
+		return false;
+	}
+	
+	buildGuideTree();
+	delete[] dist_;
+	dist_=NULL;
+	qint64 tTree = timer.elapsed();
+	setProgress(DISTANCE_SHARE);
+	
+	// Nodes at the same height are independent, so each level is aligned in parallel
+	nodeData_ = nodes_.data();
+	int maxHeight = nodes_.last().height;
+	for (int h=1;h<=maxHeight && !cancelled() && !tooLong_.load();h++){
+		tasks.clear();
+		for (int nd=n;nd<nodes_.size();nd++){
+			if (nodes_.at(nd).height == h){
+				Task t;
+				t.aligner=this;
+				t.index=nd;
+				tasks.append(t);
+			}
+		}
+		QtConcurrent::blockingMap(tasks,alignNode);
+		setProgress(DISTANCE_SHARE + (1.0-DISTANCE_SHARE)*h/maxHeight);
+	}
+	
+	if (cancelled()){
+		errmsg = "Cancelled";
+		return false;
+	}
+	if (tooLong_.load()){
+		errmsg = "The sequences are too long to align in memory";
+		return false;
+	}
+	
+	// Turn the residue types back into the residues
+	Node &root = nodes_.last();
+	QVector<QString> out(residues_.size());
+	for (int r=0;r<root.rows.size();r++){
+		int m = root.members.at(r);
+		const QByteArray &row = root.rows.at(r);
+		const QString &res = residues_.at(m);
+		QString &o = out[m];
+		o.reserve(row.size());
+		int k=0;
+		for (int c=0;c<row.size();c++){
+			if ((unsigned char) row.at(c) == GAP_CODE)
+				o.append(QChar('-'));
+			else
+				o.append(res.at(k++));
+		}
+	}
+	for (int s=0;s<out.size();s++)
+		aligned.append(out.at(s));
+	
+	nodes_.clear();
+	residues_.clear();
+	
+	qInfo() << benchmark.header(__PRETTY_FUNCTION__) << n << "leaves," << out.size() << "sequences" << "distances" << tDist << "ms"
+		<< "tree" << tTree - tDist << "ms" << "total" << timer.elapsed() << "ms";
+	return true;
+}
+
+// Appends the k-mers of a sequence of residue types
+void ProgressiveAligner::findKmers(const QByteArray &c,QVector<quint32> &km)
+{
+	quint32 base = (k_ == 3) ? NUM_RESIDUE_TYPES : 5;
+	for (int i=0;i+k_<=c.size();i++){
+		quint32 h=0;
+		for (int j=0;j<k_;j++)
+			h = h*base + qMin((quint32)(unsigned char) c.at(i+j),base-1);
+		km.append(h);
+	}
+}
+
+void ProgressiveAligner::setProgress(double f)
+{
+	if (progress_ != NULL)
+		progress_->store(qRound((progressFrom_ + f*(progressTo_ - progressFrom_))*1000.0));
+}
+
+// Distances from row i to the sequences before it, from the fraction of shared k-mers
+void ProgressiveAligner::distanceRow(Task &t)
+{
+	ProgressiveAligner *pa = t.aligner;
+	if (pa->cancelled()) return;
+	
+	int n = pa->kmers_.size();
+	int i = t.index;
+	const QVector<quint32> &ki = pa->kmers_.at(i);
+	pa->dist_[(size_t) i*n + i]=0.0;
+	for (int j=0;j<i;j++){
+		const QVector<quint32> &kj = pa->kmers_.at(j);
+		int shared=0;
+		int a=0,b=0;
+		while (a < ki.size() && b < kj.size()){
+			if (ki.at(a) < kj.at(b))
+				a++;
+			else if (kj.at(b) < ki.at(a))
+				b++;
+			else{
+				shared++;
+				a++;
+				b++;
+			}
+		}
+		int nmin = qMin(ki.size(),kj.size());
+		float d = (nmin > 0) ? 1.0 - (float) shared/nmin : 1.0;
+		pa->dist_[(size_t) i*n + j] = d;
+		pa->dist_[(size_t) j*n + i] = d;
+	}
+}
+
+// UPGMA over the leaves, keeping the nearest neighbour of each cluster so that each merge is usually linear in the number of clusters
+void ProgressiveAligner::buildGuideTree()
+{
+	int n = nodes_.size(); // the leaves
+	
+	// Each slot holds a cluster. A merged cluster takes the slot of one of its children
+	QVector<int> slotNode(n),slotSize(n),nn(n);
+	QVector<float> nnDist(n);
+	QVector<bool> active(n,true);
+	for (int s=0;s<n;s++){
+		slotNode[s]=s;
+		slotSize[s]=1;
+	}
+	
+	for (int s=0;s<n;s++){
+		nn[s]=-1;
+		nnDist[s]=1.0e30;
+		for (int t=0;t<n;t++){
+			if (t != s && dist_[(size_t) s*n + t] < nnDist[s]){
+				nnDist[s]=dist_[(size_t) s*n + t];
+				nn[s]=t;
+			}
+		}
+	}
+	
+	for (int merge=0;merge<n-1;merge++){
+		int a=-1;
+		for (int s=0;s<n;s++){
+			if (active.at(s) && nn.at(s) >= 0 && (a < 0 || nnDist.at(s) < nnDist.at(a)))
+				a=s;
+		}
+		int b = nn.at(a);
+		
+		Node node;
+		node.left=slotNode.at(a);
+		node.right=slotNode.at(b);
+		node.height = 1 + qMax(nodes_.at(node.left).height,nodes_.at(node.right).height);
+		nodes_.append(node);
+		
+		int sa = slotSize.at(a),sb = slotSize.at(b);
+		for (int k=0;k<n;k++){
+			if (!active.at(k) || k == a || k == b) continue;
+			float d = (sa*dist_[(size_t) a*n + k] + sb*dist_[(size_t) b*n + k])/(sa+sb);
+			dist_[(size_t) a*n + k]=d;
+			dist_[(size_t) k*n + a]=d;
+		}
+		active[b]=false;
+		slotNode[a]=nodes_.size()-1;
+		slotSize[a]=sa+sb;
+		
+		for (int k=0;k<n;k++){
+			if (!active.at(k)) continue;
+			if (k == a || nn.at(k) == a || nn.at(k) == b){
+				nn[k]=-1;
+				nnDist[k]=1.0e30;
+				for (int t=0;t<n;t++){
+					if (t != k && active.at(t) && dist_[(size_t) k*n + t] < nnDist.at(k)){
+						nnDist[k]=dist_[(size_t) k*n + t];
+						nn[k]=t;
+					}
+				}
+			}
+			else if (dist_[(size_t) k*n + a] < nnDist.at(k)){
+				nnDist[k]=dist_[(size_t) k*n + a];
+				nn[k]=a;
+			}
+		}
+	}
+}
+
+// Aligns the profiles of a node's children.
+// Two unaligned sequences are aligned by the pairwise aligner, which gives the same alignment as profileGotoh()
+// but can use SIMD. It keeps four bytes a cell rather than one, and every thread in the pool may be doing this,
+// so larger pairs go through profileGotoh()
+void ProgressiveAligner::alignNode(Task &t)
+{
+	ProgressiveAligner *pa = t.aligner;
+	if (pa->cancelled() || pa->tooLong_.load()) return;
+	
+	Node &node = pa->nodeData_[t.index];
+	Node &x = pa->nodeData_[node.left];
+	Node &y = pa->nodeData_[node.right];
+	int xlen = x.rows.first().size();
+	int ylen = y.rows.first().size();
+	
+	QByteArray ops;
+	if (x.rows.size() == 1 && y.rows.size() == 1 && xlen > 0 && ylen > 0 && (qint64)(xlen+1)*(ylen+1) <= MAX_PAIRWISE_CELLS &&
+		!x.rows.first().contains((char) GAP_CODE) && !y.rows.first().contains((char) GAP_CODE)){
+		PairwiseAligner pairwise(pa->pairwise_); // one each, since the threads share pairwise_
+		pairwise.setMode(PairwiseAligner::Global);
+		int aStart,bStart;
+		QString errmsg;
+		if (!pairwise.alignCodes(x.rows.first(),y.rows.first(),ops,aStart,bStart,errmsg))
+			ops.clear(); // try profileGotoh()
+	}
+	
+	if (ops.isEmpty()){
+		if ((qint64)(xlen+1)*(ylen+1) > MAX_PROFILE_CELLS){
+			pa->tooLong_=1;
+			return;
+		}
+		QVector<float> sx,fy;
+		pa->profileScores(x,sx);
+		pa->profileFrequencies(y,fy);
+		profileGotoh(sx.constData(),xlen,fy.constData(),ylen,pa->pairwise_.gapOpen(),pa->pairwise_.gapExtend(),ops);
+	}
+	
+	node.members = x.members + y.members;
+	for (int r=0;r<x.rows.size() + y.rows.size();r++){
+		bool inX = r < x.rows.size();
+		const QByteArray &src = inX ? x.rows.at(r) : y.rows.at(r - x.rows.size());
+		QByteArray row(ops.size(),(char) GAP_CODE);
+		int c=0;
+		for (int o=0;o<ops.size();o++){
+			// 'I' is a column of x against gaps in y, and 'D' the reverse
+			char op = ops.at(o);
+			if (op == 'M' || (op == 'I' && inX) || (op == 'D' && !inX))
+				row[o] = src.at(c++);
+		}
+		node.rows.append(row);
+	}
+	
+	// The children are no longer needed
+	x.rows.clear();
+	y.rows.clear();
+}
+
+// For each column, the expected substitution score against each residue type
+void ProgressiveAligner::profileScores(Node &node,QVector<float> &scores)
+{
+	QVector<float> freqs;
+	profileFrequencies(node,freqs);
+	int len = node.rows.first().size();
+	scores.fill(0.0,len*NUM_RESIDUE_TYPES);
+	for (int c=0;c<len;c++){
+		const float *f = freqs.constData() + c*NUM_RESIDUE_TYPES;
+		float *s = scores.data() + c*NUM_RESIDUE_TYPES;
+		for (int a=0;a<NUM_RESIDUE_TYPES;a++){
+			if (f[a] == 0.0) continue;
+			for (int b=0;b<NUM_RESIDUE_TYPES;b++)
+				s[b] += f[a]*pairwise_.substitution(a,b);
+		}
+	}
+}
+
+// For each column, the frequency of each residue type. Gaps are not counted, so they score zero
+void ProgressiveAligner::profileFrequencies(Node &node,QVector<float> &freqs)
+{
+	int len = node.rows.first().size();
+	int nrows = node.rows.size();
+	freqs.fill(0.0,len*NUM_RESIDUE_TYPES);
+	float w = 1.0/nrows;
+	for (int r=0;r<nrows;r++){
+		const QByteArray &row = node.rows.at(r);
+		for (int c=0;c<len;c++){
+			unsigned char code = row.at(c);
+			if (code != GAP_CODE)
+				freqs[c*NUM_RESIDUE_TYPES + code] += w;
+		}
+	}
+}
@@ -0,0 +1,101 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef __PROGRESSIVE_ALIGNER_H_
+#define __PROGRESSIVE_ALIGNER_H_
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "PairwiseAligner.h"
+
+// A progressive multiple sequence aligner which runs in-process.
+// Distances are estimated from shared k-mers, a guide tree is built from them by UPGMA,
+// and then profiles are aligned, following the tree from the leaves.
+// The distances, and the profile alignments at each level of the tree, are computed on the thread pool.
+// Existing alignments can be merged in the same way, by starting from them as the leaves of the tree.
+
+class ProgressiveAligner
+{
+	public:
+		
+		ProgressiveAligner(PairwiseAligner::Scoring s=PairwiseAligner::Protein);
+		~ProgressiveAligner();
+		
+		static PairwiseAligner::Scoring guessScoring(const QStringList &);
+		
+		bool align(const QStringList &,QStringList &,QString &,QAtomicInt *cancel=NULL,QAtomicInt *progress=NULL);
+		bool mergeProfiles(const QList<QStringList> &,QStringList &,QString &,QAtomicInt *cancel=NULL,QAtomicInt *progress=NULL);
+		
+		void setProgressRange(double from,double to){progressFrom_=from;progressTo_=to;} // when part of a larger run
+		
+	private:
+		
+		struct Node
+		{
+			int left,right; // -1 for a leaf
+			int height;
+			QVector<int> members;
+			QVector<QByteArray> rows; // residue types, with gaps
+		};
+		
+		struct Task
+		{
+			ProgressiveAligner *aligner;
+			int index;
+		};
+		
+		static void distanceRow(Task &);
+		static void alignNode(Task &);
+		
+		bool alignLeaves(QStringList &,QString &);
+		void findKmers(const QByteArray &,QVector<quint32> &);
+		void buildGuideTree();
+		void profileScores(Node &,QVector<float> &);
+		void profileFrequencies(Node &,QVector<float> &);
+		bool cancelled(){return cancel_ != NULL && cancel_->load() != 0;}
+		void setProgress(double);
+		
+		PairwiseAligner pairwise_;
+		int k_;
+		
+		QVector<QString> residues_;
+		QVector<QVector<quint32> > kmers_;
+		float *dist_;
+		QVector<Node> nodes_;
+		Node *nodeData_; // for the worker threads
+		
+		QAtomicInt *cancel_;
+		QAtomicInt *progress_; // per mille
+		double progressFrom_,progressTo_;
+		QAtomicInt tooLong_;
+};
+
+#endif
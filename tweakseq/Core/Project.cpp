@@ -28,27 +28,43 @@
 #include "DebuggingInfo.h"
 
 #include <QDomDocument>
+#include <QEventLoop>
 #include <QFileDialog>
 #include <QFileInfo>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QProgressDialog>
+#include <QSet>
+#include <QTimer>
 #include <QTextStream>
+#include <QVector>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
 
+#include "A3MFile.h"
 #include "AddInsertionsCmd.h"
 #include "AlignmentCmd.h"
 #include "AlignmentTool.h"
 #include "Application.h"
+#include "BuiltInAligner.h"
 #include "ClustalFile.h"
 #include "ClustalO.h"
+#include "ColumnWindow.h"
 #include "CutResiduesCmd.h"
 #include "CutSequencesCmd.h"
 #include "ExcludeResiduesCmd.h"
+#include "ExportJob.h"
 #include "FASTAFile.h"
+#include "FASTAIndex.h"
 #include "GroupCmd.h"
 #include "ImportCmd.h"
 #include "MAFFT.h"
+#include "MappedAlignment.h"
 #include "Muscle.h"
 #include "PasteCmd.h"
 #include "PDBFile.h"
 #include "Project.h"
+#include "RealignColumnsCmd.h"
 #include "RenameCmd.h"
 #include "ResidueSelection.h"
 #include "SearchResult.h"
@@ -61,6 +77,52 @@
 
 extern Application *app;
 
+// The result of reading one file during an import
+struct ImportedFile
+{
+	QString fname;
+	bool identified;
+	bool ok;
+	QStringList seqnames,seqs,comments;
+	Structure structure;
+};
+
+// Reads a single file. Each call uses its own file readers so that files can be read concurrently
+static ImportedFile readSequenceFile(const QString &f)
+{
+	ImportedFile imp;
+	imp.fname = f;
+	imp.identified = true;
+	imp.ok = false;
+	
+	QString fname = f;
+	FASTAFile ff;
+	ClustalFile cf;
+	A3MFile af;
+	PDBFile pf;
+	
+	if (ff.isValidFormat(fname)){
+		ff.setName(fname);
+		imp.ok = ff.read(imp.seqnames,imp.seqs,imp.comments);
+	}
+	else if (cf.isValidFormat(fname)){
+		cf.setName(fname);
+		imp.ok = cf.read(imp.seqnames,imp.seqs,imp.comments);
+	}
+	else if (af.isValidFormat(fname)){
+		af.setName(fname);
+		imp.ok = af.read(imp.seqnames,imp.seqs,imp.comments);
+	}
+	else if (pf.isValidFormat(fname)){
+		pf.setName(fname);
+		imp.ok = pf.read(imp.seqnames,imp.seqs,imp.comments,&(imp.structure));
+	}
+	else
+		imp.identified = false;
+	
+	return imp;
+}
+
 //
 // Public members
 //	
@@ -84,6 +146,7 @@ Project::~Project()
 	if (muscleTool_) delete muscleTool_;
 	if (clustalOTool_) delete clustalOTool_;
 	if (mafftTool_) delete mafftTool_;
+	delete builtInTool_;
 }
 
 void Project::setMainWindow(SeqEditMainWin *mainwin)
@@ -123,83 +186,178 @@ void Project::setAligned(bool a)
 
 bool Project::importSequences(QStringList &files,QString &errmsg)
 {
-	FASTAFile ff;
-	ClustalFile cf;
-	PDBFile pf;
-	Structure structure;
+	// The files are parsed concurrently and the results merged in the order the files were given
+	QFuture<ImportedFile> future = QtConcurrent::mapped(files,readSequenceFile);
 	
-	for (int f=0;f<files.size();f++){
-		QString fname = files.at(f);
-		bool ok = false;
-		QStringList seqnames,seqs,comments;
-		
-		if (ff.isValidFormat(fname)){
-			ff.setName(fname);
-			ok = ff.read(seqnames,seqs,comments);
-		}
-		else if (cf.isValidFormat(fname)){
-			cf.setName(fname);
-			ok = cf.read(seqnames,seqs,comments);
+	if (mainWindow_ != NULL){
+		QProgressDialog progress("Importing sequences ...","Cancel",0,files.size(),mainWindow_);
+		progress.setWindowModality(Qt::WindowModal);
+		progress.setMinimumDuration(500);
+		QFutureWatcher<ImportedFile> watcher;
+		QEventLoop loop;
+		connect(&watcher,SIGNAL(progressValueChanged(int)),&progress,SLOT(setValue(int)));
+		connect(&progress,SIGNAL(canceled()),&watcher,SLOT(cancel()));
+		connect(&watcher,SIGNAL(finished()),&loop,SLOT(quit()));
+		watcher.setFuture(future);
+		loop.exec();
+	}
+	future.waitForFinished();
+	
+	if (future.isCanceled()){
+		errmsg = "The import was canceled";
+		emit uiUpdatesEnabled(true);
+		return false;
+	}
+	
+	QList<ImportedFile> imported = future.results();
+	return addImportedSequences(imported,errmsg);
+}
+
+// Loads the index for a FASTA file, building it if necessary
+bool Project::loadFASTAIndex(FASTAIndex &idx,QString &errmsg)
+{
+	if (idx.load())
+		return true;
+	
+	// A one pass build can still take a while for very large files so it's done in the background
+	QFuture<bool> future = QtConcurrent::run(&idx,&FASTAIndex::build);
+	if (mainWindow_ != NULL){
+		QProgressDialog progress("Indexing " + idx.fileName() + " ...","Cancel",0,100,mainWindow_);
+		progress.setWindowModality(Qt::WindowModal);
+		progress.setMinimumDuration(500);
+		while (!future.isFinished()){
+			if (progress.wasCanceled())
+				idx.cancel();
+			progress.setValue(idx.progress());
+			QEventLoop loop;
+			QTimer::singleShot(100,&loop,SLOT(quit()));
+			loop.exec();
 		}
-		else if (pf.isValidFormat(fname)){
-			pf.setName(fname);
-			ok = pf.read(seqnames,seqs,comments,&structure);
+	}
+	
+	if (!future.result()){
+		errmsg = idx.error();
+		return false;
+	}
+	return true;
+}
+
+// Imports the named records from an indexed FASTA file
+bool Project::importIndexedSequences(FASTAIndex &idx,const QStringList &names,QString &errmsg)
+{
+	QList<ImportedFile> imported;
+	ImportedFile imp;
+	imp.fname = idx.fileName();
+	imp.identified = true;
+	imp.ok = idx.fetch(names,imp.seqnames,imp.seqs,imp.comments);
+	if (!imp.ok){
+		errmsg = idx.error();
+		emit uiUpdatesEnabled(true);
+		return false;
+	}
+	imported.append(imp);
+	return addImportedSequences(imported,errmsg);
+}
+
+// Opens a FASTA alignment as a read-only, memory-mapped view, replacing any sequences
+bool Project::viewMappedAlignment(const QString &fname,QString &errmsg)
+{
+	MappedAlignment *m = new MappedAlignment(fname);
+	if (!loadFASTAIndex(m->index(),errmsg)){
+		delete m;
+		return false;
+	}
+	if (!m->open()){
+		errmsg = m->error();
+		delete m;
+		return false;
+	}
+	
+	emit uiUpdatesEnabled(false);
+	clearSearchResults();
+	undoStack_.clear();
+	sequences.setMapped(m);
+	dirty_=false; // nothing to save
+	emit uiUpdatesEnabled(true);
+	
+	if (mainWindow_ != NULL)
+		mainWindow_->setMappedView(fname);
+	return true;
+}
+
+// Adds the results of an import as a single undoable command
+bool Project::addImportedSequences(const QList<ImportedFile> &imported,QString &errmsg)
+{
+	// Check all the files before anything is imported, so that the import can be undone in one step
+	// The existing labels and the new ones go into one set for the duplicate check
+	QSet<QString> labels;
+	QList<Sequence *> &currseqs = sequences.sequences();
+	for (int i=0;i<currseqs.size();++i)
+		labels.insert(currseqs.at(i)->label); // FIXME? removed trimmed()
+	
+	QStringList dups;
+	int nseqs=0;
+	for (int f=0;f<imported.size();f++){
+		const ImportedFile &imp = imported.at(f);
+		if (!imp.identified){
+			errmsg = "Unable to identify " + imp.fname;
+			emit uiUpdatesEnabled(true);
+			return false;
 		}
-		else{
-			errmsg = "Unable to identify " + fname;
+		if (!imp.ok){
+			errmsg ="Error while trying to read " + imp.fname;
 			emit uiUpdatesEnabled(true);
 			return false;
 		}
-		
-		if (ok){
-			clearSearchResults();
-			
-			// Check for duplicates
-			qDebug() << trace.header() << "checking for duplicates";
-			QStringList currSeqNames;
-			QList<Sequence *> currseq = sequences.sequences();
-			for (int i=0;i<currseq.size();++i)
-				currSeqNames.append(currseq.at(i)->label); // FIXME? removed trimmed()
-			currSeqNames = currSeqNames + seqnames;
-			QStringList dups = findDuplicates(currSeqNames);
-			if (dups.size() > 0){
-				errmsg="There are duplicated sequences in the file being imported:\n";
-				for (int i=0; i< dups.size()-1;i++)
-					errmsg = errmsg + dups.at(i) + ",";
-				errmsg=errmsg+dups.last() + "\nYou will have to fix this.";
-				emit uiUpdatesEnabled(true);
-				return false;
-			}
-			
-			if (seqs.size() == 0){
-				errmsg="No sequences were imported";
-				emit uiUpdatesEnabled(true);
-				return false;
+		for (int i=0;i<imp.seqnames.size();i++){
+			const QString &l = imp.seqnames.at(i);
+			if (labels.contains(l)){
+				if (!dups.contains(l))
+					dups.append(l);
 			}
-			
-			emit uiUpdatesEnabled(false);
-			QList<Sequence *> newSeqs;
-			
-			for (int i=0;i<seqnames.size();i++){
-				Sequence * seq = new Sequence(seqnames.at(i),seqs.at(i),comments.at(i),fname,true);
-				newSeqs.append(seq);
-				if (!structure.isEmpty()){
-					seq->structureFile=fname;
-					seq->structure=structure;
-				}
-			}
-		
-			undoStack_.push(new ImportCmd(this,newSeqs,"sequence import"));
-			
-			qDebug() << trace.header(__PRETTY_FUNCTION__) << "added " << newSeqs.size();
-			
+			else
+				labels.insert(l);
 		}
-		else{
-			errmsg ="Error while trying to read " + fname;
-			emit uiUpdatesEnabled(true);
-			return false;
+		nseqs += imp.seqs.size();
+	}
+	
+	if (dups.size() > 0){
+		errmsg="There are duplicated sequences in the file being imported:\n";
+		for (int i=0; i< dups.size()-1;i++)
+			errmsg = errmsg + dups.at(i) + ",";
+		errmsg=errmsg+dups.last() + "\nYou will have to fix this.";
+		emit uiUpdatesEnabled(true);
+		return false;
+	}
+	
+	if (nseqs == 0){
+		errmsg="No sequences were imported";
+		emit uiUpdatesEnabled(true);
+		return false;
+	}
+	
+	clearSearchResults();
+	
+	emit uiUpdatesEnabled(false);
+	QList<Sequence *> newSeqs;
+	newSeqs.reserve(nseqs);
+	for (int f=0;f<imported.size();f++){
+		const ImportedFile &imp = imported.at(f);
+		for (int i=0;i<imp.seqnames.size() && i<imp.seqs.size();i++){
+			QString comment = (i < imp.comments.size() ? imp.comments.at(i) : QString()); // not all formats have comments
+			Sequence * seq = new Sequence(imp.seqnames.at(i),imp.seqs.at(i),comment,imp.fname,true);
+			newSeqs.append(seq);
+			if (!imp.structure.isEmpty()){
+				seq->structureFile=imp.fname;
+				seq->structure=imp.structure;
+			}
 		}
 	}
+	
+	undoStack_.push(new ImportCmd(this,newSeqs,"sequence import"));
+	
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << "added " << newSeqs.size() << " from " << imported.size() << " files";
+	
 	emit uiUpdatesEnabled(true);
 	return true;
 }
@@ -562,6 +720,18 @@ void Project::setAlignmentTool(const QString & atool)
 		alignmentTool_=muscleTool_;
 	else if (atool == "MAFFT" && mafftTool_)
 		alignmentTool_=mafftTool_;
+	else if (atool == "built-in")
+		alignmentTool_=builtInTool_;
+}
+
+QList<AlignmentTool *> Project::alignmentTools()
+{
+	QList<AlignmentTool *> tools;
+	if (clustalOTool_) tools.append(clustalOTool_);
+	if (muscleTool_) tools.append(muscleTool_);
+	if (mafftTool_) tools.append(mafftTool_);
+	tools.append(builtInTool_);
+	return tools;
 }
 
 //
@@ -669,6 +839,7 @@ bool Project::save(QString &fpathname)
 
 	// QSettings is not used because we want per-project settings
 	writeSettings(saveDoc,root);
+	runHistory.writeSettings(saveDoc,root); // not in writeSettings(), since that also makes the application defaults
 	
 	saveDoc.save(ts,2);
 	f.close();
@@ -699,7 +870,8 @@ void Project::load(QString &fname)
 		return ;
 	}
 	
-	mainWindow_->readSettings(doc); // do this first so no jarring geometry changes
+	if (mainWindow_ != NULL) // there's none when run headless
+		mainWindow_->readSettings(doc); // do this first so no jarring geometry changes
 	
 	QDomNodeList nl = doc.elementsByTagName("settings");
 	if (nl.count() == 1){
@@ -842,23 +1014,27 @@ void Project::load(QString &fname)
 
 	
 	readAlignmentToolSettings(doc);
+	runHistory.readSettings(doc);
 	
 	file.close();
 	dirty_=false;
 	empty_=false;
-	mainWindow_->postLoadTidy();
+	if (mainWindow_ != NULL)
+		mainWindow_->postLoadTidy();
 	
 }
 
 void Project::writeSettings(QDomDocument &doc,QDomElement &root)
 {
-	mainWindow_->writeSettings(doc,root);
+	if (mainWindow_ != NULL)
+		mainWindow_->writeSettings(doc,root);
 	if (clustalOTool_)
 		clustalOTool_->writeSettings(doc,root);
 	if (muscleTool_)
 		muscleTool_->writeSettings(doc,root);
 	if (mafftTool_)
 		mafftTool_->writeSettings(doc,root);;
+	builtInTool_->writeSettings(doc,root);
 }
 
 void Project::readSettings(QDomDocument &doc)
@@ -867,58 +1043,43 @@ void Project::readSettings(QDomDocument &doc)
 }
 
 
-void Project::exportFASTA(QString fname,bool removeExclusions)
-{
-
-	FASTAFile ff(fname);
-	QStringList l,seqs,c;
-	for (int s=0;s<sequences.size();s++){
-		l.append(sequences.sequences().at(s)->label);
-		seqs.append(sequences.sequences().at(s)->filter(removeExclusions));
-		c.append(sequences.sequences().at(s)->comment);
-	}
-	ff.write(l,seqs,c);
-}
-
-void Project::exportSelectionFASTA(QString fname,bool removeExclusions)
-{
-	FASTAFile ff(fname);
-	QStringList l,seqs,c;
-	
-	for (int s=0;s<sequenceSelection->size();s++){
-		l.append(sequenceSelection->itemAt(s)->label);
-		seqs.append(sequenceSelection->itemAt(s)->filter(removeExclusions));
-		c.append(sequenceSelection->itemAt(s)->comment);
-	}
-	ff.write(l,seqs,c);
-}
-
-void Project::exportClustalW(QString fname,bool removeExclusions)
+// Starts a background export of all sequences
+// The caller takes ownership of the job
+ExportJob *Project::startExport(QString fname,int format,bool removeExclusions,int lineWidth)
 {
-	ClustalFile cf(fname);
-	QStringList l,seqs,c;
+	ExportJob *job = new ExportJob(fname,format,removeExclusions);
+	job->setLineWidth(lineWidth);
 	for (int s=0;s<sequences.size();s++){
-		l.append(sequences.sequences().at(s)->label);
-		seqs.append(sequences.sequences().at(s)->filter(removeExclusions));
-		c.append(sequences.sequences().at(s)->comment);
+		Sequence *seq = sequences.sequences().at(s);
+		job->addRecord(seq->label,seq->residues,seq->comment);
 	}
-	cf.write(l,seqs,c);
+	job->start();
+	return job;
 }
 
-void Project::readNewAlignment(QString fname,bool isFullAlignment){
+// Replaces the current sequences with a new alignment, as an undoable command
+// If this is not a full alignment, the new sequences replace the selected ones
+// The aligned sequences are matched to the current ones through a label index, built once,
+// and the new order is applied in a single pass, so this is linear in the number of sequences
+void Project::readNewAlignment(const QStringList &newlabels,const QStringList &newseqs,bool isFullAlignment){
 	
 	qDebug() << trace.header(__PRETTY_FUNCTION__);
 	
-	FASTAFile fin(fname); // FIXME FASTA output is hardcoded at present but may be optional eventually
-	QStringList newlabels,newseqs,newcomments;
-	fin.read(newlabels,newseqs,newcomments);
-	
 	// No need to emit uiUpdatesEnabled(), because we are not modifying Project data here
 	
 	QList<Sequence *>      oldSeqs   = sequences.sequences();
 	QList<SequenceGroup *> oldGroups = sequenceGroups;
 	qDebug() << trace.header(__PRETTY_FUNCTION__) << oldSeqs.size() << " " << oldGroups.size();
-	Sequences newSequences;
+	
+	QHash<QString,int> oldIndex;
+	oldIndex.reserve(oldSeqs.size());
+	for (int s=0;s<oldSeqs.size();s++){
+		if (!oldIndex.contains(oldSeqs.at(s)->label))
+			oldIndex.insert(oldSeqs.at(s)->label,s);
+	}
+	
+	QVector<Sequence *> copies(oldSeqs.size(),NULL); // the new sequence made from each old one
+	QList<Sequence *> newSequences;
 	QList<SequenceGroup*> newGroups;
 		
 	if (isFullAlignment){
@@ -926,109 +1087,382 @@ void Project::readNewAlignment(QString fname,bool isFullAlignment){
 		aligned_=true;
 		
 		// Create the new sequences, in the order of the new alignment
+		newSequences.reserve(newseqs.size());
 		for (int snew=0;snew<newseqs.size();snew++){
-			Sequence *oldSeq = sequences.getSequence(newlabels.at(snew));
-			if (NULL != oldSeq){
+			int s = oldIndex.value(newlabels.at(snew),-1);
+			if (s >= 0 && NULL == copies.at(s)){
+				Sequence *oldSeq = oldSeqs.at(s);
 				Sequence *newSeq = new Sequence(newlabels.at(snew),newseqs.at(snew),oldSeq->comment,oldSeq->source,oldSeq->visible,oldSeq->structureFile);
 				// carry forward any extra information
 				newSeq->originalName=oldSeq->originalName;
 				newSeq->bookmarked=oldSeq->bookmarked;
 				newSeq->structure=oldSeq->structure;
+				copies[s]=newSeq;
 				newSequences.append(newSeq);
 			}
 			else{
 				qDebug() << trace.header(__PRETTY_FUNCTION__) << "missed " << newlabels.at(snew); 
 			}	
 		}
-	
-		// Recreate the groups for the new sequences
-		for (int g=0;g<oldGroups.size();g++){
-			SequenceGroup *newGroup = new SequenceGroup();
-			newGroup->setTextColour(oldGroups.at(g)->textColour());
-			newGroup->lock(oldGroups.at(g)->locked());
-			newGroups.append(newGroup);
-			for (int s=0;s<oldGroups.at(g)->size();s++){
-				Sequence *oldGroupedSeq=oldGroups.at(g)->itemAt(s);
-				Sequence *newGroupedSeq = newSequences.getSequence(oldGroupedSeq->label);
-				if (NULL!=newGroupedSeq){
-					newGroup->addSequence(newGroupedSeq);
-				}
-				else{
-					qDebug() << trace.header(__PRETTY_FUNCTION__) << "missed grouping " << oldGroupedSeq->label;
-				}
-			}
-			qDebug() << trace.header(__PRETTY_FUNCTION__) << "new group created with " << newGroup->size() << " members";
-		}
-		
 		
 	}
 	else{
 		
 		aligned_=false;
 		
-		SequenceSelection *sel = sequenceSelection;
-		
 		// Make a copy of the old sequences
 		for (int s=0;s<oldSeqs.size();s++){
 			Sequence *oldSeq = oldSeqs.at(s);
 			Sequence *newSeq = new Sequence(oldSeq->label,oldSeq->residues,oldSeq->comment,oldSeq->source,oldSeq->visible);
 			newSeq->bookmarked=oldSeq->bookmarked;
-			newSequences.append(newSeq);
+			copies[s]=newSeq;
 		}
 		
-		// Make a copy of the old groups
-		for (int g=0;g<oldGroups.size();g++){
-			SequenceGroup *newGroup = new SequenceGroup();
-			newGroup->setTextColour(oldGroups.at(g)->textColour());
-			newGroup->lock(oldGroups.at(g)->locked());
-			newGroups.append(newGroup);
-			for (int s=0;s<oldGroups.at(g)->size();s++){
-				Sequence *oldGroupedSeq=oldGroups.at(g)->itemAt(s);
-				Sequence *newGroupedSeq = newSequences.getSequence(oldGroupedSeq->label);
-				if (NULL!=newGroupedSeq){
-					newGroup->addSequence(newGroupedSeq);
-				}
-				else{
-					qDebug() << trace.header(__PRETTY_FUNCTION__) << "missed grouping " << oldGroupedSeq->label;
-				}
+		// Now update the aligned sequences with their new alignment.
+		// The labels are used rather than the current selection, since the selection
+		// may have changed while the alignment was running
+		QVector<bool> isAligned(oldSeqs.size(),false);
+		QList<Sequence *> alignedBlock;
+		for (int l=0;l<newlabels.size();l++){
+			int s = oldIndex.value(newlabels.at(l),-1);
+			if (s >= 0 && !isAligned.at(s)){
+				copies.at(s)->residues=newseqs.at(l);
+				isAligned[s]=true;
+				alignedBlock.append(copies.at(s));
 			}
-		qDebug() << trace.header(__PRETTY_FUNCTION__) << "new group created with " << newGroup->size() << " members";
+			else{
+				qDebug() << trace.header(__PRETTY_FUNCTION__) << "missed aligned sequence " << newlabels.at(l);
+			}
+		}
+		
+		// If the aligned sequences were contiguous, the aligned block, in its new order, goes where the first of them was.
+		// Otherwise (a group, whose members can be anywhere, for example) each one stays where it was,
+		// so that the other sequences aren't reordered
+		int firstAligned=-1,lastAligned=-1,nAligned=0;
+		for (int s=0;s<oldSeqs.size();s++){
+			if (!isAligned.at(s)) continue;
+			if (firstAligned < 0) firstAligned=s;
+			lastAligned=s;
+			nAligned++;
 		}
+		bool contiguous = (nAligned == lastAligned - firstAligned + 1);
 		
-		// Now update the selected sequences with their new alignment
-		// and put them in the right position
-		// The assumption is that the selection is contiguous
-		// so find the index of the first occurring selected sequence in the old alignment
-		int indexFirstSelSeq=-1;
+		newSequences.reserve(oldSeqs.size());
 		for (int s=0;s<oldSeqs.size();s++){
-			if (sel->contains(oldSeqs.at(s))){
-				indexFirstSelSeq =s;
+			if (!isAligned.at(s) || !contiguous)
+				newSequences.append(copies.at(s));
+			else if (s == firstAligned)
+				newSequences.append(alignedBlock);
+		}
+		if (firstAligned < 0)
+			qWarning() << warning.header(__PRETTY_FUNCTION__) << "none of the aligned sequences were found";
+		qDebug() << trace.header(__PRETTY_FUNCTION__) <<"first aligned sequence index=" << firstAligned << (contiguous ? "contiguous" : "in place");
+		
+	}
+	
+	// Recreate the groups for the new sequences
+	for (int g=0;g<oldGroups.size();g++){
+		SequenceGroup *newGroup = new SequenceGroup();
+		newGroup->setTextColour(oldGroups.at(g)->textColour());
+		newGroup->lock(oldGroups.at(g)->locked());
+		newGroups.append(newGroup);
+		for (int s=0;s<oldGroups.at(g)->size();s++){
+			Sequence *oldGroupedSeq=oldGroups.at(g)->itemAt(s);
+			int i = oldIndex.value(oldGroupedSeq->label,-1);
+			if (i >= 0 && NULL != copies.at(i)){
+				newGroup->addSequence(copies.at(i));
+			}
+			else{
+				qDebug() << trace.header(__PRETTY_FUNCTION__) << "missed grouping " << oldGroupedSeq->label;
+			}
+		}
+		qDebug() << trace.header(__PRETTY_FUNCTION__) << "new group created with " << newGroup->size() << " members";
+	}
+
+	// Pushing onto the stack triggers redo(), so this will finish things off (call setAlignment(), in particular
+	undoStack_.push(new AlignmentCmd(this,oldSeqs,oldGroups,newSequences,newGroups,aligned_,"alignment"));
+	
+}
+
+// Splices sequences which were added to the existing alignment back into it.
+// The aligner's output contains the existing sequences too, possibly with extra columns.
+// Each output column is mapped back to an existing column via the residues of the existing sequences.
+// Residues of the added sequences which fall in new columns get gap columns inserted into the existing
+// sequences, so nothing is lost and the existing columns keep their alignment.
+// (MAFFT's --keeplength drops such residues itself, so with MAFFT there are none)
+bool Project::readAddedSequences(const QStringList &labels,const QStringList &seqs,const QStringList &addedLabels,QString &errmsg)
+{
+	qDebug() << trace.header(__PRETTY_FUNCTION__);
+	
+	QSet<QString> added = addedLabels.toSet();
+	QHash<QString,Sequence *> existing;
+	QList<Sequence *> &seqList = sequences.sequences();
+	for (int s=0;s<seqList.size();s++){
+		if (!existing.contains(seqList.at(s)->label))
+			existing.insert(seqList.at(s)->label,seqList.at(s));
+	}
+	
+	int outWidth=0;
+	for (int s=0;s<seqs.size();s++)
+		outWidth = qMax(outWidth,seqs.at(s).size());
+	QVector<int> colMap(outWidth,-1);
+	
+	int width=0;
+	int nExisting=0;
+	for (int s=0;s<labels.size();s++){
+		if (added.contains(labels.at(s))) continue;
+		Sequence *seq = existing.value(labels.at(s),NULL);
+		if (NULL == seq) continue;
+		QString orig = seq->filter(false);
+		width = qMax(width,orig.size());
+		const QString &row = seqs.at(s);
+		int k=0;
+		for (int c=0;c<row.size();c++){
+			if (row.at(c) == '-' || row.at(c) == '.') continue;
+			while (k < orig.size() && (orig.at(k) == '-' || orig.at(k) == '.'))
+				k++;
+			if (k == orig.size()){
+				errmsg = "The sequence " + labels.at(s) + " was changed while the alignment was running";
+				return false;
+			}
+			if (colMap[c] < 0)
+				colMap[c]=k;
+			k++;
+		}
+		nExisting++;
+	}
+	
+	if (nExisting == 0){
+		errmsg = "The existing alignment was not found in the aligner's output";
+		return false;
+	}
+	
+	for (int s=0;s<seqList.size();s++){
+		if (!added.contains(seqList.at(s)->label))
+			width = qMax(width,seqList.at(s)->residues.size());
+	}
+	
+	// Output columns with residues of the added sequences only become new columns, inserted
+	// before the next mapped column. ins[k] counts the new columns before existing column k
+	QVector<int> ins(width+1,0);
+	QVector<int> newCol(outWidth,-1);
+	int nextK=width;
+	for (int c=outWidth-1;c>=0;c--){
+		if (colMap[c] >= 0){
+			nextK=colMap[c];
+			continue;
+		}
+		for (int s=0;s<labels.size();s++){
+			if (!added.contains(labels.at(s))) continue;
+			const QString &row = seqs.at(s);
+			if (c < row.size() && row.at(c) != '-' && row.at(c) != '.'){
+				newCol[c]=nextK; // fixed up below
+				ins[nextK]++;
 				break;
 			}
 		}
+	}
+	
+	QVector<int> shift(width+1,0); // new columns before and at existing column k
+	int nInserted=0;
+	for (int k=0;k<=width;k++){
+		nInserted += ins[k];
+		shift[k]=nInserted;
+	}
+	QVector<int> used(width+1,0);
+	for (int c=0;c<outWidth;c++){
+		if (colMap[c] >= 0)
+			newCol[c] = colMap[c] + shift[colMap[c]];
+		else if (newCol[c] >= 0){
+			int k = newCol[c];
+			newCol[c] = k + shift[k] - ins[k] + used[k];
+			used[k]++;
+		}
+	}
 	
-		qDebug() << trace.header(__PRETTY_FUNCTION__) <<"first selected sequence index=" << indexFirstSelSeq;
+	QHash<QString,int> outIndex;
+	for (int s=0;s<labels.size();s++){
+		if (added.contains(labels.at(s)) && !outIndex.contains(labels.at(s)))
+			outIndex.insert(labels.at(s),s);
+	}
+	
+	// Everything that changes, in the order of the alignment
+	QStringList newLabels,newSeqs;
+	int nAdded=0;
+	for (int s=0;s<seqList.size();s++){
+		Sequence *seq = seqList.at(s);
+		if (added.contains(seq->label)){
+			int o = outIndex.value(seq->label,-1);
+			if (o < 0) continue;
+			const QString &row = seqs.at(o);
+			QString r(width + nInserted,QChar('-'));
+			for (int c=0;c<row.size();c++){
+				if (row.at(c) != '-' && row.at(c) != '.')
+					r[newCol[c]] = row.at(c);
+			}
+			newLabels.append(seq->label);
+			newSeqs.append(r);
+			nAdded++;
+		}
+		else if (nInserted > 0){
+			const QString &old = seq->residues;
+			QString r;
+			r.reserve(width + nInserted);
+			for (int k=0;k<old.size();k++){
+				if (ins[k] > 0)
+					r.append(QString(ins[k],QChar('-')));
+				r.append(old.at(k)); // with its flags
+			}
+			newLabels.append(seq->label);
+			newSeqs.append(r);
+		}
+	}
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << nAdded << " added, " << nInserted << " columns inserted";
+	
+	bool wasAligned = aligned_;
+	readNewAlignment(newLabels,newSeqs,false);
+	aligned_=wasAligned;
+	return true;
+}
+
+static bool isGapCell(QChar ch)
+{
+	ch = ch.unicode() & REMOVE_FLAGS;
+	return ch == '-' || ch == '.';
+}
+
+// Splices a realigned block of columns back into the alignment.
+// Excluded residues weren't aligned. Each run of them stays between the same two residues, in columns
+// inserted before the next aligned residue (or at the end), which are gaps in the other sequences.
+// The new block is padded with gaps to the wider of the old and new widths. If it is wider, gap columns
+// are inserted after the window in the other sequences, so the columns on either side keep their alignment.
+// Residues keep their flags (exclusions, for example) through the realignment.
+bool Project::readRealignedWindow(const ColumnWindow &window,const QStringList &labels,const QStringList &seqs,QString &errmsg)
+{
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << window.start << " " << window.stop;
+	
+	QHash<QString,int> outIndex;
+	int newWidth=0;
+	for (int s=0;s<labels.size();s++){
+		outIndex.insert(labels.at(s),s);
+		newWidth = qMax(newWidth,seqs.at(s).size());
+	}
+	int oldWidth = window.stop - window.start + 1;
+	
+	// First, the aligned residues, with their flags, are matched to the old block,
+	// and the excluded residues are collected by the output column they go before
+	QList<Sequence *> windowSeqs;
+	QStringList alignedRows;
+	QList<QHash<int,QString> > excluded;
+	QVector<int> ins(newWidth+1,0); // columns inserted before each output column
+	for (int w=0;w<window.labels.size();w++){
+		Sequence *seq = sequences.getSequence(window.labels.at(w));
+		const QString &oldBlock = window.blocks.at(w);
+		if (NULL == seq || seq->residues.mid(window.start,oldWidth) != oldBlock){
+			errmsg = "The sequence " + window.labels.at(w) + " was changed while the columns were being realigned";
+			return false;
+		}
 		
-		for (int l=0;l<newlabels.size();l++){
-			
-			Sequence *seq = newSequences.getSequence(newlabels.at(l));
-			if (seq){
-				seq->residues=newseqs.at(l);
-				// move it to its new home
-				int oldIndex = newSequences.getIndex(newlabels.at(l)); // note, after a sequence is moved, positions have all changed so use newSequences!
-				newSequences.sequences().move(oldIndex,indexFirstSelSeq + l);
-				qDebug() << trace.header(__PRETTY_FUNCTION__) << "move " << newlabels.at(l) << " " << oldIndex << " " << indexFirstSelSeq + l;
+		QString aligned;
+		QHash<int,QString> runs;
+		QString run;
+		int k=0; // next residue in the old block
+		if (outIndex.contains(window.labels.at(w))){
+			const QString &row = seqs.at(outIndex.value(window.labels.at(w)));
+			for (int c=0;c<row.size();c++){
+				if (row.at(c) == '-' || row.at(c) == '.'){
+					aligned.append(QChar('-'));
+					continue;
+				}
+				while (k < oldBlock.size() && (isGapCell(oldBlock.at(k)) || (oldBlock.at(k).unicode() & EXCLUDE_CELL))){
+					if (!isGapCell(oldBlock.at(k)))
+						run.append(oldBlock.at(k));
+					k++;
+				}
+				if (k == oldBlock.size() || QChar(oldBlock.at(k).unicode() & REMOVE_FLAGS).toUpper() != row.at(c).toUpper()){
+					errmsg = "The realigned residues of " + window.labels.at(w) + " don't match the original";
+					return false;
+				}
+				if (!run.isEmpty()){
+					runs.insert(c,run);
+					ins[c] = qMax(ins[c],run.size());
+					run.clear();
+				}
+				aligned.append(oldBlock.at(k)); // with its flags
+				k++;
 			}
-			else{
-				qDebug() << trace.header(__PRETTY_FUNCTION__) << "missed aligned sequence " << newlabels.at(l);
+		}
+		for (;k < oldBlock.size();k++){
+			if (isGapCell(oldBlock.at(k))) continue;
+			if (!(oldBlock.at(k).unicode() & EXCLUDE_CELL)){
+				errmsg = "Residues of " + window.labels.at(w) + " are missing from the realigned columns";
+				return false;
 			}
+			run.append(oldBlock.at(k));
+		}
+		if (!run.isEmpty()){
+			runs.insert(newWidth,run);
+			ins[newWidth] = qMax(ins[newWidth],run.size());
 		}
 		
+		windowSeqs.append(seq);
+		alignedRows.append(aligned);
+		excluded.append(runs);
 	}
-
-	// Pushing onto the stack triggers redo(), so this will finish things off (call setAlignment(), in particular
-	undoStack_.push(new AlignmentCmd(this,oldSeqs,oldGroups,newSequences.sequences(),newGroups,aligned_,"alignment"));
 	
+	int nInserted=0;
+	for (int c=0;c<=newWidth;c++)
+		nInserted += ins[c];
+	int width = qMax(oldWidth,newWidth + nInserted);
+	
+	QList<Sequence *> changedSeqs;
+	QStringList oldResidues,newResidues;
+	QSet<Sequence *> inWindow;
+	
+	for (int w=0;w<windowSeqs.size();w++){
+		Sequence *seq = windowSeqs.at(w);
+		const QString &aligned = alignedRows.at(w);
+		QString block;
+		for (int c=0;c<=newWidth;c++){
+			if (ins[c] > 0){
+				QString run = excluded.at(w).value(c);
+				block.append(run);
+				block.append(QString(ins[c] - run.size(),QChar('-')));
+			}
+			if (c < newWidth)
+				block.append(c < aligned.size() ? aligned.at(c) : QChar('-'));
+		}
+		block.append(QString(width - block.size(),QChar('-')));
+		
+		QString r = seq->residues;
+		if (r.size() < window.start)
+			r.append(QString(window.start - r.size(),QChar('-')));
+		r.replace(window.start,oldWidth,block);
+		
+		changedSeqs.append(seq);
+		oldResidues.append(seq->residues);
+		newResidues.append(r);
+		inWindow.insert(seq);
+	}
+	
+	if (width > oldWidth){
+		QString gaps(width - oldWidth,QChar('-'));
+		QList<Sequence *> &allSeqs = sequences.sequences();
+		for (int s=0;s<allSeqs.size();s++){
+			Sequence *seq = allSeqs.at(s);
+			if (inWindow.contains(seq) || seq->residues.size() <= window.stop + 1) continue; // nothing to the right to shift
+			changedSeqs.append(seq);
+			oldResidues.append(seq->residues);
+			newResidues.append(QString(seq->residues).insert(window.stop + 1,gaps));
+		}
+	}
+	
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << "old width " << oldWidth << " new width " << newWidth << " sequences changed " << changedSeqs.size();
+	
+	clearSearchResults();
+	undoStack_.push(new RealignColumnsCmd(this,changedSeqs,oldResidues,newResidues,"realign columns"));
+	dirty_=true;
+	return true;
 }
 
 int  Project::search(const QString &needle)
@@ -1129,6 +1563,8 @@ void Project::clearSearchResults()
 
 void Project::init()
 {
+	mainWindow_=NULL;
+	
 	residueSelection = new ResidueSelection();
 	sequenceSelection = new SequenceSelection();
 
@@ -1151,6 +1587,8 @@ void Project::init()
 	if (app->alignmentToolAvailable("clustalo"))
 		clustalOTool_ = new ClustalO();
 	
+	builtInTool_ = new BuiltInAligner(); // always available
+	
 	alignmentTool_= NULL;
 	
 	QDomDocument &doc = app->defaultSettings();
@@ -1162,6 +1600,10 @@ void Project::readAlignmentToolSettings(QDomDocument &doc)
 {
 	qDebug() << trace.header(__PRETTY_FUNCTION__) ;
 	
+	builtInTool_->readSettings(doc);
+	if (builtInTool_->preferred())
+		alignmentTool_=builtInTool_;
+	
 	if (muscleTool_){
 		muscleTool_->readSettings(doc);
 		if (muscleTool_->preferred())
@@ -1179,27 +1621,13 @@ void Project::readAlignmentToolSettings(QDomDocument &doc)
 		if (mafftTool_->preferred())
 			alignmentTool_=mafftTool_;
 	}
+	
+	if (!alignmentTool_) // nothing preferred, or the preferred tool is no longer installed
+		alignmentTool_=builtInTool_;
 }
 
 
 
-QStringList Project::findDuplicates(QStringList &sl)
-{
-	QStringList ret;
-	QSet<QString> visited;
-	for (int i=0;i<sl.size();++i){
-		const QString &s = sl.at(i);
-		if (visited.contains(s)){
-			ret.append(s);
-			continue;
-		}
-		visited.insert(s);
-	}
-	ret.removeDuplicates();
-	return ret;
-}
-
-
 int Project::getSeqIndex(QString l)
 {
 	// Get the index of the sequence with label l
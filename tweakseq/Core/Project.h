@@ -39,13 +39,19 @@
 
 #include "AlignmentTool.h"
 #include "Consensus.h"
+#include "RunHistory.h"
 #include "Sequences.h"
 
 class QDomDocumentFragment;
 
-enum alignmentFormats {FASTA,CLUSTALW};
+struct ImportedFile;
+
+enum alignmentFormats {FASTA,CLUSTALW,A3M};
 
 class AlignmentTool;
+class ColumnWindow;
+class ExportJob;
+class FASTAIndex;
 class Operation;
 class ResidueSelection;
 class SearchResult;
@@ -89,6 +95,9 @@ class Project:public QObject
 		QList<SequenceGroup *> sequenceGroups;
 
 		bool importSequences(QStringList &,QString &);
+		bool loadFASTAIndex(FASTAIndex &,QString &);
+		bool importIndexedSequences(FASTAIndex &,const QStringList &,QString &);
+		bool viewMappedAlignment(const QString &,QString &);
 		
 		QString getResidues(int,int);
 		QString getLabelAt(int);
@@ -120,12 +129,13 @@ class Project:public QObject
 		
 		AlignmentTool*  alignmentTool(){return alignmentTool_;}
 		void setAlignmentTool(const QString &);
+		QList<AlignmentTool *> alignmentTools(); // the installed tools
 		
-		void exportFASTA(QString,bool);
-		void exportSelectionFASTA(QString,bool);
-		void exportClustalW(QString,bool);
+		ExportJob *startExport(QString,int,bool,int lineWidth=0);
 		
-		void readNewAlignment(QString,bool);
+		void readNewAlignment(const QStringList &,const QStringList &,bool);
+		bool readAddedSequences(const QStringList &,const QStringList &,const QStringList &,QString &);
+		bool readRealignedWindow(const ColumnWindow &,const QStringList &,const QStringList &,QString &);
 	
 		int search(const QString &);
 		void setSearchResultFlags(bool);
@@ -133,6 +143,7 @@ class Project:public QObject
 		QList<SearchResult *> & searchResults(){return searchResults_;}
 		
 		Consensus consensusSequence;
+		RunHistory runHistory;
 		
 	signals:
 		
@@ -158,13 +169,12 @@ class Project:public QObject
 	private:
 		
 		void init();
+		bool addImportedSequences(const QList<ImportedFile> &,QString &);
 		void readAlignmentToolSettings(QDomDocument &);
 	
 		int  getSeqIndex(QString);
 		int  getGroupIndex(SequenceGroup *sg);
 		
-		QStringList findDuplicates(QStringList &);
-		
 		// Widgets we keep track of
 		SeqEditMainWin *mainWindow_;
 		
@@ -177,7 +187,7 @@ class Project:public QObject
 		
 		int sequenceDataType_;
 		int nAlignments;
-		AlignmentTool *alignmentTool_,*mafftTool_,*clustalOTool_,*muscleTool_;
+		AlignmentTool *alignmentTool_,*mafftTool_,*clustalOTool_,*muscleTool_,*builtInTool_;
 		QUndoStack undoStack_;
 	
 		QList<SearchResult *> searchResults_;
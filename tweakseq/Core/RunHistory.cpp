@@ -0,0 +1,136 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <QtDebug>
+#include "DebuggingInfo.h"
+
+#include <QDomDocument>
+
+#include "AlignmentJob.h"
+#include "RunHistory.h"
+#include "XMLHelper.h"
+
+#define MAX_RUNS 1000 // the oldest are dropped
+
+//
+//	Public members
+//	
+
+RunHistory::RunHistory()
+{
+}
+
+RunHistory::~RunHistory()
+{
+}
+
+void RunHistory::add(AlignmentJob *job)
+{
+	RunRecord r;
+	r.when = QDateTime::currentDateTime();
+	r.job = job->name();
+	r.tool = job->toolName();
+	r.version = job->toolVersion();
+	r.nseqs = job->numSequences();
+	r.residues = job->numResidues();
+	r.maxLength = job->maxLength();
+	r.ok = (job->state() == AlignmentJob::Finished);
+	r.usage = job->usage();
+	
+	runs_.append(r);
+	while (runs_.size() > MAX_RUNS)
+		runs_.removeFirst();
+}
+
+void RunHistory::writeSettings(QDomDocument &doc,QDomElement &parentElem)
+{
+	QDomElement hElem = doc.createElement("run_history");
+	parentElem.appendChild(hElem);
+	for (int i=0;i<runs_.size();i++){
+		const RunRecord &r = runs_.at(i);
+		QDomElement rElem = doc.createElement("run");
+		hElem.appendChild(rElem);
+		XMLHelper::addElement(doc,rElem,"when",r.when.toString(Qt::ISODate));
+		XMLHelper::addElement(doc,rElem,"job",r.job);
+		XMLHelper::addElement(doc,rElem,"tool",r.tool);
+		XMLHelper::addElement(doc,rElem,"version",r.version);
+		XMLHelper::addElement(doc,rElem,"sequences",QString::number(r.nseqs));
+		XMLHelper::addElement(doc,rElem,"residues",QString::number(r.residues));
+		XMLHelper::addElement(doc,rElem,"max_length",QString::number(r.maxLength));
+		XMLHelper::addElement(doc,rElem,"ok",XMLHelper::boolToString(r.ok));
+		XMLHelper::addElement(doc,rElem,"wall",QString::number(r.usage.wall));
+		XMLHelper::addElement(doc,rElem,"user",QString::number(r.usage.user));
+		XMLHelper::addElement(doc,rElem,"sys",QString::number(r.usage.sys));
+		XMLHelper::addElement(doc,rElem,"peak_rss",QString::number(r.usage.peakRSS));
+		XMLHelper::addElement(doc,rElem,"exact",XMLHelper::boolToString(r.usage.exact));
+	}
+}
+
+void RunHistory::readSettings(QDomDocument &doc)
+{
+	runs_.clear();
+	QDomNodeList nl = doc.elementsByTagName("run");
+	for (int i=0;i<nl.count();i++){
+		RunRecord r;
+		r.nseqs=0;
+		r.residues=0;
+		r.maxLength=0;
+		r.ok=false;
+		QDomElement elem = nl.item(i).firstChildElement();
+		while (!elem.isNull()){
+			QString txt = elem.text().trimmed();
+			if (elem.tagName() == "when")
+				r.when = QDateTime::fromString(txt,Qt::ISODate);
+			else if (elem.tagName() == "job")
+				r.job = txt;
+			else if (elem.tagName() == "tool")
+				r.tool = txt;
+			else if (elem.tagName() == "version")
+				r.version = txt;
+			else if (elem.tagName() == "sequences")
+				r.nseqs = txt.toInt();
+			else if (elem.tagName() == "residues")
+				r.residues = txt.toLongLong();
+			else if (elem.tagName() == "max_length")
+				r.maxLength = txt.toInt();
+			else if (elem.tagName() == "ok")
+				r.ok = XMLHelper::stringToBool(txt);
+			else if (elem.tagName() == "wall")
+				r.usage.wall = txt.toLongLong();
+			else if (elem.tagName() == "user")
+				r.usage.user = txt.toLongLong();
+			else if (elem.tagName() == "sys")
+				r.usage.sys = txt.toLongLong();
+			else if (elem.tagName() == "peak_rss")
+				r.usage.peakRSS = txt.toLongLong();
+			else if (elem.tagName() == "exact")
+				r.usage.exact = XMLHelper::stringToBool(txt);
+			elem=elem.nextSiblingElement();
+		}
+		runs_.append(r);
+	}
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << runs_.size() << "runs";
+}
@@ -0,0 +1,77 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef __RUN_HISTORY_H_
+#define __RUN_HISTORY_H_
+
+#include <QDateTime>
+#include <QList>
+#include <QString>
+
+#include "ToolProcess.h"
+
+class QDomDocument;
+class QDomElement;
+
+class AlignmentJob;
+
+// One run of an alignment tool, with the size of its input and the resources it used
+struct RunRecord
+{
+	QDateTime when;
+	QString job;
+	QString tool,version;
+	int nseqs;
+	qint64 residues;
+	int maxLength;
+	bool ok;
+	ResourceUsage usage;
+};
+
+// The alignment runs made in a project, saved with it, so that tools can be compared on its data
+
+class RunHistory
+{
+	public:
+		
+		RunHistory();
+		~RunHistory();
+		
+		void add(AlignmentJob *);
+		
+		int size(){return runs_.size();}
+		const RunRecord &at(int i){return runs_.at(i);}
+		void clear(){runs_.clear();}
+		
+		void writeSettings(QDomDocument &,QDomElement &);
+		void readSettings(QDomDocument &);
+		
+	private:
+		
+		QList<RunRecord> runs_;
+};
+
+#endif
@@ -40,6 +40,7 @@ SequenceFile::SequenceFile(QString n)
 	formatVersion_="unknown";
 	err_="";
 	dataType_=SequenceFile::Unknown;
+	lineWidth_=80;
 }
 
 SequenceFile::~SequenceFile()
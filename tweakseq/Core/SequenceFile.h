@@ -54,6 +54,9 @@ class SequenceFile
 		
 		int dataType(){return dataType_;}
 		
+		int lineWidth(){return lineWidth_;}
+		void setLineWidth(int w){if (w > 0) lineWidth_=w;} // number of residues per output line
+		
 		QStringList & extensions(int dataFilter);
 		
 		virtual bool read(QStringList &,QStringList &,QStringList &,Structure *s= NULL);
@@ -80,6 +83,7 @@ class SequenceFile
 		QString err_;
 		
 		int dataType_;
+		int lineWidth_;
 };
 
 #endif
@@ -27,6 +27,7 @@
 #include <QtDebug>
 #include "DebuggingInfo.h"
 
+#include "MappedAlignment.h"
 #include "Sequence.h"
 #include "Sequences.h"
 #include "SequenceGroup.h"
@@ -34,10 +35,12 @@
 Sequences::Sequences()
 {
 	maxLen_=0;
+	mapped_=NULL;
 }
 
 Sequences::~Sequences()
 {
+	delete mapped_;
 }
 
 void Sequences::forceCacheUpdate()
@@ -81,12 +84,16 @@ int Sequences::visibleIndex(Sequence *seq)
 
 bool Sequences::isEmpty()
 {
+	if (mapped_ != NULL)
+		return mapped_->size() == 0;
 	return sequences_.empty();
 }
 
 // Returns size() - number of hidden sequences
 int Sequences::numVisible()
 {
+	if (mapped_ != NULL)
+		return mapped_->size();
 	int nvis=0;
 	for (int i=0;i<sequences_.size();i++){
 		if ((sequences_.at(i)->visible)) 
@@ -102,6 +109,8 @@ void Sequences::clear()
 		if (seq->group)
 			seq->group->removeSequence(seq);
 	}
+	delete mapped_;
+	mapped_=NULL;
 	updateCachedVariables();
 	emit cleared();
 	emit changed();
@@ -109,6 +118,8 @@ void Sequences::clear()
 
 Sequence * Sequences::visibleAt(int pos)
 {
+	if (mapped_ != NULL)
+		return mapped_->sequenceAt(pos);
 	int visIndex=0;
 	for (int i=0;i<sequences_.size();i++){
 		Sequence *seq = sequences_.at(i);
@@ -123,6 +134,8 @@ Sequence * Sequences::visibleAt(int pos)
 // Convert index of visible sequence to actual index
 int Sequences::visibleToActual(int pos)
 {
+	if (mapped_ != NULL)
+		return pos;
 	int visIndex=0;
 	for (int i=0;i<sequences_.size();i++){
 		Sequence *seq = sequences_.at(i);
@@ -263,6 +276,15 @@ void Sequences::replaceResidues(QString newResidues,int pos)
 	emit changed();
 }
 
+// Updates the cache once, rather than once per sequence
+void Sequences::replaceResidues(const QList<Sequence *> &seqs,const QStringList &newResidues)
+{
+	for (int s=0;s<seqs.size();s++)
+		seqs.at(s)->residues=newResidues.at(s);
+	updateCachedVariables();
+	emit changed();
+}
+
 void  Sequences::addInsertions(int startSequence,int stopSequence,int startPos,int nInsertions)
 {
 	qDebug() << trace.header(__PRETTY_FUNCTION__) << startSequence << " " << stopSequence << " " << startPos << " " << nInsertions;
@@ -309,6 +331,15 @@ void  Sequences::unhideAll()
 		sequences_.at(s)->visible=true;
 	emit changed();
 }
+
+// Takes ownership of the mapped alignment, replacing any sequences
+void Sequences::setMapped(MappedAlignment *m)
+{
+	clear();
+	mapped_=m;
+	updateCachedVariables();
+	emit changed();
+}
 		
 
 int Sequences::getIndex(QString label)
@@ -336,9 +367,13 @@ QString Sequences::getLabelAt(int i)
 void Sequences::updateCachedVariables()
 {
 	maxLen_=0;
+	if (mapped_ != NULL){
+		maxLen_ = mapped_->maxLength();
+		return;
+	}
 	for (int s=0;s<sequences_.count();s++){
 		int len =sequences_.at(s)->residues.length();
 		if (len> maxLen_)
 			maxLen_=len;
 	}
-}
\ No newline at end of file
+}
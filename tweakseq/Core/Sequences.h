@@ -31,7 +31,9 @@
 #include <QObject>
 #include <QList>
 #include <QString>
+#include <QStringList>
 
+class MappedAlignment;
 class Sequence;
 class SequenceGroup;
 
@@ -78,6 +80,7 @@ class Sequences:public QObject
 		void  replace(QString,QString,QString);
 		void  move(int,int);
 		void  replaceResidues(QString ,int pos);
+		void  replaceResidues(const QList<Sequence *> &,const QStringList &);
 		void  addInsertions(int,int,int,int);
 		void  addInsertions(Sequence *,int,int);
 		void  removeResidues(int,int,int,int);
@@ -85,6 +88,10 @@ class Sequences:public QObject
 		
 		void  unhideAll();
 		
+		// A mapped alignment is viewed through the visible-row API only
+		void setMapped(MappedAlignment *);
+		bool isMapped(){return mapped_ != NULL;}
+		
 	signals:
 	
 		void cleared();
@@ -95,6 +102,7 @@ class Sequences:public QObject
 		void updateCachedVariables();
 		
 		QList<Sequence *> sequences_;
+		MappedAlignment *mapped_;
 		
 		int maxLen_;
 };
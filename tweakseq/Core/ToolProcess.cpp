@@ -0,0 +1,212 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <QtDebug>
+#include "DebuggingInfo.h"
+
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <QDir>
+#include <QFile>
+#include <QTimer>
+
+#include "ToolProcess.h"
+
+#define SAMPLE_INTERVAL 250 // ms
+
+QAtomicInt ToolProcess::numRunning_(0);
+QAtomicInt ToolProcess::numStarted_(0);
+
+static qint64 toMs(const struct timeval &tv)
+{
+	return (qint64) tv.tv_sec*1000 + tv.tv_usec/1000;
+}
+
+//
+//	Public
+//
+
+ToolProcess::ToolProcess(QObject *parent):QProcess(parent)
+{
+	memoryLimit_=0;
+	niceLevel_=0;
+	overlapped_=false;
+	startGeneration_=0;
+	running_=false;
+	sampledCPU_[0]=sampledCPU_[1]=0;
+	
+	sampleTimer_ = new QTimer(this);
+	connect(sampleTimer_,SIGNAL(timeout()),this,SLOT(sample()));
+	
+	// Connected before any user of the process, so the usage is ready when they see finished()
+	connect(this,SIGNAL(started()),this,SLOT(processStarted()));
+	connect(this,SIGNAL(finished(int,QProcess::ExitStatus)),this,SLOT(processFinished()));
+}
+
+ToolProcess::~ToolProcess()
+{
+	if (running_)
+		numRunning_.deref();
+}
+
+//
+//	Protected
+//
+
+// This runs in the child, so only async-signal-safe calls, and no Qt
+void ToolProcess::setupChildProcess()
+{
+	if (memoryLimit_ > 0){
+		struct rlimit rl;
+		rl.rlim_cur = rl.rlim_max = (rlim_t) memoryLimit_ * 1024 * 1024;
+		setrlimit(RLIMIT_AS,&rl); // allocations fail past the limit, rather than the OOM killer picking a victim
+	}
+	if (niceLevel_ > 0)
+		setpriority(PRIO_PROCESS,0,niceLevel_);
+}
+
+//
+//	Private slots
+//
+
+void ToolProcess::processStarted()
+{
+	getrusage(RUSAGE_CHILDREN,&startUsage_);
+	wallTimer_.start();
+	startGeneration_ = numStarted_.fetchAndAddOrdered(1) + 1;
+	overlapped_ = numRunning_.fetchAndAddOrdered(1) > 0;
+	running_=true;
+	usage_ = ResourceUsage();
+	sampledCPU_[0]=sampledCPU_[1]=0;
+	sampleTimer_->start(SAMPLE_INTERVAL);
+}
+
+void ToolProcess::processFinished()
+{
+	if (!running_) return;
+	
+	sampleTimer_->stop();
+	running_=false;
+	numRunning_.deref();
+	usage_.wall = wallTimer_.elapsed();
+	
+	struct rusage endUsage;
+	getrusage(RUSAGE_CHILDREN,&endUsage);
+	overlapped_ = overlapped_ || numStarted_.load() != startGeneration_;
+	if (overlapped_){
+		usage_.user = sampledCPU_[0];
+		usage_.sys = sampledCPU_[1];
+		usage_.exact=false;
+	}
+	else{
+		usage_.user = toMs(endUsage.ru_utime) - toMs(startUsage_.ru_utime);
+		usage_.sys = toMs(endUsage.ru_stime) - toMs(startUsage_.ru_stime);
+		usage_.exact=true;
+	}
+	
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << "wall" << usage_.wall << "ms user" << usage_.user << "ms sys" << usage_.sys
+		<< "ms peak RSS" << usage_.peakRSS << "kB" << (usage_.exact ? "exact" : "sampled");
+}
+
+// Reads the CPU times and the peak RSS of the child's process tree from /proc
+void ToolProcess::sample()
+{
+	qint64 pid = processId();
+	if (pid <= 0) return;
+	
+	// The processes in the tree at the same time add up. A short-lived descendant may be missed between samples,
+	// but the CPU time of one that has exited is in its parent's cutime and cstime, once it has been waited for
+	qint64 treeRSS=0;
+	qint64 treeCPU[2]={0,0};
+	QList<qint64> tree;
+	tree.append(pid);
+	for (int p=0;p<tree.size();p++){
+		treeRSS += peakRSS(tree.at(p));
+		qint64 user,sys;
+		if (cpuTimes(tree.at(p),user,sys)){
+			treeCPU[0] += user;
+			treeCPU[1] += sys;
+		}
+		tree.append(childProcesses(tree.at(p)));
+	}
+	usage_.peakRSS = qMax(usage_.peakRSS,treeRSS);
+	// A descendant which exits and isn't waited for drops out of the sum
+	sampledCPU_[0] = qMax(sampledCPU_[0],treeCPU[0]);
+	sampledCPU_[1] = qMax(sampledCPU_[1],treeCPU[1]);
+}
+
+//
+//	Private
+//
+
+// User and system time (ms) of the process and of its children which have exited
+bool ToolProcess::cpuTimes(qint64 pid,qint64 &user,qint64 &sys)
+{
+	QFile stat("/proc/" + QString::number(pid) + "/stat");
+	if (!stat.open(QIODevice::ReadOnly)) return false; // it has exited
+	QByteArray line = stat.readAll();
+	int i = line.lastIndexOf(')'); // the command name may contain spaces
+	if (i < 0) return false;
+	QList<QByteArray> fields = line.mid(i+2).split(' ');
+	if (fields.size() <= 14) return false; // utime, stime, cutime and cstime are the 14th to 17th fields, counted from the pid
+	static long ticks = sysconf(_SC_CLK_TCK);
+	user = (fields.at(11).toLongLong() + fields.at(13).toLongLong())*1000/ticks;
+	sys  = (fields.at(12).toLongLong() + fields.at(14).toLongLong())*1000/ticks;
+	return true;
+}
+
+qint64 ToolProcess::peakRSS(qint64 pid)
+{
+	QFile status("/proc/" + QString::number(pid) + "/status");
+	if (!status.open(QIODevice::ReadOnly)) return 0; // it has exited
+	while (!status.atEnd()){
+		QByteArray line = status.readLine();
+		if (line.startsWith("VmHWM:"))
+			return line.mid(6).trimmed().split(' ').first().toLongLong();
+	}
+	return 0;
+}
+
+// Needs a kernel with /proc/<pid>/task/<tid>/children (3.5 and later), otherwise only the child is seen
+QList<qint64> ToolProcess::childProcesses(qint64 pid)
+{
+	QList<qint64> children;
+	QString taskPath = "/proc/" + QString::number(pid) + "/task";
+	QStringList tasks = QDir(taskPath).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+	for (int t=0;t<tasks.size();t++){
+		QFile f(taskPath + "/" + tasks.at(t) + "/children");
+		if (!f.open(QIODevice::ReadOnly)) continue;
+		QList<QByteArray> pids = f.readAll().simplified().split(' ');
+		for (int c=0;c<pids.size();c++){
+			qint64 cpid = pids.at(c).toLongLong();
+			if (cpid > 0)
+				children.append(cpid);
+		}
+	}
+	return children;
+}
@@ -0,0 +1,103 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef __TOOL_PROCESS_H_
+#define __TOOL_PROCESS_H_
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QList>
+#include <QProcess>
+
+#include <sys/resource.h>
+
+class QTimer;
+
+// Resources used by one run of a tool
+struct ResourceUsage
+{
+	ResourceUsage():wall(0),user(0),sys(0),peakRSS(0),exact(false){}
+	qint64 wall,user,sys; // ms
+	qint64 peakRSS; // kB, 0 if unknown
+	bool exact; // false if they were sampled, rather than counted when the tool exited
+};
+
+// A QProcess which applies resource limits to the child, between fork() and exec(),
+// so a runaway aligner fails on its own rather than taking the editor down with it.
+// The resources the child uses are measured too. QProcess reaps the child itself, so the CPU times are
+// taken from the change in getrusage(RUSAGE_CHILDREN), which counts the tool and anything it waited for.
+// That is only attributable when no other process the editor started ran at the same time (every one
+// should be a ToolProcess, so it is seen), so the CPU times of the child's process tree are also sampled
+// from /proc while it runs, as the fallback. Many tools are scripts which run the aligner as a subprocess.
+// The peak RSS is always sampled over the tree, since ru_maxrss is the largest over every child the editor has had.
+
+class ToolProcess:public QProcess
+{
+	Q_OBJECT
+	
+	public:
+		
+		ToolProcess(QObject *parent=NULL);
+		~ToolProcess();
+		
+		void setMemoryLimit(int mb){memoryLimit_=mb;} // 0 for no limit
+		void setNiceLevel(int n){niceLevel_=n;}
+		
+		ResourceUsage usage(){return usage_;} // valid once finished() has been emitted
+		
+	protected:
+		
+		virtual void setupChildProcess();
+		
+	private slots:
+		
+		void processStarted();
+		void processFinished();
+		void sample();
+		
+	private:
+		
+		static bool cpuTimes(qint64,qint64 &,qint64 &);
+		static qint64 peakRSS(qint64); // kB, 0 if unknown
+		static QList<qint64> childProcesses(qint64);
+		
+		int memoryLimit_;
+		int niceLevel_;
+		
+		ResourceUsage usage_;
+		QElapsedTimer wallTimer_;
+		QTimer *sampleTimer_;
+		struct rusage startUsage_;
+		qint64 sampledCPU_[2]; // user, sys
+		bool overlapped_;
+		int startGeneration_;
+		bool running_;
+		
+		static QAtomicInt numRunning_;
+		static QAtomicInt numStarted_;
+};
+
+#endif
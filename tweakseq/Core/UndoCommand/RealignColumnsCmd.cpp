@@ -0,0 +1,59 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <QtDebug>
+#include "DebuggingInfo.h"
+
+#include "Project.h"
+#include "RealignColumnsCmd.h"
+#include "ResidueSelection.h"
+#include "Sequence.h"
+
+RealignColumnsCmd::RealignColumnsCmd(Project *project,const QList<Sequence *> &seqs,const QStringList &oldResidues,
+	const QStringList &newResidues,const QString &txt):Command(project,txt)
+{
+	seqs_=seqs;
+	oldResidues_=oldResidues;
+	newResidues_=newResidues;
+}
+
+RealignColumnsCmd::~RealignColumnsCmd()
+{
+}
+
+void RealignColumnsCmd::redo()
+{
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << seqs_.size();
+	project_->residueSelection->clear(); // the selected columns have moved
+	project_->sequences.replaceResidues(seqs_,newResidues_);
+}
+
+void RealignColumnsCmd::undo()
+{
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << seqs_.size();
+	project_->residueSelection->clear();
+	project_->sequences.replaceResidues(seqs_,oldResidues_);
+}
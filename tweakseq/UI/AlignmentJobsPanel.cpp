@@ -0,0 +1,170 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <QtDebug>
+#include "DebuggingInfo.h"
+
+#include <QBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTableWidget>
+
+#include "AlignmentJob.h"
+#include "AlignmentJobsPanel.h"
+#include "AlignmentQueue.h"
+
+enum JobColumns {NameColumn,SequencesColumn,StateColumn,ProgressColumn,TimeColumn,NumColumns};
+
+AlignmentJobsPanel::AlignmentJobsPanel(AlignmentQueue *queue,QWidget *parent):QWidget(parent)
+{
+	queue_=queue;
+	
+	QVBoxLayout *vl = new QVBoxLayout(this);
+	vl->setContentsMargins(2,2,2,2);
+	
+	table_ = new QTableWidget(0,NumColumns,this);
+	table_->setHorizontalHeaderLabels(QStringList() << "Job" << "Sequences" << "State" << "Progress" << "Time (s)");
+	table_->horizontalHeader()->setStretchLastSection(true);
+	table_->verticalHeader()->hide();
+	table_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	table_->setSelectionBehavior(QAbstractItemView::SelectRows);
+	vl->addWidget(table_);
+	
+	QHBoxLayout *hl = new QHBoxLayout();
+	vl->addLayout(hl);
+	
+	summary_ = new QLabel(this);
+	hl->addWidget(summary_,1);
+	
+	QPushButton *pb = new QPushButton("Cancel",this);
+	pb->setToolTip("Cancel the selected jobs");
+	connect(pb,SIGNAL(clicked()),this,SLOT(cancelSelected()));
+	hl->addWidget(pb);
+	
+	pb = new QPushButton("Clear finished",this);
+	connect(pb,SIGNAL(clicked()),this,SLOT(clearFinished()));
+	hl->addWidget(pb);
+	
+	connect(queue_,SIGNAL(jobAdded(AlignmentJob *)),this,SLOT(jobAdded(AlignmentJob *)));
+	connect(queue_,SIGNAL(jobChanged(AlignmentJob *)),this,SLOT(jobChanged(AlignmentJob *)));
+	connect(queue_,SIGNAL(jobProgress(AlignmentJob *)),this,SLOT(jobChanged(AlignmentJob *)));
+	connect(&timer_,SIGNAL(timeout()),this,SLOT(updateTimes()));
+	
+	rebuild();
+}
+
+//
+//	Private slots
+//	
+
+void AlignmentJobsPanel::jobAdded(AlignmentJob *)
+{
+	int row = table_->rowCount();
+	table_->insertRow(row);
+	for (int c=0;c<NumColumns;c++)
+		table_->setItem(row,c,new QTableWidgetItem());
+	updateRow(row);
+	updateSummary();
+}
+
+void AlignmentJobsPanel::jobChanged(AlignmentJob *job)
+{
+	int row = queue_->jobs().indexOf(job);
+	if (row >= 0 && row < table_->rowCount())
+		updateRow(row);
+	updateSummary();
+}
+
+void AlignmentJobsPanel::updateTimes()
+{
+	QList<AlignmentJob *> &jobs = queue_->jobs();
+	for (int j=0;j<jobs.size() && j<table_->rowCount();j++){
+		if (jobs.at(j)->state() == AlignmentJob::Running){
+			table_->item(j,ProgressColumn)->setText(jobs.at(j)->progressText()); // the ETA changes too
+			table_->item(j,TimeColumn)->setText(QString::number(jobs.at(j)->elapsed()/1000.0,'f',1));
+		}
+	}
+}
+
+void AlignmentJobsPanel::cancelSelected()
+{
+	QList<AlignmentJob *> &jobs = queue_->jobs();
+	QList<QTableWidgetSelectionRange> ranges = table_->selectedRanges();
+	QList<AlignmentJob *> sel;
+	for (int r=0;r<ranges.size();r++){
+		for (int row=ranges.at(r).topRow();row<=ranges.at(r).bottomRow();row++){
+			if (row < jobs.size())
+				sel.append(jobs.at(row));
+		}
+	}
+	for (int j=0;j<sel.size();j++)
+		sel.at(j)->cancel();
+}
+
+void AlignmentJobsPanel::clearFinished()
+{
+	queue_->removeInactive();
+	rebuild();
+}
+
+//
+//	Private members
+//	
+
+void AlignmentJobsPanel::rebuild()
+{
+	table_->setRowCount(0);
+	for (int j=0;j<queue_->jobs().size();j++)
+		jobAdded(queue_->jobs().at(j));
+	updateSummary();
+}
+
+void AlignmentJobsPanel::updateRow(int row)
+{
+	AlignmentJob *job = queue_->jobs().at(row);
+	table_->item(row,NameColumn)->setText(job->name());
+	table_->item(row,SequencesColumn)->setText(QString::number(job->numSequences()));
+	table_->item(row,StateColumn)->setText(job->stateText());
+	table_->item(row,ProgressColumn)->setText(job->progressText());
+	if (job->state() == AlignmentJob::Queued)
+		table_->item(row,TimeColumn)->setText("");
+	else
+		table_->item(row,TimeColumn)->setText(QString::number(job->elapsed()/1000.0,'f',1));
+}
+
+void AlignmentJobsPanel::updateSummary()
+{
+	int nRunning = queue_->numRunning();
+	int nQueued = queue_->numActive() - nRunning;
+	summary_->setText(QString::number(nRunning) + " running, " + QString::number(nQueued) + " queued");
+	
+	// Elapsed times only need refreshing while something is running
+	if (nRunning > 0 && !timer_.isActive())
+		timer_.start(1000);
+	else if (nRunning == 0)
+		timer_.stop();
+}
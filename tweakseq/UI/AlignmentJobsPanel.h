@@ -0,0 +1,68 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef __ALIGNMENT_JOBS_PANEL_H_
+#define __ALIGNMENT_JOBS_PANEL_H_
+
+#include <QTimer>
+#include <QWidget>
+
+class QLabel;
+class QTableWidget;
+
+class AlignmentJob;
+class AlignmentQueue;
+
+// Shows the queued, running and finished alignment jobs
+class AlignmentJobsPanel: public QWidget
+{
+	Q_OBJECT
+	
+	public:
+		
+		AlignmentJobsPanel(AlignmentQueue *,QWidget *parent=0);
+		
+	private slots:
+		
+		void jobAdded(AlignmentJob *);
+		void jobChanged(AlignmentJob *);
+		void updateTimes();
+		void cancelSelected();
+		void clearFinished();
+		
+	private:
+		
+		void rebuild();
+		void updateRow(int);
+		void updateSummary();
+		
+		AlignmentQueue *queue_;
+		QTableWidget *table_;
+		QLabel *summary_;
+		QTimer timer_;
+};
+
+#endif
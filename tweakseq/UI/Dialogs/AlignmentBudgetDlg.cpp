@@ -0,0 +1,91 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "AlignmentBudgetDlg.h"
+#include "AlignmentTool.h"
+#include "CostModel.h"
+
+#include <QComboBox>
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QLabel>
+#include <QLayout>
+#include <QSpinBox>
+
+AlignmentBudgetDlg::AlignmentBudgetDlg(AlignmentBudget &budget,QWidget * parent, Qt::WindowFlags f ):QDialog(parent,f),budget_(budget)
+{
+	setWindowTitle("Alignment budget");
+	QVBoxLayout *vb = new QVBoxLayout();
+	setLayout(vb);
+	
+	QLabel *l = new QLabel("Runs predicted to exceed the budget, from the project's run history, are queried before they start.");
+	l->setWordWrap(true);
+	vb->addWidget(l);
+	
+	QFormLayout *fl = new QFormLayout();
+	vb->addLayout(fl);
+	
+	secondsSB_ = new QSpinBox(this);
+	secondsSB_->setRange(0,1000000);
+	secondsSB_->setSingleStep(60);
+	secondsSB_->setSuffix(" s");
+	secondsSB_->setSpecialValueText("no limit");
+	secondsSB_->setValue(budget.seconds);
+	fl->addRow("Time",secondsSB_);
+	
+	memorySB_ = new QSpinBox(this);
+	memorySB_->setRange(0,1048576);
+	memorySB_->setSingleStep(256);
+	memorySB_->setSuffix(" MB");
+	memorySB_->setSpecialValueText("no limit");
+	memorySB_->setValue(budget.mb);
+	fl->addRow("Memory",memorySB_);
+	
+	// Used when the tool is chosen automatically
+	tierCB_ = new QComboBox(this);
+	for (int t=AlignmentTool::Draft;t<=AlignmentTool::Refined;t++)
+		tierCB_->addItem(AlignmentTool::tierName(t),t);
+	tierCB_->setCurrentIndex(tierCB_->findData(budget.tier));
+	fl->addRow("Minimum quality",tierCB_);
+	
+	buttonBox_ = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+	vb->addWidget(buttonBox_);
+	
+	connect(buttonBox_, SIGNAL(accepted()), this, SLOT(accept()));
+	connect(buttonBox_, SIGNAL(rejected()), this, SLOT(reject()));
+}
+
+AlignmentBudgetDlg::~AlignmentBudgetDlg()
+{
+}
+
+void AlignmentBudgetDlg::accept()
+{
+	budget_.seconds = secondsSB_->value();
+	budget_.mb = memorySB_->value();
+	budget_.tier = tierCB_->itemData(tierCB_->currentIndex()).toInt();
+	QDialog::accept();
+}
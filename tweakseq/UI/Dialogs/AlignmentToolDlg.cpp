@@ -29,13 +29,17 @@
 
 #include <QDialogButtonBox>
 #include <QFileDialog>
+#include <QFormLayout>
 #include <QLabel>
 #include <QLayout>
 #include <QPushButton>
 #include <QLineEdit>
+#include <QSpinBox>
+#include <QThread>
 
 AlignmentToolDlg::AlignmentToolDlg(AlignmentTool *alignmentTool,QWidget * parent, Qt::WindowFlags f ):QDialog(parent,f)
 {
+	alignmentTool_=alignmentTool;
 	setWindowTitle("Alignment tool configuration");
 	QVBoxLayout *vb = new QVBoxLayout();
 	// vb->setContentsMargins(0,0,0,11);
@@ -55,6 +59,30 @@ AlignmentToolDlg::AlignmentToolDlg(AlignmentTool *alignmentTool,QWidget * parent
 	hb->addWidget(button);
 	connect(button,SIGNAL(clicked()),this,SLOT(browse()));
 	
+	// Resource limits for each run of the tool
+	QFormLayout *fl = new QFormLayout();
+	vb->addLayout(fl);
+	
+	threadsSB_ = new QSpinBox(this);
+	threadsSB_->setRange(0,QThread::idealThreadCount());
+	threadsSB_->setSpecialValueText("automatic");
+	threadsSB_->setValue(alignmentTool->threads());
+	threadsSB_->setEnabled(alignmentTool->threaded());
+	fl->addRow("Threads",threadsSB_);
+	
+	memorySB_ = new QSpinBox(this);
+	memorySB_->setRange(0,1048576);
+	memorySB_->setSingleStep(256);
+	memorySB_->setSuffix(" MB");
+	memorySB_->setSpecialValueText("no limit");
+	memorySB_->setValue(alignmentTool->memoryLimit());
+	fl->addRow("Memory limit",memorySB_);
+	
+	niceSB_ = new QSpinBox(this);
+	niceSB_->setRange(0,19);
+	niceSB_->setValue(alignmentTool->niceLevel());
+	fl->addRow("Nice level",niceSB_);
+	
 	buttonBox_ = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
 	vb->addWidget(buttonBox_);
 	
@@ -65,6 +93,14 @@ AlignmentToolDlg::AlignmentToolDlg(AlignmentTool *alignmentTool,QWidget * parent
 AlignmentToolDlg::~AlignmentToolDlg()
 {
 }
+
+void AlignmentToolDlg::accept()
+{
+	alignmentTool_->setThreads(threadsSB_->value());
+	alignmentTool_->setMemoryLimit(memorySB_->value());
+	alignmentTool_->setNiceLevel(niceSB_->value());
+	QDialog::accept();
+}
 		
 
 
@@ -31,6 +31,7 @@
 
 class QDialogButtonBox;
 class QLineEdit;
+class QSpinBox;
 
 class AlignmentTool;
 
@@ -43,13 +44,19 @@ class AlignmentToolDlg:public QDialog
 		AlignmentToolDlg(AlignmentTool *, QWidget* parent = 0, Qt::WindowFlags f = 0 );
 		~AlignmentToolDlg();
 	
+	public slots:
+	
+		virtual void accept();
+		
 	private slots:
 	
 		void browse();
 		
 	private:
 		
+		AlignmentTool *alignmentTool_;
 		QLineEdit *executableTE_;
+		QSpinBox *threadsSB_,*memorySB_,*niceSB_;
 		QDialogButtonBox *buttonBox_;
 		
 };
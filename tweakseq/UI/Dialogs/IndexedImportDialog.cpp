@@ -0,0 +1,164 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <QDialogButtonBox>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMessageBox>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QRadioButton>
+#include <QRegularExpression>
+#include <QSet>
+#include <QVBoxLayout>
+
+#include "FASTAIndex.h"
+#include "IndexedImportDialog.h"
+
+IndexedImportDialog::IndexedImportDialog(FASTAIndex *idx,QWidget * parent, Qt::WindowFlags f ):QDialog(parent,f)
+{
+	setWindowTitle("Import from indexed FASTA");
+	setMinimumWidth(500);
+	
+	index_=idx;
+	
+	QVBoxLayout *vb = new QVBoxLayout();
+	setLayout(vb);
+	
+	QLabel *l = new QLabel(idx->fileName() + " has " + QString::number(idx->size()) + " records",this);
+	vb->addWidget(l);
+	
+	// no need for button group - exclusive by default
+	namesButton_ = new QRadioButton("Import the named records (one or more per line)",this);
+	namesButton_->setChecked(true);
+	vb->addWidget(namesButton_);
+	connect(namesButton_,SIGNAL(toggled(bool)),this,SLOT(modeChanged()));
+	
+	namesEditor_ = new QPlainTextEdit(this);
+	vb->addWidget(namesEditor_);
+	
+	regexButton_ = new QRadioButton("Import records with names matching the regular expression",this);
+	vb->addWidget(regexButton_);
+	
+	regexEditor_ = new QLineEdit(this);
+	vb->addWidget(regexEditor_);
+	connect(regexEditor_,SIGNAL(editingFinished()),this,SLOT(updateMatches()));
+	
+	matchLabel_ = new QLabel(this);
+	vb->addWidget(matchLabel_);
+	
+	QPushButton *button = new QPushButton("Check",this);
+	connect(button,SIGNAL(clicked()),this,SLOT(updateMatches()));
+	
+	buttonBox_ = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+	buttonBox_->addButton(button,QDialogButtonBox::ActionRole);
+	vb->addWidget(buttonBox_);
+	
+	connect(buttonBox_, SIGNAL(accepted()), this, SLOT(accept()));
+	connect(buttonBox_, SIGNAL(rejected()), this, SLOT(reject()));
+	
+	modeChanged();
+}
+
+IndexedImportDialog::~IndexedImportDialog()
+{
+}
+
+//
+//	Public slots
+//
+
+void IndexedImportDialog::accept()
+{
+	QString errmsg;
+	if (!select(errmsg)){
+		QMessageBox::warning(this,"Import from indexed FASTA",errmsg);
+		return;
+	}
+	if (selected_.isEmpty()){
+		QMessageBox::warning(this,"Import from indexed FASTA","No records were selected");
+		return;
+	}
+	QDialog::accept();
+}
+
+//
+//	Private slots
+//
+
+void IndexedImportDialog::modeChanged()
+{
+	namesEditor_->setEnabled(namesButton_->isChecked());
+	regexEditor_->setEnabled(regexButton_->isChecked());
+	matchLabel_->setText("");
+}
+
+void IndexedImportDialog::updateMatches()
+{
+	QString errmsg;
+	if (select(errmsg))
+		matchLabel_->setText(QString::number(selected_.size()) + " records selected");
+	else
+		matchLabel_->setText(errmsg);
+}
+
+//
+//	Private
+//
+
+bool IndexedImportDialog::select(QString &errmsg)
+{
+	selected_.clear();
+	
+	if (regexButton_->isChecked()){
+		QRegularExpression re(regexEditor_->text());
+		if (!re.isValid()){
+			errmsg = "Invalid regular expression: " + re.errorString();
+			return false;
+		}
+		selected_ = index_->match(re);
+		return true;
+	}
+	
+	QStringList names = namesEditor_->toPlainText().split(QRegularExpression("\\s+"),QString::SkipEmptyParts);
+	QStringList missing;
+	QSet<QString> seen;
+	for (int i=0;i<names.size();i++){
+		if (!index_->contains(names.at(i)))
+			missing.append(names.at(i));
+		else if (!seen.contains(names.at(i))){
+			seen.insert(names.at(i));
+			selected_.append(names.at(i));
+		}
+	}
+	if (!missing.isEmpty()){
+		errmsg = QString::number(missing.size()) + " names are not in the file: " + QStringList(missing.mid(0,10)).join(",");
+		if (missing.size() > 10)
+			errmsg += " ...";
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,76 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef __INDEXED_IMPORT_DIALOG_H_
+#define __INDEXED_IMPORT_DIALOG_H_
+
+#include <QDialog>
+#include <QStringList>
+
+class QDialogButtonBox;
+class QLabel;
+class QLineEdit;
+class QPlainTextEdit;
+class QRadioButton;
+
+class FASTAIndex;
+
+// Selects records from an indexed FASTA file, either by name or by matching a regular expression
+class IndexedImportDialog:public QDialog
+{
+	Q_OBJECT
+	
+	public:
+		
+		IndexedImportDialog(FASTAIndex *,QWidget* parent = 0, Qt::WindowFlags f = 0 );
+		~IndexedImportDialog();
+		
+		QStringList selectedNames(){return selected_;}
+		
+	public slots:
+		
+		virtual void accept();
+		
+	private slots:
+		
+		void modeChanged();
+		void updateMatches();
+		
+	private:
+		
+		bool select(QString &);
+		
+		FASTAIndex *index_;
+		QStringList selected_;
+		
+		QRadioButton *namesButton_,*regexButton_;
+		QPlainTextEdit *namesEditor_;
+		QLineEdit *regexEditor_;
+		QLabel *matchLabel_;
+		QDialogButtonBox *buttonBox_;
+};
+
+#endif
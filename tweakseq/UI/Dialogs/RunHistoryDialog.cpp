@@ -0,0 +1,215 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <QtDebug>
+#include "DebuggingInfo.h"
+
+#include <QDialogButtonBox>
+#include <QFont>
+#include <QHeaderView>
+#include <QMap>
+#include <QTabWidget>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+#include "RunHistory.h"
+#include "RunHistoryDialog.h"
+
+// A table cell which sorts by number
+class NumberItem:public QTableWidgetItem
+{
+	public:
+		
+		NumberItem(double v,const QString &txt):QTableWidgetItem(txt),value_(v){setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);}
+		virtual bool operator<(const QTableWidgetItem &other) const
+		{
+			const NumberItem *n = dynamic_cast<const NumberItem *>(&other);
+			return n ? value_ < n->value_ : QTableWidgetItem::operator<(other);
+		}
+		
+	private:
+		
+		double value_;
+};
+
+// The runs of one tool on one dataset
+struct Summary
+{
+	int nseqs,maxLength,runs,failures,rssRuns;
+	qint64 residues;
+	double wall,cpu,rss;
+	QString tool;
+};
+
+static QTableWidgetItem *number(double v,int precision=0)
+{
+	return new NumberItem(v,QString::number(v,'f',precision));
+}
+
+RunHistoryDialog::RunHistoryDialog(RunHistory &history,QWidget * parent, Qt::WindowFlags f ):QDialog(parent,f),history_(history)
+{
+	setWindowTitle("Alignment run history");
+	setMinimumSize(800,400);
+	
+	QVBoxLayout *vb = new QVBoxLayout();
+	setLayout(vb);
+	
+	QTabWidget *tabs = new QTabWidget(this);
+	vb->addWidget(tabs);
+	
+	comparison_ = new QTableWidget(this);
+	tabs->addTab(comparison_,"Comparison");
+	runs_ = new QTableWidget(this);
+	tabs->addTab(runs_,"Runs");
+	
+	fillComparison();
+	fillRuns();
+	
+	QDialogButtonBox *bb = new QDialogButtonBox(QDialogButtonBox::Close);
+	vb->addWidget(bb);
+	connect(bb, SIGNAL(rejected()), this, SLOT(reject()));
+}
+
+RunHistoryDialog::~RunHistoryDialog()
+{
+}
+
+//
+//	Private
+//
+
+// One row for each dataset and tool, with the means of the successful runs
+void RunHistoryDialog::fillComparison()
+{
+	QMap<QString,Summary> summaries; // ordered by dataset, then tool
+	for (int i=0;i<history_.size();i++){
+		const RunRecord &r = history_.at(i);
+		QString tool = r.tool + (r.version.isEmpty() ? "" : " " + r.version);
+		QString key = QString("%1\t%2\t%3").arg(r.nseqs,10,10,QChar('0')).arg(r.residues,15,10,QChar('0')).arg(tool);
+		if (!summaries.contains(key)){
+			Summary s;
+			s.nseqs=r.nseqs;
+			s.residues=r.residues;
+			s.maxLength=r.maxLength;
+			s.runs=s.failures=s.rssRuns=0;
+			s.wall=s.cpu=s.rss=0.0;
+			s.tool=tool;
+			summaries.insert(key,s);
+		}
+		Summary &s = summaries[key];
+		if (!r.ok){
+			s.failures++;
+			continue;
+		}
+		s.runs++;
+		s.wall += r.usage.wall/1000.0;
+		s.cpu += (r.usage.user + r.usage.sys)/1000.0;
+		if (r.usage.peakRSS > 0){ // 0 is unknown
+			s.rss += r.usage.peakRSS/1024.0;
+			s.rssRuns++;
+		}
+	}
+	
+	QStringList headers;
+	headers << "Sequences" << "Residues" << "Longest" << "Tool" << "Runs" << "Failed" << "Wall (s)" << "CPU (s)" << "Peak RSS (MB)";
+	comparison_->setColumnCount(headers.size());
+	comparison_->setHorizontalHeaderLabels(headers);
+	comparison_->setRowCount(summaries.size());
+	comparison_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	
+	// The fastest tool for each dataset is in bold
+	QMap<QString,double> fastest;
+	QMapIterator<QString,Summary> it(summaries);
+	while (it.hasNext()){
+		it.next();
+		const Summary &s = it.value();
+		if (s.runs == 0) continue;
+		QString dataset = it.key().section('\t',0,1);
+		double w = s.wall/s.runs;
+		if (!fastest.contains(dataset) || w < fastest.value(dataset))
+			fastest.insert(dataset,w);
+	}
+	
+	int row=0;
+	it.toFront();
+	while (it.hasNext()){
+		it.next();
+		const Summary &s = it.value();
+		QString dataset = it.key().section('\t',0,1);
+		comparison_->setItem(row,0,number(s.nseqs));
+		comparison_->setItem(row,1,number(s.residues));
+		comparison_->setItem(row,2,number(s.maxLength));
+		QTableWidgetItem *toolItem = new QTableWidgetItem(s.tool);
+		comparison_->setItem(row,3,toolItem);
+		comparison_->setItem(row,4,number(s.runs));
+		comparison_->setItem(row,5,number(s.failures));
+		if (s.runs > 0){
+			comparison_->setItem(row,6,number(s.wall/s.runs,2));
+			comparison_->setItem(row,7,number(s.cpu/s.runs,2));
+			if (s.rssRuns > 0)
+				comparison_->setItem(row,8,number(s.rss/s.rssRuns,1));
+			if (s.wall/s.runs == fastest.value(dataset)){
+				QFont font = toolItem->font();
+				font.setBold(true);
+				toolItem->setFont(font);
+			}
+		}
+		row++;
+	}
+	comparison_->setSortingEnabled(true);
+	comparison_->resizeColumnsToContents();
+	comparison_->horizontalHeader()->setStretchLastSection(true);
+}
+
+void RunHistoryDialog::fillRuns()
+{
+	QStringList headers;
+	headers << "When" << "Job" << "Tool" << "Sequences" << "Residues" << "Longest" << "Result"
+		<< "Wall (s)" << "User (s)" << "Sys (s)" << "Peak RSS (MB)" << "Measured";
+	runs_->setColumnCount(headers.size());
+	runs_->setHorizontalHeaderLabels(headers);
+	runs_->setRowCount(history_.size());
+	runs_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	
+	for (int i=0;i<history_.size();i++){
+		const RunRecord &r = history_.at(i);
+		runs_->setItem(i,0,new QTableWidgetItem(r.when.toString(Qt::ISODate)));
+		runs_->setItem(i,1,new QTableWidgetItem(r.job));
+		runs_->setItem(i,2,new QTableWidgetItem(r.tool + (r.version.isEmpty() ? "" : " " + r.version)));
+		runs_->setItem(i,3,number(r.nseqs));
+		runs_->setItem(i,4,number(r.residues));
+		runs_->setItem(i,5,number(r.maxLength));
+		runs_->setItem(i,6,new QTableWidgetItem(r.ok ? "ok" : "failed"));
+		runs_->setItem(i,7,number(r.usage.wall/1000.0,2));
+		runs_->setItem(i,8,number(r.usage.user/1000.0,2));
+		runs_->setItem(i,9,number(r.usage.sys/1000.0,2));
+		runs_->setItem(i,10,r.usage.peakRSS > 0 ? number(r.usage.peakRSS/1024.0,1) : new NumberItem(0,"")); // unknown
+		runs_->setItem(i,11,new QTableWidgetItem(r.usage.exact ? "exact" : "sampled"));
+	}
+	runs_->setSortingEnabled(true);
+	runs_->resizeColumnsToContents();
+	runs_->horizontalHeader()->setStretchLastSection(true);
+}
@@ -0,0 +1,181 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <QtDebug>
+#include "DebuggingInfo.h"
+
+#include <QBrush>
+#include <QColor>
+#include <QFile>
+#include <QTextStream>
+
+#include "MessageLog.h"
+
+#define DEFAULT_MAX_LINES 10000
+#define UPDATE_INTERVAL 100 // ms
+
+//
+//	Public
+//
+
+MessageLog::MessageLog(QObject *parent):QAbstractListModel(parent)
+{
+	first_=0;
+	count_=0;
+	maxLines_=DEFAULT_MAX_LINES;
+	ring_.resize(maxLines_);
+	
+	logFile_=NULL;
+	logStream_=NULL;
+	
+	timer_.setSingleShot(true);
+	connect(&timer_,SIGNAL(timeout()),this,SLOT(flush()));
+}
+
+MessageLog::~MessageLog()
+{
+	QString errmsg;
+	setLogFile("",errmsg);
+}
+
+// Keeps the newest lines when the cap is reduced
+void MessageLog::setMaxLines(int n)
+{
+	if (n < 1 || n == maxLines_) return;
+	
+	beginResetModel();
+	int nkeep = qMin(count_,n);
+	QVector<Line> newRing(n);
+	for (int l=0;l<nkeep;l++)
+		newRing[l] = ring_.at((first_ + count_ - nkeep + l) % maxLines_);
+	ring_=newRing;
+	first_=0;
+	count_=nkeep;
+	maxLines_=n;
+	while (pending_.size() > maxLines_)
+		pending_.removeFirst();
+	endResetModel();
+}
+
+bool MessageLog::setLogFile(const QString &fname,QString &errmsg)
+{
+	if (logFile_ != NULL){
+		logStream_->flush();
+		delete logStream_;
+		delete logFile_;
+		logStream_=NULL;
+		logFile_=NULL;
+		logFileName_="";
+	}
+	
+	if (fname.isEmpty()) return true;
+	
+	logFile_ = new QFile(fname);
+	if (!logFile_->open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)){
+		errmsg = "Unable to open " + fname + " : " + logFile_->errorString();
+		delete logFile_;
+		logFile_=NULL;
+		return false;
+	}
+	logStream_ = new QTextStream(logFile_);
+	logFileName_=fname;
+	return true;
+}
+
+void MessageLog::append(const QString &text,bool isError)
+{
+	Line line;
+	line.text=text;
+	line.isError=isError;
+	pending_.append(line);
+	
+	if (logStream_ != NULL)
+		*logStream_ << (isError ? "! " : "  ") << text << "\n";
+	
+	// Lines which would be dropped at the next update anyway aren't kept
+	if (pending_.size() > maxLines_)
+		pending_.removeFirst();
+	
+	if (!timer_.isActive())
+		timer_.start(UPDATE_INTERVAL);
+}
+
+void MessageLog::clear()
+{
+	beginResetModel();
+	first_=0;
+	count_=0;
+	pending_.clear();
+	endResetModel();
+}
+
+int MessageLog::rowCount(const QModelIndex &parent) const
+{
+	if (parent.isValid()) return 0;
+	return count_;
+}
+
+QVariant MessageLog::data(const QModelIndex &index,int role) const
+{
+	if (!index.isValid() || index.row() >= count_) return QVariant();
+	
+	const Line &line = ring_.at((first_ + index.row()) % maxLines_);
+	if (role == Qt::DisplayRole)
+		return line.text;
+	if (role == Qt::ForegroundRole && line.isError)
+		return QBrush(QColor(255,32,32));
+	return QVariant();
+}
+
+//
+//	Private slots
+//
+
+void MessageLog::flush()
+{
+	if (logStream_ != NULL)
+		logStream_->flush();
+	
+	int n = pending_.size();
+	if (n == 0) return;
+	
+	// Drop the oldest lines to make room
+	int nremove = qMin(count_,count_ + n - maxLines_);
+	if (nremove > 0){
+		beginRemoveRows(QModelIndex(),0,nremove-1);
+		first_ = (first_ + nremove) % maxLines_;
+		count_ -= nremove;
+		endRemoveRows();
+	}
+	
+	beginInsertRows(QModelIndex(),count_,count_ + n - 1);
+	for (int l=0;l<n;l++)
+		ring_[(first_ + count_ + l) % maxLines_] = pending_.at(l);
+	count_ += n;
+	endInsertRows();
+	
+	pending_.clear();
+}
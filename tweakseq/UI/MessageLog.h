@@ -0,0 +1,90 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef __MESSAGE_LOG_H_
+#define __MESSAGE_LOG_H_
+
+#include <QAbstractListModel>
+#include <QList>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+
+class QFile;
+class QTextStream;
+
+// The lines in the message window, kept in a ring buffer with a cap on the number of lines.
+// Lines are buffered and added to the model at a fixed rate, so a verbose aligner costs one view update 
+// per interval, rather than one per line. Optionally, every line is also written to a log file, 
+// so nothing is lost when old lines are dropped.
+
+class MessageLog:public QAbstractListModel
+{
+	Q_OBJECT
+	
+	public:
+		
+		MessageLog(QObject *parent=NULL);
+		~MessageLog();
+		
+		void setMaxLines(int);
+		int maxLines(){return maxLines_;}
+		
+		bool setLogFile(const QString &,QString &); // an empty name closes the log file
+		QString logFile(){return logFileName_;}
+		
+		void append(const QString &,bool);
+		void clear();
+		
+		virtual int rowCount(const QModelIndex &parent=QModelIndex()) const;
+		virtual QVariant data(const QModelIndex &,int role=Qt::DisplayRole) const;
+		
+	private slots:
+		
+		void flush();
+		
+	private:
+		
+		struct Line
+		{
+			QString text;
+			bool isError;
+		};
+		
+		QVector<Line> ring_;
+		int first_; // index in ring_ of the oldest line
+		int count_;
+		int maxLines_;
+		
+		QList<Line> pending_;
+		QTimer timer_;
+		
+		QString logFileName_;
+		QFile *logFile_;
+		QTextStream *logStream_;
+};
+
+#endif
@@ -24,14 +24,33 @@
 // THE SOFTWARE.
 //
 
+#include <QtDebug>
+#include "DebuggingInfo.h"
 
+#include <QApplication>
+#include <QClipboard>
+#include <QContextMenuEvent>
+#include <QDomDocument>
+#include <QKeyEvent>
+#include <QMenu>
+#include <QScrollBar>
+
+#include "MessageLog.h"
 #include "MessageWin.h"
+#include "XMLHelper.h"
 
 MessageWin::MessageWin(QWidget *parent)
-	:QTextEdit(parent){
+	:QListView(parent){
 	
-	setReadOnly(true);
+	log_ = new MessageLog(this);
+	setModel(log_);
+	setUniformItemSizes(true); // lets the view skip measuring every line
+	setSelectionMode(QAbstractItemView::ExtendedSelection);
+	setEditTriggers(QAbstractItemView::NoEditTriggers);
+	atBottom_=true;
 	
+	connect(log_,SIGNAL(rowsAboutToBeInserted(const QModelIndex &,int,int)),this,SLOT(aboutToAddLines()));
+	connect(log_,SIGNAL(rowsInserted(const QModelIndex &,int,int)),this,SLOT(linesAdded()));
 };
 
 MessageWin::~MessageWin(){
@@ -39,11 +58,88 @@ MessageWin::~MessageWin(){
 }
 
 void MessageWin::addMessage(QString s,int msgType){
-	if (msgType == MessageWin::Information){
-		// keep defaults
+	QStringList lines = s.split('\n');
+	if (lines.size() > 1 && lines.last().isEmpty())
+		lines.removeLast();
+	for (int l=0;l<lines.size();l++)
+		log_->append(lines.at(l),msgType == MessageWin::Error);
+}
+
+void MessageWin::writeSettings(QDomDocument &doc,QDomElement &parentElem)
+{
+	QDomElement pelem = doc.createElement("message_log");
+	parentElem.appendChild(pelem);
+	XMLHelper::addElement(doc,pelem,"max_lines",QString::number(log_->maxLines()));
+	XMLHelper::addElement(doc,pelem,"log_file",log_->logFile());
+}
+
+void MessageWin::readSettings(QDomDocument &doc)
+{
+	QDomNodeList nl = doc.elementsByTagName("message_log");
+	if (nl.count() == 1){
+		QDomNode gNode = nl.item(0);
+		QDomElement elem = gNode.firstChildElement();
+		while (!elem.isNull()){
+			if (elem.tagName() == "max_lines"){
+				log_->setMaxLines(elem.text().toInt());
+			}
+			else if (elem.tagName() == "log_file"){
+				QString errmsg;
+				if (elem.text() != log_->logFile() && !log_->setLogFile(elem.text(),errmsg))
+					addMessage(errmsg,MessageWin::Error);
+			}
+			elem=elem.nextSiblingElement();
+		}
 	}
-	else if (msgType == MessageWin::Error)
-		setTextColor(QColor(255,32,32));
-	append(s);
-	//setCursorPosition(numLines(),0,FALSE);
+}
+
+//
+// Protected
+//
+
+void MessageWin::contextMenuEvent(QContextMenuEvent *ev)
+{
+	QMenu menu(this);
+	QAction *copyAction = menu.addAction(tr("Copy"));
+	copyAction->setEnabled(selectionModel()->hasSelection());
+	QAction *clearAction = menu.addAction(tr("Clear"));
+	QAction *action = menu.exec(ev->globalPos());
+	if (action == copyAction)
+		copySelection();
+	else if (action == clearAction)
+		log_->clear();
+}
+
+void MessageWin::keyPressEvent(QKeyEvent *ev)
+{
+	if (ev->matches(QKeySequence::Copy))
+		copySelection();
+	else
+		QListView::keyPressEvent(ev);
+}
+
+//
+// Private slots
+//
+
+// Follow the output, unless the user has scrolled back
+void MessageWin::aboutToAddLines()
+{
+	atBottom_ = (verticalScrollBar()->value() == verticalScrollBar()->maximum());
+}
+
+void MessageWin::linesAdded()
+{
+	if (atBottom_)
+		scrollToBottom();
+}
+
+void MessageWin::copySelection()
+{
+	QModelIndexList sel = selectionModel()->selectedRows();
+	qSort(sel);
+	QStringList lines;
+	for (int i=0;i<sel.size();i++)
+		lines.append(log_->data(sel.at(i)).toString());
+	QApplication::clipboard()->setText(lines.join("\n"));
 }
@@ -27,12 +27,19 @@
 #ifndef __MESSAGE_WIN_H_
 #define __MESSAGE_WIN_H_
 
-#include <QTextEdit> 
+#include <QListView> 
 
-class QWidget;
+class QDomDocument;
+class QDomElement;
 class QString;
+class QWidget;
+
+class MessageLog;
 
-class MessageWin: public QTextEdit{
+// Shows messages, mostly aligner output. The view only renders the visible lines,
+// so it stays cheap however much output there is.
+
+class MessageWin: public QListView{
 	Q_OBJECT
 	
 	public:
@@ -41,6 +48,26 @@ class MessageWin: public QTextEdit{
 		~MessageWin();
 		void addMessage(QString,int msgType=Information);
 		
+		MessageLog *log(){return log_;}
+		
+		void writeSettings(QDomDocument &,QDomElement &);
+		void readSettings(QDomDocument &);
+		
+	protected:
+		
+		virtual void contextMenuEvent(QContextMenuEvent *);
+		virtual void keyPressEvent(QKeyEvent *);
+		
+	private slots:
+		
+		void aboutToAddLines();
+		void linesAdded();
+		void copySelection();
+		
+	private:
+		
+		MessageLog *log_;
+		bool atBottom_;
 };
 
-#endif
\ No newline at end of file
+#endif
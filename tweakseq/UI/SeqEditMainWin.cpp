@@ -42,6 +42,7 @@
 #include <QCloseEvent>
 #include <QComboBox>
 #include <QDateTime>
+#include <QDockWidget>
 #include <QFile>
 #include <QFileDialog>
 #include <QFontDialog>
@@ -53,7 +54,7 @@
 #include <QPixmap>
 #include <QPrinter>
 #include <QPrintDialog>
-#include <QProcess>
+#include <QProgressBar>
 #include <QPushButton>
 #include <QScrollBar>
 #include <QSet>
@@ -65,20 +66,36 @@
 #include <QToolButton>
 
 
-#include "Application.h"
+#include "A3MFile.h"
+#include "AlignmentCache.h"
+#include "AlignmentJob.h"
+#include "AlignmentJobsPanel.h"
+#include "AlignmentQueue.h"
 #include "AlignmentTool.h"
+#include "Application.h"
+#include "AlignmentBudgetDlg.h"
 #include "AlignmentToolDlg.h"
+#include "BufferedWriter.h"
 #include "Clipboard.h"
 #include "ClustalFile.h"
 #include "ClustalO.h"
+#include "ClusterAligner.h"
+#include "ColumnWindow.h"
+#include "CostModel.h"
+#include "ExportJob.h"
 #include "FASTAFile.h"
+#include "FASTAIndex.h"
 #include "GoToTool.h"
 #include "ImportDialog.h"
+#include "IndexedImportDialog.h"
+#include "MessageLog.h"
 #include "MessageWin.h"
 #include "Muscle.h"
+#include "PairwiseAligner.h"
 #include "PDBFile.h"
 #include "Project.h"
 #include "ResidueSelection.h"
+#include "RunHistoryDialog.h"
 #include "SearchTool.h"
 #include "SequenceEditor.h"
 #include "SeqEditMainWin.h"
@@ -140,6 +157,18 @@ SeqEditMainWin::SeqEditMainWin(Project *project)
 	split->setSizes(wsizes);
 	
 	setCentralWidget(split);
+	
+	alignmentQueue_ = new AlignmentQueue(this);
+	alignmentCache_ = new AlignmentCache(app->applicationTmpPath() + "/cache");
+	connect(alignmentQueue_,SIGNAL(jobChanged(AlignmentJob *)),this,SLOT(alignmentJobChanged(AlignmentJob *)));
+	connect(alignmentQueue_,SIGNAL(jobFinished(AlignmentJob *)),this,SLOT(alignmentJobFinished(AlignmentJob *)));
+	connect(alignmentQueue_,SIGNAL(jobProgress(AlignmentJob *)),this,SLOT(alignmentJobProgress(AlignmentJob *)));
+	
+	alignmentJobsDock_ = new QDockWidget(tr("Alignment jobs"),this);
+	alignmentJobsDock_->setObjectName("AlignmentJobsDock");
+	alignmentJobsDock_->setWidget(new AlignmentJobsPanel(alignmentQueue_,alignmentJobsDock_));
+	addDockWidget(Qt::BottomDockWidgetArea,alignmentJobsDock_);
+	alignmentJobsDock_->hide();
 
 	// need to connect to other widgets so do create actions last
 	createActions();
@@ -166,9 +195,13 @@ SeqEditMainWin::SeqEditMainWin(Project *project)
 }
 
 SeqEditMainWin::~SeqEditMainWin(){
+	alignmentQueue_->cancelAll();
+	delete alignmentCache_;
+	if (exportJob_ != NULL){
+		exportJob_->cancel();
+		delete exportJob_; // waits for the worker
+	}
 	delete printer;
-	if (alignmentFileIn_ != NULL) delete alignmentFileIn_;
-	if (alignmentFileOut_ != NULL) delete alignmentFileOut_;
 }
 
 
@@ -198,7 +231,18 @@ void SeqEditMainWin::writeSettings(QDomDocument &doc,QDomElement &parentElem)
 	XMLHelper::addElement(doc,pelem,"editor_window_height",QString::number(splitterHeights.at(0)));
 	XMLHelper::addElement(doc,pelem,"message_window_height",QString::number(splitterHeights.at(1)));
 	
+	QDomElement belem = doc.createElement("alignment_budget");
+	parentElem.appendChild(belem);
+	XMLHelper::addElement(doc,belem,"seconds",QString::number(budget_.seconds));
+	XMLHelper::addElement(doc,belem,"memory",QString::number(budget_.mb));
+	XMLHelper::addElement(doc,belem,"quality",AlignmentTool::tierName(budget_.tier));
+	
+	QDomElement eelem = doc.createElement("export");
+	parentElem.appendChild(eelem);
+	XMLHelper::addElement(doc,eelem,"line_width",QString::number(exportLineWidth_));
+	
 	se->writeSettings(doc,parentElem);
+	mw->writeSettings(doc,parentElem);
 }
 
 void SeqEditMainWin::readSettings(QDomDocument &doc)
@@ -228,7 +272,35 @@ void SeqEditMainWin::readSettings(QDomDocument &doc)
 		setGeometry(0,0,w,h);
 		split->setSizes(wsizes);
 	}
+	nl = doc.elementsByTagName("alignment_budget");
+	if (nl.count() == 1){
+		QDomElement elem = nl.item(0).firstChildElement();
+		while (!elem.isNull()){
+			if (elem.tagName() == "seconds"){
+				budget_.seconds=elem.text().toInt();
+			}
+			else if (elem.tagName() == "memory"){
+				budget_.mb=elem.text().toInt();
+			}
+			else if (elem.tagName() == "quality"){
+				for (int t=AlignmentTool::Draft;t<=AlignmentTool::Refined;t++)
+					if (elem.text() == AlignmentTool::tierName(t)) budget_.tier=t;
+			}
+			elem=elem.nextSiblingElement();
+		}
+	}
+	nl = doc.elementsByTagName("export");
+	if (nl.count() == 1){
+		QDomElement elem = nl.item(0).firstChildElement();
+		while (!elem.isNull()){
+			if (elem.tagName() == "line_width"){
+				exportLineWidth_=qMax(0,elem.text().toInt());
+			}
+			elem=elem.nextSiblingElement();
+		}
+	}
 	se->readSettings(doc);
+	mw->readSettings(doc);
 	setupAlignmentActions(); 
 	updateSettingsActions();  
 }
@@ -246,6 +318,11 @@ void SeqEditMainWin::closeEvent(QCloseEvent *ev)
 {
 	if (maybeSave()) {
 		// FIXME do some more stuff ?
+		if (exportJob_ != NULL){
+			exportJob_->cancel();
+			exportJob_->wait();
+		}
+		alignmentQueue_->cancelAll();
 		ev->accept();
 	} else {
 		ev->ignore();
@@ -311,25 +388,13 @@ void SeqEditMainWin::fileSaveProjectAs()
 	
 void SeqEditMainWin::fileImport(){
 	
-	// This will only run the first time sequence are imported
 	bool firstRun=false;
-	if (project_->sequenceDataType() == SequenceFile::Unknown){
-		firstRun=true;
-		ImportDialog idlg(SequenceFile::Proteins,this);
-		if (QDialog::Accepted == idlg.exec()){
-			int ret = idlg.dataType();
-			qDebug() << trace.header(__PRETTY_FUNCTION__) << ret;
-			project_->setSequenceDataType(ret);
-			se->setSequenceDataType(ret);
-		}
-		else{
-			statusBar()->showMessage("The import was canceled");
-			return;
-		}
-	}
+	if (!selectSequenceDataType(firstRun))
+		return;
 	
 	FASTAFile ff;
 	ClustalFile cf;
+	A3MFile    af;
 	PDBFile    pf;
 	
 	QString allext="";
@@ -342,6 +407,10 @@ void SeqEditMainWin::fileImport(){
 	for (int s=0;s<ext.size();s++)
 		allext = allext + ext.at(s) + " ";
 	
+	ext = af.extensions(project_->sequenceDataType());
+	for (int s=0;s<ext.size();s++)
+		allext = allext + ext.at(s) + " ";
+	
 	if (project_->sequenceDataType() == SequenceFile::Proteins){
 		ext = pf.extensions( SequenceFile::Proteins);
 		for (int s=0;s<ext.size();s++)
@@ -364,10 +433,8 @@ void SeqEditMainWin::fileImport(){
     msg,startDir, allext);
 	qDebug() << trace.header() << files;
 	if (files.isEmpty()){ 
-		if (firstRun){ // cancelling means reset back to unknown 
-			project_->setSequenceDataType(SequenceFile::Unknown); 
-			se->setSequenceDataType(SequenceFile::Unknown);
-		}
+		if (firstRun) // cancelling means reset back to unknown 
+			resetSequenceDataType();
 		return;
 	}
 	QString errmsg;
@@ -381,19 +448,138 @@ void SeqEditMainWin::fileImport(){
 	
 }
 
+void SeqEditMainWin::fileImportIndexed()
+{
+	bool firstRun=false;
+	if (!selectSequenceDataType(firstRun))
+		return;
+	
+	QString startDir = "./";
+	if (!lastImportedFile.isEmpty()){
+		QFileInfo fi(lastImportedFile);
+		if (!fi.absolutePath().isEmpty())
+			startDir = fi.absolutePath();
+	}
+	
+	FASTAFile ff;
+	QStringList ext = ff.extensions(project_->sequenceDataType());
+	QString fname = QFileDialog::getOpenFileName(this,tr("Open indexed FASTA file"),startDir,
+		"FASTA Files (" + ext.join(" ") + ")");
+	if (fname.isNull()){
+		if (firstRun)
+			resetSequenceDataType();
+		return;
+	}
+	
+	QString errmsg;
+	FASTAIndex idx(fname);
+	if (!project_->loadFASTAIndex(idx,errmsg)){
+		QMessageBox::critical(this, tr("Error during import"),errmsg);
+		if (firstRun)
+			resetSequenceDataType();
+		return;
+	}
+	
+	IndexedImportDialog dlg(&idx,this);
+	if (QDialog::Accepted != dlg.exec()){
+		statusBar()->showMessage("The import was canceled");
+		if (firstRun)
+			resetSequenceDataType();
+		return;
+	}
+	
+	if (!project_->importIndexedSequences(idx,dlg.selectedNames(),errmsg))
+		QMessageBox::critical(this, tr("Error during import"),errmsg);
+	else
+		lastImportedFile=fname;
+	
+	updateGoToTool();
+}
+
+void SeqEditMainWin::fileViewMapped()
+{
+	QString startDir = "./";
+	if (!lastImportedFile.isEmpty()){
+		QFileInfo fi(lastImportedFile);
+		if (!fi.absolutePath().isEmpty())
+			startDir = fi.absolutePath();
+	}
+	
+	FASTAFile ff;
+	QStringList ext = ff.extensions(SequenceFile::Proteins) + ff.extensions(SequenceFile::DNA);
+	ext.removeDuplicates();
+	QString fname = QFileDialog::getOpenFileName(this,tr("View FASTA alignment"),startDir,
+		"FASTA Files (" + ext.join(" ") + ")");
+	if (fname.isNull()) return;
+	
+	// The view replaces the sequences so a new project is used unless this one is empty
+	Project *proj = project_;
+	if (!project_->empty()){
+		proj = app->createProject();
+		proj->createMainWindow();
+	}
+	
+	QString errmsg;
+	if (!proj->viewMappedAlignment(fname,errmsg))
+		QMessageBox::critical(this, tr("Error while opening alignment"),errmsg);
+	else
+		lastImportedFile=fname;
+}
+
 void SeqEditMainWin::fileExportFASTA(){
 	QString fname = QFileDialog::getSaveFileName(this,tr("Export as FASTA"));
 	if (fname.isNull()) return;
-	project_->exportFASTA(fname,true); // FIXME hardcoded
+	startExport(fname,FASTA);
 }
 
 void SeqEditMainWin::fileExportClustalW()
 {
-	QString fname = QFileDialog::getSaveFileName(this,tr("Export as FASTA"));
+	QString fname = QFileDialog::getSaveFileName(this,tr("Export as ClustalW"));
 	if (fname.isNull()) return;
-	project_->exportClustalW(fname,true); // FIXME hardcoded
+	startExport(fname,CLUSTALW);
 }
 
+void SeqEditMainWin::fileExportA3M()
+{
+	QString fname = QFileDialog::getSaveFileName(this,tr("Export as A3M"));
+	if (fname.isNull()) return;
+	startExport(fname,A3M);
+}
+
+void SeqEditMainWin::exportProgress(int n,int ntot)
+{
+	exportProgress_->setMaximum(ntot);
+	exportProgress_->setValue(n);
+}
+
+void SeqEditMainWin::exportFinished(bool ok)
+{
+	if (exportJob_ == NULL) return;
+	
+	if (ok)
+		statusBar()->showMessage(tr("Exported ") + exportJob_->fileName(),5000);
+	else if (exportJob_->cancelled())
+		statusBar()->showMessage(tr("Export cancelled"),5000);
+	else
+		QMessageBox::warning(this, tr("Export failed"),exportJob_->fileName() + " : " + exportJob_->lastError());
+	
+	exportProgress_->hide();
+	exportCancel_->hide();
+	exportJob_->deleteLater();
+	exportJob_=NULL;
+	
+	exportFASTAAction->setEnabled(true);
+	exportClustalWAction->setEnabled(true);
+	exportA3MAction->setEnabled(true);
+}
+
+void SeqEditMainWin::exportCancel()
+{
+	if (exportJob_ != NULL)
+		exportJob_->cancel();
+}
+
+
 void SeqEditMainWin::filePrint(){
 	
 	int pg,numPages;
@@ -783,9 +969,21 @@ void SeqEditMainWin::setupAlignmentActions()
 {
 	alignAllAction->setEnabled(project_->sequences.size() >= 2);
 	alignSelectionAction->setEnabled(project_->sequenceSelection->size() >= 2);
-	if (NULL != alignmentProc_){
-		alignStopAction->setEnabled(alignmentProc_->state() == QProcess::Running);
+	bool canAlignGroups=false;
+	for (int g=0;g<project_->sequenceGroups.size();g++){
+		if (project_->sequenceGroups.at(g)->size() >= 2){
+			canAlignGroups=true;
+			break;
+		}
 	}
+	alignGroupsAction->setEnabled(canAlignGroups);
+	int nSelected = project_->sequenceSelection->size();
+	alignAddAction->setEnabled(nSelected >= 1 && project_->sequences.size() - nSelected >= 1);
+	alignPairAction->setEnabled(nSelected == 2);
+	alignWindowAction->setEnabled(project_->residueSelection->size() >= 2);
+	alignClustersAction->setEnabled(project_->sequences.size() >= 2);
+	alignAutoAction->setEnabled(project_->sequences.size() >= 2);
+	alignStopAction->setEnabled(alignmentQueue_->numActive() > 0);
 }
 
 void SeqEditMainWin::alignmentAll()
@@ -800,66 +998,356 @@ void SeqEditMainWin::alignmentSelection()
 	startAlignment();
 }
 
-void SeqEditMainWin::alignmentStop()
+// Each group is aligned as a separate job, so that they run concurrently
+void SeqEditMainWin::alignmentGroups()
 {
 	qDebug() << trace.header(__PRETTY_FUNCTION__);
-	if (NULL != alignmentProc_){
-		alignmentProc_->kill();
-		// FIXME clean up ??
-		alignAllAction->setEnabled(true);
-		alignStopAction->setEnabled(false);
+	int nJobs=0;
+	for (int g=0;g<project_->sequenceGroups.size();g++){
+		SequenceGroup *sg = project_->sequenceGroups.at(g);
+		if (sg->size() < 2) continue;
+		QList<Sequence *> seqs;
+		for (int s=0;s<sg->size();s++)
+			seqs.append(sg->itemAt(s));
+		queueAlignment("group " + QString::number(g+1),seqs,false);
+		nJobs++;
 	}
+	statusBar()->showMessage(QString::number(nJobs) + " alignment jobs queued");
 }
 
-void SeqEditMainWin::alignmentStarted()
+// The selected sequences are added to the alignment of the remaining sequences,
+// without realigning them. The existing alignment is passed to the tool in a temporary file
+void SeqEditMainWin::alignmentAdd()
 {
-	qDebug() << trace.header() << "seqEditMainWin::alignmentStarted()";
-	statusBar()->showMessage("Alignment running");
-	alignAllAction->setEnabled(false);
-	alignStopAction->setEnabled(true);
+	qDebug() << trace.header(__PRETTY_FUNCTION__);
+	
+	// Snapshot of the existing alignment and of the sequences to add
+	QList<Sequence *> &all = project_->sequences.sequences();
+	SequenceSelection *sel = project_->sequenceSelection;
+	QStringList labels,residues;
+	QStringList addedLabels,addedResidues;
+	int width=0;
+	for (int s=0;s<all.size();s++){
+		Sequence *seq = all.at(s);
+		if (sel->contains(seq)){
+			addedLabels.append(seq->label);
+			addedResidues.append(seq->filter(true));
+		}
+		else{
+			labels.append(seq->label);
+			residues.append(seq->filter(false)); // every column, so they can be mapped back
+			width = qMax(width,residues.last().size());
+		}
+	}
+	for (int s=0;s<residues.size();s++){
+		if (residues.at(s).size() < width)
+			residues[s].append(QString(width - residues.at(s).size(),QChar('-')));
+	}
+	
+	// The file name is filled in later, and is left out of the cache key
+	AlignmentTool *tool = project_->alignmentTool();
+	QString exec;
+	QStringList args;
+	if (!tool->makeAddCommand("%alignment",addedLabels.size(),exec,args)){
+		QMessageBox::information(this,tr("tweakseq"),tool->name() + tr(" can't add ") +
+			(addedLabels.size() > 1 ? tr("several sequences") : tr("sequences")) + tr(" to an existing alignment"));
+		return;
+	}
+	
+	QString key = AlignmentCache::key(tool,exec,args,labels + addedLabels,residues + addedResidues);
+	QStringList newLabels,newSeqs;
+	if (alignmentCache_->lookup(key,newLabels,newSeqs)){
+		statusBar()->showMessage("Alignment taken from the cache: addition");
+		applyAlignment("addition",newLabels,newSeqs,false,addedLabels,ColumnWindow());
+		return;
+	}
+	
+	QTemporaryFile *alignmentFile = new QTemporaryFile(app->applicationTmpPath() + "/alignmentXXXXXX.fa");
+	if (!alignmentFile->open()){
+		delete alignmentFile;
+		QMessageBox::warning(this,tr("tweakseq"),tr("Unable to create a temporary file in ") + app->applicationTmpPath());
+		return;
+	}
+	// The records are numbered after the added sequences, which the job numbers from zero
+	FASTAFile ff;
+	BufferedWriter bw(alignmentFile);
+	for (int s=0;s<labels.size();s++)
+		ff.writeRecord(bw,QString::number(addedLabels.size() + s),residues.at(s),"");
+	bw.flush();
+	alignmentFile->close(); // the file is kept until the job is deleted
+	
+	args.replaceInStrings("%alignment",alignmentFile->fileName());
+	qDebug() <<  trace.header(__PRETTY_FUNCTION__) << exec << args;
+	
+	AlignmentJob *job = new AlignmentJob("addition",false);
+	for (int s=0;s<addedLabels.size();s++)
+		job->addSequence(addedLabels.at(s),addedResidues.at(s));
+	job->setCommand(exec,args);
+	job->setLimits(tool->memoryLimit(),tool->niceLevel());
+	job->setThreads(tool->threads(),tool->threaded() || tool->inProcess());
+	job->setProgressParser(tool->createProgressParser());
+	job->setToolInfo(tool->name(),tool->version());
+	job->setCacheKey(key);
+	job->setAddition(alignmentFile,addedLabels,labels);
+	
+	connect(job,SIGNAL(message(const QString &,bool)),this,SLOT(alignmentMessage(const QString &,bool)));
+	alignmentQueue_->add(job);
+	alignStopAction->setEnabled(alignmentQueue_->numActive() > 0);
 }
 
-void SeqEditMainWin::alignmentReadyReadStdOut()
+// Two sequences are aligned in-process, which is quick enough not to need a job
+void SeqEditMainWin::alignmentPair()
 {
-	//qDebug() << trace.header() << "SeqEditMainWin::alignmentReadyReadStdOut()";
-	QString msg  = QString(alignmentProc_->readAllStandardOutput());
-	mw->addMessage(msg);
+	qDebug() << trace.header(__PRETTY_FUNCTION__);
+	
+	QList<Sequence *> &sel = project_->sequenceSelection->sequences();
+	if (sel.size() != 2) return;
+	
+	PairwiseAligner pa(project_->sequenceDataType() == SequenceFile::DNA ? PairwiseAligner::DNA : PairwiseAligner::Protein);
+	QString a,b,errmsg;
+	QApplication::setOverrideCursor(Qt::WaitCursor);
+	bool ok = pa.align(sel.at(0)->filter(true),sel.at(1)->filter(true),a,b,errmsg);
+	QApplication::restoreOverrideCursor();
+	if (!ok){
+		QMessageBox::warning(this,tr("tweakseq"),errmsg);
+		return;
+	}
+	
+	mw->addMessage("Pairwise alignment of " + sel.at(0)->label + " and " + sel.at(1)->label +
+		": score " + QString::number(pa.alignmentScore()));
+	statusBar()->showMessage("Pairwise alignment finished");
+	project_->readNewAlignment(QStringList() << sel.at(0)->label << sel.at(1)->label,QStringList() << a << b,false);
+	se->updateViewport();
 }
 
-void SeqEditMainWin::alignmentReadyReadStdErr()
+// Only the selected block of columns is realigned, so the run time depends on the size of the block, 
+// not of the alignment. The block is spliced back in when the job finishes.
+void SeqEditMainWin::alignmentWindow()
 {
-	qDebug() << trace.header() << "SeqEditMainWin::alignmentReadyReadStdErr()";
-	QString msg  = QString(alignmentProc_->readAllStandardError());
-	mw->addMessage(msg,MessageWin::Error);
+	qDebug() << trace.header(__PRETTY_FUNCTION__);
+	
+	QList<ResidueGroup *> &rgs = project_->residueSelection->residueGroups();
+	if (rgs.size() < 2) return;
+	
+	ColumnWindow window;
+	window.start = qMin(rgs.at(0)->start,rgs.at(0)->stop);
+	window.stop  = qMax(rgs.at(0)->start,rgs.at(0)->stop);
+	
+	// The block is spliced back as a rectangle, so every sequence must cover the same columns, once
+	QSet<Sequence *> selected;
+	for (int r=0;r<rgs.size();r++){
+		ResidueGroup *rg = rgs.at(r);
+		if (qMin(rg->start,rg->stop) != window.start || qMax(rg->start,rg->stop) != window.stop || selected.contains(rg->sequence)){
+			QMessageBox::information(this,tr("tweakseq"),tr("The selected residues must be the same columns in each sequence"));
+			return;
+		}
+		selected.insert(rg->sequence);
+	}
+	
+	QStringList labels,residues;
+	for (int r=0;r<rgs.size();r++){
+		Sequence *seq = rgs.at(r)->sequence;
+		QString block = seq->residues.mid(window.start,window.stop - window.start + 1);
+		window.labels.append(seq->label);
+		window.blocks.append(block);
+		
+		// As for Sequence::filter(true), excluded residues aren't aligned. They're kept in place when the block is spliced back
+		QString res;
+		for (int c=0;c<block.size();c++){
+			if (block.at(c).unicode() & EXCLUDE_CELL) continue;
+			QChar ch = block.at(c).unicode() & REMOVE_FLAGS;
+			if (ch != '-' && ch != '.')
+				res.append(ch);
+		}
+		if (res.isEmpty()) continue; // nothing to align, it will just be padded
+		labels.append(seq->label);
+		residues.append(res);
+	}
+	
+	if (labels.size() < 2){
+		QMessageBox::information(this,tr("tweakseq"),tr("At least two of the selected sequences must have residues in the selected columns"));
+		return;
+	}
+	
+	queueAlignment("columns " + QString::number(window.start+1) + "-" + QString::number(window.stop+1),
+		labels,residues,false,window,NULL,false);
 }
 
-void SeqEditMainWin::alignmentFinished(int exitCode,QProcess::ExitStatus exitStatus)
+// Divide-and-conquer alignment of all the sequences, for sets too large to align in one run of the tool.
+// Each cluster is aligned with the current tool, and the clusters are then merged
+void SeqEditMainWin::alignmentClusters()
 {
-	qDebug() << trace.header(__PRETTY_FUNCTION__) << " exitCode=" << exitCode << " exitStatus=" << exitStatus;;
-	if (exitStatus == 0 && exitCode == 0){
-		QFile f(alignmentFileOut_->fileName());
-		if (alignmentProc_->state() == QProcess::NotRunning && f.exists()){
-			statusBar()->showMessage("Alignment finished");
-			// delete alignmentFileIn_; // FIXME reinstate
-			// alignmentFileIn_=NULL;
-			if (alignAll)
-				readNewAlignment(true);
-			else{
-				readNewAlignment(false);
-			}
+	bool ok;
+	int n = QInputDialog::getInt(this,tr("Align all in clusters"),tr("Maximum number of sequences in a cluster"),
+		clusterSize_,2,10000000,100,&ok);
+	if (!ok) return;
+	clusterSize_=n;
+	
+	QList<Sequence *> &seqs = project_->sequences.sequences();
+	QStringList labels,residues;
+	for (int s=0;s<seqs.size();s++){
+		labels.append(seqs.at(s)->label);
+		residues.append(seqs.at(s)->filter(true));
+	}
+	queueAlignment("all, in clusters",labels,residues,true,ColumnWindow(),
+		new ClusterAligner(project_->alignmentTool(),clusterSize_),true);
+}
+
+// Aligns all the sequences with the tool that the project's run history predicts will be fastest,
+// among those of at least the minimum quality that fit within the memory budget.
+// Each tool run in clusters is a candidate too, when there are more sequences than a cluster holds.
+void SeqEditMainWin::alignmentAuto()
+{
+	QList<Sequence *> &seqs = project_->sequences.sequences();
+	if (seqs.size() < 2) return;
+	QStringList labels,residues;
+	qint64 nResidues=0;
+	for (int s=0;s<seqs.size();s++){
+		labels.append(seqs.at(s)->label);
+		residues.append(seqs.at(s)->filter(true));
+		nResidues += residues.last().length();
+	}
+	int n = seqs.size();
+	double meanLength = (double) nResidues/n;
+	
+	CostModel model;
+	model.fit(project_->runHistory);
+	
+	QList<AlignmentTool *> candidates = project_->alignmentTools();
+	QList<AlignmentTool *> clusterTools; // owned here, until one is given to a job
+	if (n > clusterSize_){
+		for (int t=0;t<candidates.size();t++)
+			clusterTools.append(new ClusterAligner(candidates.at(t),clusterSize_));
+		candidates.append(clusterTools);
+	}
+	
+	mw->addMessage("Predicted costs of aligning " + QString::number(n) + " sequences, of mean length " +
+		QString::number(qRound(meanLength)),MessageWin::Information);
+	AlignmentTool *best=NULL;
+	double bestSeconds=0.0;
+	QList<AlignmentTool *> untried;
+	for (int c=0;c<candidates.size();c++){
+		AlignmentTool *tool = candidates.at(c);
+		if (tool->qualityTier() < budget_.tier) continue;
+		double seconds,mb;
+		if (!model.predict(tool->name(),n,meanLength,seconds,mb)){
+			untried.append(tool);
+			continue;
+		}
+		bool fits = (budget_.mb == 0 || mb < 0.0 || mb <= budget_.mb);
+		mw->addMessage("  " + tool->name() + " (" + AlignmentTool::tierName(tool->qualityTier()) + "): " + 
+			CostModel::formatCost(seconds,mb) + ", from " + QString::number(model.numRuns(tool->name())) + " runs" +
+			(fits ? "" : ", over the memory budget"),MessageWin::Information);
+		if (fits && (best == NULL || seconds < bestSeconds)){
+			best=tool;
+			bestSeconds=seconds;
 		}
 	}
-	else{
-		QString msg = "Alignment not completed";
-		if (exitCode == 9) // FIXME linux specific
-			msg += " (user interrupted)";
-		statusBar()->showMessage(msg);
+	
+	if (!untried.isEmpty()){
+		QStringList names;
+		for (int t=0;t<untried.size();t++)
+			names.append(untried.at(t)->name());
+		mw->addMessage("  no runs yet: " + names.join(", "),MessageWin::Information);
+		if (best == NULL){ // nothing to go on, so prefer the current tool
+			best = untried.contains(project_->alignmentTool()) ? project_->alignmentTool() : untried.first();
+		}
 	}
 	
-	alignAllAction->setEnabled(true);
+	if (best == NULL){
+		qDeleteAll(clusterTools);
+		QMessageBox::warning(this,tr("Align all"),
+			tr("None of the alignment tools of the minimum quality is predicted to fit within the memory budget."));
+		return;
+	}
+	
+	mw->addMessage("Aligning with " + best->name(),MessageWin::Information);
+	bool owned = clusterTools.removeOne(best);
+	qDeleteAll(clusterTools);
+	queueAlignment(owned ? "all, in clusters" : "all",labels,residues,true,ColumnWindow(),best,owned);
+}
+
+void SeqEditMainWin::alignmentHistory()
+{
+	RunHistoryDialog rd(project_->runHistory,this);
+	rd.exec();
+}
+
+void SeqEditMainWin::alignmentStop()
+{
+	qDebug() << trace.header(__PRETTY_FUNCTION__);
+	alignmentQueue_->cancelAll();
 	alignStopAction->setEnabled(false);
 }
 
+void SeqEditMainWin::alignmentJobChanged(AlignmentJob *job)
+{
+	if (job->state() == AlignmentJob::Running)
+		statusBar()->showMessage("Alignment running: " + job->name());
+	alignStopAction->setEnabled(alignmentQueue_->numActive() > 0);
+	alignmentJobProgress(job);
+}
+
+// The status bar follows the running job which is expected to finish last
+void SeqEditMainWin::alignmentJobProgress(AlignmentJob *)
+{
+	AlignmentJob *slowest=NULL;
+	QList<AlignmentJob *> &jobs = alignmentQueue_->jobs();
+	for (int j=0;j<jobs.size();j++){
+		AlignmentJob *job = jobs.at(j);
+		if (job->state() != AlignmentJob::Running || job->progress() < 0.0) continue;
+		if (NULL == slowest || job->eta() > slowest->eta())
+			slowest=job;
+	}
+	
+	if (NULL == slowest){
+		alignmentProgress_->hide();
+		alignmentEta_->hide();
+		return;
+	}
+	alignmentProgress_->setValue(qRound(slowest->progress()*1000.0));
+	alignmentEta_->setText(slowest->name() + ": " + slowest->progressText());
+	alignmentProgress_->show();
+	alignmentEta_->show();
+}
+
+void SeqEditMainWin::alignmentJobFinished(AlignmentJob *job)
+{
+	qDebug() << trace.header(__PRETTY_FUNCTION__) << job->name() << " " << job->stateText();
+	
+	if (job->state() != AlignmentJob::Cancelled)
+		project_->runHistory.add(job);
+	
+	// Each result is applied as it arrives, as its own undoable command
+	if (job->state() == AlignmentJob::Finished){
+		if (job->output().size() > 0){
+			statusBar()->showMessage("Alignment finished: " + job->name());
+			alignmentCache_->store(job->cacheKey(),job->output().labels(),job->output().sequences());
+			applyAlignment(job->name(),job->output().labels(),job->output().sequences(),job->isFullAlignment(),job->addedLabels(),job->window());
+		}
+		else
+			statusBar()->showMessage("No alignment was produced: " + job->name());
+		job->output().clear();
+	}
+	else if (job->state() == AlignmentJob::Cancelled){
+		statusBar()->showMessage("Alignment not completed (user interrupted): " + job->name());
+	}
+	else{
+		statusBar()->showMessage("Alignment not completed: " + job->name());
+	}
+	
+	alignStopAction->setEnabled(alignmentQueue_->numActive() > 0);
+	alignmentJobProgress(job);
+}
+
+void SeqEditMainWin::alignmentMessage(const QString &msg,bool isError)
+{
+	if (isError)
+		mw->addMessage(msg,MessageWin::Error);
+	else
+		mw->addMessage(msg);
+}
+
 void SeqEditMainWin::setupColourMapMenu()
 {
 	colourMapMenu->clear();
@@ -935,6 +1423,7 @@ void SeqEditMainWin::settingsAlignmentToolClustalO()
 	if (project_->alignmentTool()->name() != "clustalo"){
 		project_->setAlignmentTool("clustalo");
 		settingsAlignmentToolPropertiesAction->setText("clustalo");
+		settingsAlignmentToolPropertiesAction->setEnabled(true);
 	}
 }
 
@@ -943,6 +1432,7 @@ void SeqEditMainWin::settingsAlignmentToolMUSCLE()
 	if (project_->alignmentTool()->name() != "MUSCLE"){
 		project_->setAlignmentTool("MUSCLE");
 		settingsAlignmentToolPropertiesAction->setText("MUSCLE");
+		settingsAlignmentToolPropertiesAction->setEnabled(true);
 	}
 }
 
@@ -951,6 +1441,16 @@ void SeqEditMainWin::settingsAlignmentToolMAFFT()
 	if (project_->alignmentTool()->name() != "MAFFT"){
 		project_->setAlignmentTool("MAFFT");
 		settingsAlignmentToolPropertiesAction->setText("MAFFT");
+		settingsAlignmentToolPropertiesAction->setEnabled(true);
+	}
+}
+
+void SeqEditMainWin::settingsAlignmentToolBuiltIn()
+{
+	if (project_->alignmentTool()->name() != "built-in"){
+		project_->setAlignmentTool("built-in");
+		settingsAlignmentToolPropertiesAction->setText("built-in");
+		settingsAlignmentToolPropertiesAction->setEnabled(false); // nothing to configure
 	}
 }
 
@@ -960,6 +1460,41 @@ void SeqEditMainWin::settingsAlignmentToolProperties()
 		ad.exec();
 }
 
+void SeqEditMainWin::settingsAlignmentBudget()
+{
+	AlignmentBudgetDlg bd(budget_,this);
+	bd.exec();
+}
+
+
+// The number of residues per line in FASTA and Clustal exports
+void SeqEditMainWin::settingsExportLineWidth()
+{
+	bool ok;
+	int n = QInputDialog::getInt(this,tr("Export line width"),tr("Residues per line (0 for the format's default)"),
+		exportLineWidth_,0,1000000,10,&ok);
+	if (ok)
+		exportLineWidth_=n;
+}
+
+void SeqEditMainWin::settingsMessageLogLines()
+{
+	bool ok;
+	int n = QInputDialog::getInt(this,tr("Message log"),tr("Maximum number of lines kept"),
+		mw->log()->maxLines(),100,10000000,1000,&ok);
+	if (ok)
+		mw->log()->setMaxLines(n);
+}
+
+// Every message is appended to the file, including lines which have been dropped from the window
+void SeqEditMainWin::settingsMessageLogFile(bool on)
+{
+	QString errmsg;
+	if (!mw->log()->setLogFile(on ? app->applicationTmpPath() + "/messages.log" : "",errmsg)){
+		QMessageBox::warning(this,tr("tweakseq"),errmsg);
+		settingsMessageLogFileAction->setChecked(false);
+	}
+}
 
 void SeqEditMainWin::settingsSaveAppDefaults()
 {
@@ -1109,8 +1644,12 @@ void SeqEditMainWin::clearSearch(){
 void SeqEditMainWin::init()
 {
 	lastImportedFile="";
-	alignmentProc_=NULL;
-	alignmentFileOut_=alignmentFileIn_=NULL;
+	exportJob_=NULL;
+	alignmentQueue_=NULL;
+	alignmentCache_=NULL;
+	alignmentJobsDock_=NULL;
+	clusterSize_=DEFAULT_CLUSTER_SIZE;
+	exportLineWidth_=0;
 }
 			
 void SeqEditMainWin::createActions()
@@ -1147,16 +1686,31 @@ void SeqEditMainWin::createActions()
 	addAction(importAction);
 	connect(importAction, SIGNAL(triggered()), this, SLOT(fileImport()));
 	
+	importIndexedAction = new QAction( tr("Import from &indexed FASTA ..."), this);
+	importIndexedAction->setStatusTip(tr("Import selected records from a large FASTA file, using a .fai index"));
+	addAction(importIndexedAction);
+	connect(importIndexedAction, SIGNAL(triggered()), this, SLOT(fileImportIndexed()));
+	
+	viewMappedAction = new QAction( tr("&View large alignment ..."), this);
+	viewMappedAction->setStatusTip(tr("View a FASTA alignment read-only, without loading it into memory"));
+	addAction(viewMappedAction);
+	connect(viewMappedAction, SIGNAL(triggered()), this, SLOT(fileViewMapped()));
+	
 	exportFASTAAction = new QAction( tr("&Export as FASTA ..."), this);
-	exportFASTAAction->setStatusTip(tr("Export all project sequences in FASTA format"));
+	exportFASTAAction->setStatusTip(tr("Export all project sequences in FASTA format (compressed if the file name ends in .gz, .bgz or .zst)"));
 	addAction(exportFASTAAction);
 	connect(exportFASTAAction, SIGNAL(triggered()), this, SLOT(fileExportFASTA()));
 	
 	exportClustalWAction = new QAction( tr("&Export as ClustalW ..."), this);
-	exportClustalWAction->setStatusTip(tr("Export all project sequences in ClustalW format"));
+	exportClustalWAction->setStatusTip(tr("Export all project sequences in ClustalW format (compressed if the file name ends in .gz, .bgz or .zst)"));
 	addAction(exportClustalWAction);
 	connect(exportClustalWAction, SIGNAL(triggered()), this, SLOT(fileExportClustalW()));
 	
+	exportA3MAction = new QAction( tr("&Export as A3M ..."), this);
+	exportA3MAction->setStatusTip(tr("Export all project sequences in A3M format, or A2M for a .a2m file, using the first sequence as the master"));
+	addAction(exportA3MAction);
+	connect(exportA3MAction, SIGNAL(triggered()), this, SLOT(fileExportA3M()));
+	
 	printAction = new QAction( tr("&Print ..."), this);
 	printAction->setStatusTip(tr("Print current "));
 	addAction(printAction);
@@ -1303,13 +1857,58 @@ void SeqEditMainWin::createActions()
 	connect(alignSelectionAction, SIGNAL(triggered()), this, SLOT(alignmentSelection()));
 	alignSelectionAction->setEnabled(false);
 	
+	alignGroupsAction = new QAction( tr("Align &groups separately"), this);
+	alignGroupsAction->setStatusTip(tr("Run a separate alignment on each group"));
+	addAction(alignGroupsAction);
+	connect(alignGroupsAction, SIGNAL(triggered()), this, SLOT(alignmentGroups()));
+	alignGroupsAction->setEnabled(false);
+	
+	alignAddAction = new QAction( tr("A&dd selection to alignment"), this);
+	alignAddAction->setStatusTip(tr("Align the selected sequences to the existing alignment, keeping its columns"));
+	addAction(alignAddAction);
+	connect(alignAddAction, SIGNAL(triggered()), this, SLOT(alignmentAdd()));
+	alignAddAction->setEnabled(false);
+	
+	alignPairAction = new QAction( tr("Align &pair (built-in)"), this);
+	alignPairAction->setStatusTip(tr("Align the two selected sequences, without an external tool"));
+	addAction(alignPairAction);
+	connect(alignPairAction, SIGNAL(triggered()), this, SLOT(alignmentPair()));
+	alignPairAction->setEnabled(false);
+	
+	alignWindowAction = new QAction( tr("Realign selected &columns"), this);
+	alignWindowAction->setStatusTip(tr("Realign the selected block of columns, leaving the columns on either side untouched"));
+	addAction(alignWindowAction);
+	connect(alignWindowAction, SIGNAL(triggered()), this, SLOT(alignmentWindow()));
+	alignWindowAction->setEnabled(false);
+	
+	alignClustersAction = new QAction( tr("Align all in c&lusters ..."), this);
+	alignClustersAction->setStatusTip(tr("Align clusters of similar sequences separately, then merge the cluster alignments"));
+	addAction(alignClustersAction);
+	connect(alignClustersAction, SIGNAL(triggered()), this, SLOT(alignmentClusters()));
+	alignClustersAction->setEnabled(false);
+	
+	alignAutoAction = new QAction( tr("Align all, choosing the &tool"), this);
+	alignAutoAction->setStatusTip(tr("Align all with the tool predicted to be fastest, from the run history, within the alignment budget"));
+	addAction(alignAutoAction);
+	connect(alignAutoAction, SIGNAL(triggered()), this, SLOT(alignmentAuto()));
+	alignAutoAction->setEnabled(false);
+	
 	alignStopAction = new QAction( tr("Stop alignment"), this);
-	alignStopAction->setStatusTip(tr("Stop the running alignment"));
+	alignStopAction->setStatusTip(tr("Stop all queued and running alignments"));
 	addAction(alignStopAction);
 	connect(alignStopAction, SIGNAL(triggered()), this, SLOT(alignmentStop()));
 	alignStopAction->setEnabled(false);
 	alignStopAction->setIcon(QIcon(":/images/stop.png"));
 	
+	alignJobsAction = alignmentJobsDock_->toggleViewAction();
+	alignJobsAction->setText(tr("Show alignment &jobs"));
+	alignJobsAction->setStatusTip(tr("Show queued, running and finished alignments"));
+	
+	alignHistoryAction = new QAction( tr("Run &history ..."), this);
+	alignHistoryAction->setStatusTip(tr("Compare the time and memory used by the alignment tools on this project"));
+	addAction(alignHistoryAction);
+	connect(alignHistoryAction, SIGNAL(triggered()), this, SLOT(alignmentHistory()));
+	
 	// Settings actions
 	settingsEditorFontAction = new QAction( tr("Editor font"), this);
 	settingsEditorFontAction->setStatusTip(tr("Choose the font used in the sequence editor"));
@@ -1341,16 +1940,47 @@ void SeqEditMainWin::createActions()
 	settingsAlignmentToolMAFFTAction->setChecked(project_->alignmentTool()->name()=="MAFFT");
 	settingsAlignmentToolMAFFTAction->setEnabled(app->alignmentToolAvailable("MAFFT"));
 	
+	settingsAlignmentToolBuiltInAction = new QAction( tr("Built-in"), this);
+	settingsAlignmentToolBuiltInAction->setStatusTip(tr("Select the built-in progressive aligner"));
+	addAction(settingsAlignmentToolBuiltInAction);
+	connect(settingsAlignmentToolBuiltInAction, SIGNAL(triggered()), this, SLOT(settingsAlignmentToolBuiltIn()));
+	settingsAlignmentToolBuiltInAction->setCheckable(true);
+	settingsAlignmentToolBuiltInAction->setChecked(project_->alignmentTool()->name()=="built-in");
+	
 	QActionGroup *ag = new QActionGroup(this);
 	ag->setExclusive(true);
 	ag->addAction(settingsAlignmentToolClustalOAction);
 	ag->addAction(settingsAlignmentToolMUSCLEAction);
 	ag->addAction(settingsAlignmentToolMAFFTAction);
+	ag->addAction(settingsAlignmentToolBuiltInAction);
 	
 	settingsAlignmentToolPropertiesAction = new QAction( project_->alignmentTool()->name(), this);
 	settingsAlignmentToolPropertiesAction->setStatusTip(tr("Alignment tool properties"));
 	addAction(settingsAlignmentToolPropertiesAction);
 	connect(settingsAlignmentToolPropertiesAction, SIGNAL(triggered()), this, SLOT(settingsAlignmentToolProperties()));
+	settingsAlignmentToolPropertiesAction->setEnabled(!project_->alignmentTool()->inProcess());
+	
+	settingsAlignmentBudgetAction = new QAction( tr("Alignment budget ..."), this);
+	settingsAlignmentBudgetAction->setStatusTip(tr("Set the time and memory an alignment may use, and the minimum quality of tool"));
+	addAction(settingsAlignmentBudgetAction);
+	connect(settingsAlignmentBudgetAction, SIGNAL(triggered()), this, SLOT(settingsAlignmentBudget()));
+	
+	settingsExportLineWidthAction = new QAction( tr("Export line width ..."), this);
+	settingsExportLineWidthAction->setStatusTip(tr("Set the number of residues per line in exported FASTA and ClustalW files"));
+	addAction(settingsExportLineWidthAction);
+	connect(settingsExportLineWidthAction, SIGNAL(triggered()), this, SLOT(settingsExportLineWidth()));
+	
+	settingsMessageLogLinesAction = new QAction( tr("Message log size ..."), this);
+	settingsMessageLogLinesAction->setStatusTip(tr("Set the number of lines kept in the message window"));
+	addAction(settingsMessageLogLinesAction);
+	connect(settingsMessageLogLinesAction, SIGNAL(triggered()), this, SLOT(settingsMessageLogLines()));
+	
+	settingsMessageLogFileAction = new QAction( tr("Write messages to a log file"), this);
+	settingsMessageLogFileAction->setStatusTip(tr("Append all messages to messages.log in the application directory"));
+	addAction(settingsMessageLogFileAction);
+	settingsMessageLogFileAction->setCheckable(true);
+	settingsMessageLogFileAction->setChecked(!mw->log()->logFile().isEmpty());
+	connect(settingsMessageLogFileAction, SIGNAL(toggled(bool)), this, SLOT(settingsMessageLogFile(bool)));
 	
 	settingsSaveAppDefaultsAction = new QAction( tr("Save as application defaults"), this);
 	settingsSaveAppDefaultsAction->setStatusTip(tr("Save settings as application defaults"));
@@ -1453,9 +2083,12 @@ void SeqEditMainWin::createMenus()
 	fileMenu->addAction(saveProjectAsAction);
 	fileMenu->addSeparator();
 	fileMenu->addAction(importAction);
+	fileMenu->addAction(importIndexedAction);
+	fileMenu->addAction(viewMappedAction);
 	fileMenu->addSeparator();
 	fileMenu->addAction(exportFASTAAction);
 	fileMenu->addAction(exportClustalWAction);
+	fileMenu->addAction(exportA3MAction);
 	fileMenu->addSeparator();
 	fileMenu->addAction(printAction);
 	fileMenu->addSeparator();
@@ -1497,7 +2130,16 @@ void SeqEditMainWin::createMenus()
 	connect(alignmentMenu,SIGNAL(aboutToShow()),this,SLOT(setupAlignmentActions()));
 	alignmentMenu->addAction(alignAllAction);
 	alignmentMenu->addAction(alignSelectionAction);
+	alignmentMenu->addAction(alignGroupsAction);
+	alignmentMenu->addAction(alignAddAction);
+	alignmentMenu->addAction(alignPairAction);
+	alignmentMenu->addAction(alignWindowAction);
+	alignmentMenu->addAction(alignClustersAction);
+	alignmentMenu->addAction(alignAutoAction);
 	alignmentMenu->addAction(alignStopAction);
+	alignmentMenu->addSeparator();
+	alignmentMenu->addAction(alignJobsAction);
+	alignmentMenu->addAction(alignHistoryAction);
 	
 	//annotationMenu = menuBar()->addMenu(tr("Annotations"));
 	//connect(annotationMenu,SIGNAL(aboutToShow()),this,SLOT(setupAnnotationMenu()));
@@ -1545,8 +2187,15 @@ void SeqEditMainWin::createMenus()
 	alignmentToolMenu->addAction(settingsAlignmentToolClustalOAction);
 	alignmentToolMenu->addAction(settingsAlignmentToolMUSCLEAction);
 	alignmentToolMenu->addAction(settingsAlignmentToolMAFFTAction);
+	alignmentToolMenu->addAction(settingsAlignmentToolBuiltInAction);
 	
 	settingsMenu->addAction(settingsAlignmentToolPropertiesAction);
+	settingsMenu->addAction(settingsAlignmentBudgetAction);
+	settingsMenu->addAction(settingsExportLineWidthAction);
+	
+	settingsMenu->addSeparator();
+	settingsMenu->addAction(settingsMessageLogLinesAction);
+	settingsMenu->addAction(settingsMessageLogFileAction);
 	
 	settingsMenu->addSeparator();
 	settingsMenu->addAction(settingsSaveAppDefaultsAction);
@@ -1608,63 +2257,215 @@ void SeqEditMainWin::createToolBars()
 	
 }
 
+// This will only run the first time sequences are imported
+bool SeqEditMainWin::selectSequenceDataType(bool &firstRun)
+{
+	firstRun=false;
+	if (project_->sequenceDataType() != SequenceFile::Unknown)
+		return true;
+	
+	firstRun=true;
+	ImportDialog idlg(SequenceFile::Proteins,this);
+	if (QDialog::Accepted == idlg.exec()){
+		int ret = idlg.dataType();
+		qDebug() << trace.header(__PRETTY_FUNCTION__) << ret;
+		project_->setSequenceDataType(ret);
+		se->setSequenceDataType(ret);
+		return true;
+	}
+	statusBar()->showMessage("The import was canceled");
+	return false;
+}
+
+void SeqEditMainWin::resetSequenceDataType()
+{
+	project_->setSequenceDataType(SequenceFile::Unknown); 
+	se->setSequenceDataType(SequenceFile::Unknown);
+}
+
+// Called when the project has been replaced by a read-only mapped alignment
+void SeqEditMainWin::setMappedView(const QString &fname)
+{
+	setWindowTitle("tweakseq - " + fname + " (read only)");
+	
+	readOnlyAction->setChecked(true);
+	readOnlyAction->setEnabled(false);
+	se->setReadOnly(true);
+	
+	saveProjectAction->setEnabled(false);
+	saveProjectAsAction->setEnabled(false);
+	importAction->setEnabled(false);
+	importIndexedAction->setEnabled(false);
+	exportFASTAAction->setEnabled(false);
+	exportClustalWAction->setEnabled(false);
+	exportA3MAction->setEnabled(false);
+	
+	bool firstRun;
+	selectSequenceDataType(firstRun); // for the colour map
+	
+	setupEditActions();
+	setupAlignmentActions();
+	statusBar()->showMessage(QString::number(project_->sequences.numVisible()) + " sequences, " +
+		QString::number(project_->sequences.maxLength()) + " columns");
+}
+
 void SeqEditMainWin::createStatusBar()
 {
+	exportProgress_ = new QProgressBar(this);
+	exportProgress_->setMaximumWidth(200);
+	exportProgress_->setTextVisible(true);
+	exportProgress_->hide();
+	statusBar()->addPermanentWidget(exportProgress_);
+	
+	exportCancel_ = new QToolButton(this);
+	exportCancel_->setText(tr("Cancel"));
+	exportCancel_->setToolTip(tr("Cancel the export"));
+	exportCancel_->hide();
+	statusBar()->addPermanentWidget(exportCancel_);
+	connect(exportCancel_,SIGNAL(clicked()),this,SLOT(exportCancel()));
+	
+	alignmentEta_ = new QLabel(this);
+	alignmentEta_->hide();
+	statusBar()->addPermanentWidget(alignmentEta_);
+	
+	alignmentProgress_ = new QProgressBar(this);
+	alignmentProgress_->setMaximumWidth(200);
+	alignmentProgress_->setRange(0,1000);
+	alignmentProgress_->setTextVisible(true);
+	alignmentProgress_->hide();
+	statusBar()->addPermanentWidget(alignmentProgress_);
+}
+
+// Exports run in the background, one at a time
+void SeqEditMainWin::startExport(const QString &fname,int format)
+{
+	if (exportJob_ != NULL) return;
+	
+	exportJob_ = project_->startExport(fname,format,true,exportLineWidth_); // FIXME hardcoded
+	connect(exportJob_,SIGNAL(progress(int,int)),this,SLOT(exportProgress(int,int)));
+	connect(exportJob_,SIGNAL(finished(bool)),this,SLOT(exportFinished(bool)));
 	
+	exportProgress_->setRange(0,0);
+	exportProgress_->show();
+	exportCancel_->show();
+	statusBar()->showMessage(tr("Exporting ") + fname);
+	
+	exportFASTAAction->setEnabled(false);
+	exportClustalWAction->setEnabled(false);
+	exportA3MAction->setEnabled(false);
 }
 
 void SeqEditMainWin::startAlignment()
 {
-	if (NULL != alignmentProc_){
-		qDebug() << trace.header(__PRETTY_FUNCTION__) << "state=" << alignmentProc_->state();
-		if (alignmentProc_->state() != QProcess::NotRunning)
-			alignmentProc_->close();
-		delete alignmentProc_;
-		alignmentProc_=NULL;
+	QList<Sequence *> &seqs = alignAll ? project_->sequences.sequences() : project_->sequenceSelection->sequences();
+	queueAlignment(alignAll ? "all" : "selection",seqs,alignAll);
+}
+
+// Takes a snapshot of the input, which is streamed to the aligner's stdin when the job runs,
+// so the sequences can be edited while the job waits in the queue.
+// If the same input has already been aligned with the same command, the cached result is used instead.
+void SeqEditMainWin::queueAlignment(const QString &name,const QList<Sequence *> &seqs,bool isFullAlignment)
+{
+	QStringList labels,residues;
+	for (int s=0;s<seqs.size();s++){
+		labels.append(seqs.at(s)->label);
+		residues.append(seqs.at(s)->filter(true));
+	}
+	queueAlignment(name,labels,residues,isFullAlignment,ColumnWindow(),NULL,false);
+}
+
+// A tool, if one is given, runs instead of the current tool. If it is owned, eg a cluster aligner,
+// it is handed to the job
+void SeqEditMainWin::queueAlignment(const QString &name,const QStringList &labels,const QStringList &residues,
+	bool isFullAlignment,const ColumnWindow &window,AlignmentTool *tool,bool owned)
+{
+	if (tool == NULL){
+		tool = project_->alignmentTool();
+		owned=false;
 	}
-	
-	alignmentProc_ = new QProcess(this);
-	connect(alignmentProc_,SIGNAL(started()),this,SLOT(alignmentStarted()));
-	connect(alignmentProc_,SIGNAL(readyReadStandardOutput()),this,SLOT(alignmentReadyReadStdOut()));
-	connect(alignmentProc_,SIGNAL(readyReadStandardError()),this,SLOT(alignmentReadyReadStdErr()));
-	connect(alignmentProc_,SIGNAL(finished(int,QProcess::ExitStatus)),this,SLOT(alignmentFinished(int,QProcess::ExitStatus)));
 	
 	QString exec;
 	QStringList args;
-	
-	QFileInfo fiin(app->applicationTmpPath(),"tweakseq.in.XXXXXX.fa");
-	alignmentFileIn_ = new QTemporaryFile(fiin.absoluteFilePath());
-	alignmentFileIn_->open();
-	alignmentFileIn_->close();
-	
-	QFileInfo fiout(app->applicationTmpPath(),"tweakseq.out.XXXXXX.fa");
-	alignmentFileOut_ = new QTemporaryFile(fiout.absoluteFilePath());
-	alignmentFileOut_->open();
-	alignmentFileOut_->close();
-	
-	QString fin  = alignmentFileIn_->fileName();
-	QString fout = alignmentFileOut_->fileName();
-	if (alignAll){
-		project_->exportFASTA(fin,true);
-	}
-	else{
-		project_->exportSelectionFASTA(fin,true);
+	tool->makePipeCommand(exec,args);
+	qDebug() <<  trace.header(__PRETTY_FUNCTION__) << name << " " << exec << args;
+	
+	QString key = AlignmentCache::key(tool,exec,args,labels,residues);
+	QStringList newLabels,newSeqs;
+	if (alignmentCache_->lookup(key,newLabels,newSeqs)){
+		if (owned) delete tool;
+		statusBar()->showMessage("Alignment taken from the cache: " + name);
+		applyAlignment(name,newLabels,newSeqs,isFullAlignment,QStringList(),window);
+		return;
 	}
 	
-	project_->alignmentTool()->makeCommand(fin,fout,exec,args);
-	if (project_->alignmentTool()->usesStdOut()){
-		alignmentProc_->setStandardOutputFile(fout);
-		qDebug() <<  trace.header(__PRETTY_FUNCTION__) << "stdout redirected";
+	if (!withinBudget(tool,residues)){
+		if (owned) delete tool;
+		return;
 	}
-	qDebug() <<  trace.header(__PRETTY_FUNCTION__) << exec << args;
-	alignmentProc_->start(exec,args);
-	alignAllAction->setEnabled(false);
-	alignStopAction->setEnabled(true);
+	
+	AlignmentJob *job = new AlignmentJob(name,isFullAlignment);
+	for (int s=0;s<labels.size();s++)
+		job->addSequence(labels.at(s),residues.at(s));
+	job->setCommand(exec,args);
+	job->setLimits(tool->memoryLimit(),tool->niceLevel());
+	job->setThreads(tool->threads(),tool->threaded() || tool->inProcess());
+	job->setProgressParser(tool->createProgressParser());
+	job->setToolInfo(tool->name(),tool->version());
+	if (tool->inProcess())
+		job->setInProcess(tool,owned);
+	job->setCacheKey(key);
+	job->setWindow(window);
+	
+	connect(job,SIGNAL(message(const QString &,bool)),this,SLOT(alignmentMessage(const QString &,bool)));
+	alignmentQueue_->add(job);
+	alignStopAction->setEnabled(alignmentQueue_->numActive() > 0);
 }
 
-void SeqEditMainWin::readNewAlignment(bool isFullAlignment)
+// Asks before starting a run that the run history predicts will exceed the time or memory budget
+bool SeqEditMainWin::withinBudget(AlignmentTool *tool,const QStringList &residues)
 {
-	project_->readNewAlignment(alignmentFileOut_->fileName(),isFullAlignment);
+	if ((budget_.seconds == 0 && budget_.mb == 0) || residues.size() < 2) return true;
+	
+	qint64 nResidues=0;
+	for (int s=0;s<residues.size();s++)
+		nResidues += residues.at(s).length();
+	CostModel model;
+	model.fit(project_->runHistory);
+	double seconds,mb;
+	if (!model.predict(tool->name(),residues.size(),(double) nResidues/residues.size(),seconds,mb))
+		return true; // nothing to go on
+	
+	bool overTime = (budget_.seconds > 0 && seconds > budget_.seconds);
+	bool overMemory = (budget_.mb > 0 && mb > budget_.mb);
+	if (!overTime && !overMemory) return true;
+	
+	QString msg = tool->name() + " is predicted to take " + CostModel::formatCost(seconds,mb) + ", which exceeds the " +
+		(overTime ? (overMemory ? "time and memory budgets" : "time budget") : "memory budget") + 
+		".\nStart the alignment anyway?";
+	return QMessageBox::question(this,tr("Alignment budget"),msg,QMessageBox::Yes | QMessageBox::No,QMessageBox::No) == QMessageBox::Yes;
+}
+
+// Applies an aligner's output. If sequences were added to an existing alignment, or a block of columns
+// was realigned, the result is spliced into the alignment
+void SeqEditMainWin::applyAlignment(const QString &name,const QStringList &labels,const QStringList &seqs,
+	bool isFullAlignment,const QStringList &addedLabels,const ColumnWindow &window)
+{
+	if (window.isValid()){
+		QString errmsg;
+		if (!project_->readRealignedWindow(window,labels,seqs,errmsg)){
+			mw->addMessage(name + ": " + errmsg,MessageWin::Error);
+			return;
+		}
+	}
+	else if (addedLabels.isEmpty())
+		project_->readNewAlignment(labels,seqs,isFullAlignment);
+	else{
+		QString errmsg;
+		if (!project_->readAddedSequences(labels,seqs,addedLabels,errmsg)){
+			mw->addMessage(name + ": " + errmsg,MessageWin::Error);
+			return;
+		}
+	}
 	se->updateViewport();
 }
 
@@ -1728,6 +2529,10 @@ void SeqEditMainWin::updateSettingsActions()
 {
 	// Called after loading a Project
 	settingsAlignmentToolPropertiesAction->setText(project_->alignmentTool()->name());
+	settingsAlignmentToolPropertiesAction->setEnabled(!project_->alignmentTool()->inProcess());
+	settingsMessageLogFileAction->blockSignals(true); // it's already open
+	settingsMessageLogFileAction->setChecked(!mw->log()->logFile().isEmpty());
+	settingsMessageLogFileAction->blockSignals(false);
 	
 	int view = se->residueView();
 	for (int a=0;a<settingsViewActions.size();a++)
@@ -28,23 +28,34 @@
 #define __SEQEDIT_MAINWIN_H_
 
 #include <QMainWindow>
-#include <QProcess>
+
+#include "CostModel.h"
 
 class QComboBox;
+class QDockWidget;
 class QDomDocument;
 class QDomElement;
+class QLabel;
 class QPrinter;
+class QProgressBar;
 class QPushButton;
 class QScrollBar;
 class QSplitter;
-class QTemporaryFile;
 class QToolBar;
+class QToolButton;
 
+class AlignmentCache;
+class AlignmentJob;
+class AlignmentQueue;
+class AlignmentTool;
+class ColumnWindow;
+class ExportJob;
 class GoToTool;
 class MessageWin;
 class Project;
 class SearchTool;
 class SequenceEditor;
+class Sequence;
 class SequenceGroup;
 
 class SeqEditMainWin: public QMainWindow
@@ -61,6 +72,7 @@ public:
 	SequenceEditor *se;
 	
 	void postLoadTidy();
+	void setMappedView(const QString &);
 	void writeSettings(QDomDocument &,QDomElement &);
 	void readSettings(QDomDocument &);
 	
@@ -82,10 +94,17 @@ private slots:
 	void fileSaveProject();
 	void fileSaveProjectAs(); 
 	void fileImport();
+	void fileImportIndexed();
+	void fileViewMapped();
 	void fileExportFASTA();
 	void fileExportClustalW();
+	void fileExportA3M();
 	void fileClose();
 	
+	void exportProgress(int,int);
+	void exportFinished(bool);
+	void exportCancel();
+	
 	void setupEditActions();
 	
 	void editCopy();
@@ -98,12 +117,19 @@ private slots:
 	void setupAlignmentActions();
 	void alignmentAll();
 	void alignmentSelection();
+	void alignmentGroups();
+	void alignmentAdd();
+	void alignmentPair();
+	void alignmentWindow();
+	void alignmentClusters();
+	void alignmentAuto();
+	void alignmentHistory();
 	void alignmentStop();
 	
-	void alignmentStarted();
-	void alignmentReadyReadStdOut();
-	void alignmentReadyReadStdErr();
-	void alignmentFinished(int,QProcess::ExitStatus);
+	void alignmentJobChanged(AlignmentJob *);
+	void alignmentJobProgress(AlignmentJob *);
+	void alignmentJobFinished(AlignmentJob *);
+	void alignmentMessage(const QString &,bool);
 	
 	void setupAnnotationMenu();
 	void annotationConsensus();
@@ -115,7 +141,12 @@ private slots:
 	void settingsAlignmentToolClustalO();
 	void settingsAlignmentToolMUSCLE();
 	void settingsAlignmentToolMAFFT();
+	void settingsAlignmentToolBuiltIn();
 	void settingsAlignmentToolProperties();
+	void settingsAlignmentBudget();
+	void settingsExportLineWidth();
+	void settingsMessageLogLines();
+	void settingsMessageLogFile(bool);
 	void settingsSaveAppDefaults();
 	
 	void helpHelp();
@@ -139,8 +170,16 @@ private:
 	void createToolBars();
 	void createStatusBar();
 	
+	bool selectSequenceDataType(bool &);
+	void resetSequenceDataType();
+	
+	void startExport(const QString &,int);
+	
 	void startAlignment();
-	void readNewAlignment(bool);
+	void queueAlignment(const QString &,const QList<Sequence *> &,bool);
+	void queueAlignment(const QString &,const QStringList &,const QStringList &,bool,const ColumnWindow &,AlignmentTool *,bool);
+	bool withinBudget(AlignmentTool *,const QStringList &);
+	void applyAlignment(const QString &,const QStringList &,const QStringList &,bool,const QStringList &,const ColumnWindow &);
 	
 	void printRes( QPainter*,QChar,int,int );
 	
@@ -155,8 +194,8 @@ private:
 	QMenu    *fileMenu,*alignmentMenu,*editMenu,*annotationMenu,*settingsMenu,*helpMenu;
 	QMenu    *colourMapMenu;
 	QAction  *newProjectAction,*openProjectAction,*saveProjectAction,*saveProjectAsAction;
-	QAction  *importAction, *exportFASTAAction,*exportClustalWAction,*printAction, *closeAction, *quitAction;
-	QAction  *alignAllAction,*alignSelectionAction,*alignStopAction,*undoLastAction;
+	QAction  *importAction,*importIndexedAction,*viewMappedAction, *exportFASTAAction,*exportClustalWAction,*exportA3MAction,*printAction, *closeAction, *quitAction;
+	QAction  *alignAllAction,*alignSelectionAction,*alignGroupsAction,*alignAddAction,*alignPairAction,*alignWindowAction,*alignClustersAction,*alignAutoAction,*alignStopAction,*alignJobsAction,*alignHistoryAction,*undoLastAction;
 	QAction  *undoAction,*redoAction,*cutAction,*copyAction,*pasteAction;
 	QAction  *excludeAction,*removeExcludeAction,*lockAction,*unlockAction;
 	QAction  *hideNonSelectedGroupMembersAction,*unhideAllGroupMembersAction,*unhideAllAction;
@@ -168,11 +207,14 @@ private:
 	QAction  *helpAction,*aboutAction;
 	QAction  *settingsEditorFontAction;
 	QAction  *settingsAlignmentToolMAFFTAction,*settingsAlignmentToolMUSCLEAction,*settingsAlignmentToolClustalOAction;
+	QAction  *settingsAlignmentToolBuiltInAction;
 	QList<QAction *> settingsViewActions;
 	QList<QAction *> settingsProteinColourMapActions;
 	QList<QAction *> settingsDNAColourMapActions;
-	QAction  *settingsAlignmentToolPropertiesAction;
+	QAction  *settingsAlignmentToolPropertiesAction,*settingsAlignmentBudgetAction;
+	QAction  *settingsExportLineWidthAction;
 
+	QAction *settingsMessageLogLinesAction,*settingsMessageLogFileAction;
 	QAction *settingsSaveAppDefaultsAction;
 	
 	QAction *createBookmarkAction,*removeBookmarkAction,*nextBookmarkAction,*prevBookmarkAction;
@@ -189,12 +231,23 @@ private:
 	
 	QPrinter *printer;	
 	
-	QProcess *alignmentProc_;
-	QTemporaryFile *alignmentFileIn_,*alignmentFileOut_;
+	AlignmentQueue *alignmentQueue_;
+	AlignmentCache *alignmentCache_;
+	QDockWidget *alignmentJobsDock_;
 	bool alignAll;
+	int clusterSize_;
+	AlignmentBudget budget_;
+	int exportLineWidth_; // 0 for the format's default
 	
 	QString lastImportedFile;
 	
+	ExportJob *exportJob_;
+	QProgressBar *exportProgress_;
+	QToolButton *exportCancel_;
+	
+	QProgressBar *alignmentProgress_;
+	QLabel *alignmentEta_;
+	
 	Project *project_;
 	
 	// Temporary stuff
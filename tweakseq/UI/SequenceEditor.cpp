@@ -1614,12 +1614,10 @@ QChar SequenceEditor::cellContent(int row, int col, int maskFlags, Sequence *cur
 	QChar pChar;
 	QString s;
 	
-	QList<Sequence *> &seq = project_->sequences.sequences();
-	
 	if (NULL == currSeq)	
 		currSeq = project_->sequences.visibleAt(row);
 	
-	if (!seq.isEmpty()){
+	if (NULL != currSeq){ // rows of a mapped alignment are not in sequences()
 		s=currSeq->residues;
 		pChar= s[col];
 		if (pChar.unicode() != 0){
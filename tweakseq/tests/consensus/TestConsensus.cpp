@@ -0,0 +1,212 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Checks Consensus::calculate(), which works from per-column symbol counts, against the original
+// calculation, which scores every residue against every other residue in the column
+
+#include <QtTest>
+
+#include "Consensus.h"
+#include "DebuggingInfo.h"
+#include "ScoringMatrix.h"
+#include "Sequence.h"
+#include "Sequences.h"
+
+DebuggingInfo trace("TRACE");
+DebuggingInfo warning("WARNING");
+DebuggingInfo fixme("FIXME");
+DebuggingInfo benchmark("BENCHMARK");
+
+#define NUM_RANDOM 200 // alignments per seed
+
+class TestConsensus:public QObject
+{
+	Q_OBJECT
+	
+	private slots:
+		
+		void ties_data();
+		void ties();
+		void random_data();
+		void random();
+		
+	private:
+		
+		static QString pairwise(Sequences &,double);
+		static QString byCounts(Sequences &,double);
+		static void makeSequences(Sequences &,const QStringList &);
+};
+
+//
+//	Private slots
+//	
+
+void TestConsensus::ties_data()
+{
+	QTest::addColumn<QStringList>("rows");
+	QTest::addColumn<double>("plurality");
+	QTest::addColumn<QString>("expected");
+	
+	// A and S score +1 against each other, so whichever comes first wins
+	QTest::newRow("A before S") << (QStringList() << "A" << "S") << 1.0 << "A";
+	QTest::newRow("S before A") << (QStringList() << "S" << "A") << 1.0 << "S";
+	// A gap and a residue both score -4, and have no matches
+	QTest::newRow("gap before residue") << (QStringList() << "-" << "W") << 0.0 << "-";
+	QTest::newRow("residue before gap") << (QStringList() << "W" << "-") << 0.0 << "W";
+	QTest::newRow("no plurality") << (QStringList() << "W" << "-") << 1.0 << "?";
+	// Lower case and '.' are the gap symbol, and the first row's character is used
+	QTest::newRow("gap characters") << (QStringList() << "a" << "." << "-") << 0.0 << "a";
+	// Two pairs of identical residues, which tie with each other
+	QTest::newRow("two pairs") << (QStringList() << "A" << "S" << "S" << "A") << 2.0 << "A";
+	QTest::newRow("two pairs, reversed") << (QStringList() << "S" << "A" << "A" << "S") << 2.0 << "S";
+	// Columns are independent
+	QTest::newRow("columns") << (QStringList() << "AS-W" << "SA-W" << "WWWW") << 0.0 << "AS-W";
+}
+
+void TestConsensus::ties()
+{
+	QFETCH(QStringList,rows);
+	QFETCH(double,plurality);
+	QFETCH(QString,expected);
+	
+	Sequences seqs;
+	makeSequences(seqs,rows);
+	QCOMPARE(pairwise(seqs,plurality),expected);
+	QCOMPARE(byCounts(seqs,plurality),expected);
+	qDeleteAll(seqs.sequences());
+}
+
+void TestConsensus::random_data()
+{
+	QTest::addColumn<uint>("seed");
+	
+	QTest::newRow("seed 1") << 1u;
+	QTest::newRow("seed 2") << 2u;
+	QTest::newRow("seed 3") << 3u;
+	QTest::newRow("seed 4") << 4u;
+	QTest::newRow("seed 5") << 5u;
+}
+
+void TestConsensus::random()
+{
+	QFETCH(uint,seed);
+	
+	const char *symbols = "ACDEFGHIKLMNPQRSTVWYBZX-.acx"; // lower case and the rest are scored as gaps
+	int nSymbols = qstrlen(symbols);
+	qsrand(seed);
+	for (int t=0;t<NUM_RANDOM;t++){
+		int nseqs = 1 + qrand() % 200;
+		int length = 1 + qrand() % 500;
+		int nUsed = 2 + qrand() % (nSymbols - 1); // fewer symbols give more ties
+		QStringList rows;
+		for (int s=0;s<nseqs;s++){
+			QString res(length,QChar('-'));
+			for (int c=0;c<length;c++)
+				res[c]=QChar(symbols[qrand() % nUsed]);
+			rows.append(res);
+		}
+		double plurality = (t % 2) ? qrand() % (nseqs + 1) : nseqs/2.0;
+		
+		Sequences seqs;
+		makeSequences(seqs,rows);
+		QCOMPARE(byCounts(seqs,plurality),pairwise(seqs,plurality));
+		qDeleteAll(seqs.sequences());
+	}
+}
+
+//
+//	Private members
+//	
+
+// The original calculation: O(L.N^2)
+QString TestConsensus::pairwise(Sequences &seqs,double plurality)
+{
+	QList<Sequence *> &ss = seqs.sequences();
+	int slen = ss.at(0)->residues.length();
+	int nseq = ss.size();
+	QString consensus(slen,QChar('?'));
+	
+	// Convert the residues to indices into the scoring matrix
+	QVector<QVector<int> > rindex(nseq,QVector<int>(slen));
+	for (int s=0;s<nseq;s++){
+		for (int c=0;c<slen;c++){
+			int idx = (ss.at(s)->residues[c].unicode() & 0xff) - 'A';
+			rindex[s][c] = (idx < 0 || idx > 25) ? 99 : ScoringMatrix::BLOSUM62map[idx];
+		}
+	}
+	
+	for (int c=0;c<slen;c++){ // for each column in the alignment
+		double hiScore=0.0;
+		int riHiScore=0;
+		double riMatches=0;
+		for (int ri=0;ri<nseq;ri++){ // for each residue in the column
+			double score=0.0,matches=0.0;
+			for (int rj=0;rj<nseq;rj++){
+				if (ri==rj) continue;
+				int resi=rindex[ri][c];
+				int resj=rindex[rj][c];
+				if (resi == 99 && resj == 99){
+					score += 1.0;
+					matches += 1.0;
+				}
+				else if (resi == 99 || resj == 99)
+					score += -4.0;
+				else{
+					double tmp = ScoringMatrix::BLOSUM62[resi][resj];
+					score += tmp;
+					if (tmp > 0)
+						matches += 1.0;
+				}
+			}
+			if (ri == 0 || score > hiScore){
+				hiScore=score;
+				riHiScore=ri;
+				riMatches=matches;
+			}
+		}
+		if (riMatches >= plurality)
+			consensus[c]=QChar(ss.at(riHiScore)->residues[c].unicode() & 0xff);
+	}
+	return consensus;
+}
+
+QString TestConsensus::byCounts(Sequences &seqs,double plurality)
+{
+	Consensus consensus;
+	consensus.setSequences(&seqs);
+	consensus.setPlurality(plurality);
+	consensus.calculate();
+	return consensus.sequence();
+}
+
+void TestConsensus::makeSequences(Sequences &seqs,const QStringList &rows)
+{
+	for (int s=0;s<rows.size();s++)
+		seqs.append("seq" + QString::number(s),rows.at(s),"","",true);
+}
+
+QTEST_GUILESS_MAIN(TestConsensus)
+#include "TestConsensus.moc"
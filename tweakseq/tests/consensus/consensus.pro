@@ -0,0 +1,28 @@
+# Checks the consensus calculation against the original, pairwise one.
+# Run makeinclude.py in the top directory first, then qmake && make && ./consensus
+
+TARGET = consensus
+
+CONFIG += testcase
+
+MOC_DIR = moc
+
+OBJECTS_DIR = obj
+
+INCLUDEPATH += ../../include
+
+DEPENDPATH=$$INCLUDEPATH
+
+HEADERS       =  ../../include/Sequences.h
+
+SOURCES				 =  TestConsensus.cpp \
+									../../Core/Annotations/Consensus.cpp \
+									../../Core/FASTAIndex.cpp \
+									../../Core/MappedAlignment.cpp \
+									../../Core/ScoringMatrix.cpp \
+									../../Core/Sequence.cpp \
+									../../Core/Sequences.cpp \
+									../../Core/SequenceGroup.cpp \
+									../../Core/Structure.cpp
+
+QT           += core gui testlib
@@ -0,0 +1,142 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Times the FASTA, ClustalW and A3M writers on a fixed synthetic alignment, uncompressed and
+// with each compression format, and reports the throughput in MB of residues per second.
+// zstd is skipped if this build doesn't have it.
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include "A3MFile.h"
+#include "ClustalFile.h"
+#include "CompressedDevice.h"
+#include "DebuggingInfo.h"
+#include "FASTAFile.h"
+
+DebuggingInfo trace("TRACE");
+DebuggingInfo warning("WARNING");
+DebuggingInfo fixme("FIXME");
+DebuggingInfo benchmark("BENCHMARK");
+
+#define PROTEIN_RESIDUES "ACDEFGHIKLMNPQRSTVWY"
+#define NUM_SEQUENCES 2000
+#define ALIGNMENT_WIDTH 2000
+#define GAP_FRACTION 10 // one column in this many is a gap
+#define NUM_REPEATS 3 // the best time is reported
+
+static QTextStream out(stdout);
+
+// A fixed LCG, so that every run and every machine writes the same alignment
+static void makeAlignment(QStringList &labels,QStringList &seqs,QStringList &comments)
+{
+	QString residues(PROTEIN_RESIDUES);
+	unsigned int seed=1;
+	for (int s=0;s<NUM_SEQUENCES;s++){
+		QString seq;
+		seq.reserve(ALIGNMENT_WIDTH);
+		for (int c=0;c<ALIGNMENT_WIDTH;c++){
+			seed = seed*1103515245 + 12345;
+			unsigned int r = seed >> 16;
+			seq.append(r % GAP_FRACTION == 0 ? QChar('-') : residues.at((r/GAP_FRACTION) % residues.size()));
+		}
+		labels.append("seq" + QString::number(s+1));
+		seqs.append(seq);
+		comments.append(">seq" + QString::number(s+1) + " synthetic");
+	}
+}
+
+static SequenceFile *makeWriter(const QString &format,const QString &fname)
+{
+	if (format == "fasta") return new FASTAFile(fname);
+	if (format == "clustal") return new ClustalFile(fname);
+	return new A3MFile(fname);
+}
+
+int main(int argc,char **argv)
+{
+	QCoreApplication app(argc,argv);
+	QLoggingCategory::setFilterRules("default.info=false"); // the writers log their own timings
+	
+	QTemporaryDir dir;
+	if (!dir.isValid()){
+		out << "Couldn't create a temporary directory" << endl;
+		return 1;
+	}
+	
+	QStringList labels,seqs,comments;
+	makeAlignment(labels,seqs,comments);
+	double mb = (double) NUM_SEQUENCES*ALIGNMENT_WIDTH/1048576.0;
+	
+	QStringList formats,extensions;
+	formats << "fasta" << "clustal" << "a3m";
+	extensions << ".fa" << ".aln" << ".a3m";
+	QStringList compressions;
+	compressions << "" << ".gz" << ".bgz" << ".zst";
+	
+	out << NUM_SEQUENCES << " sequences x " << ALIGNMENT_WIDTH << " columns" << endl;
+	out << "format\tcompression\tMB/s\tfile size (MB)" << endl;
+	
+	bool ok=true;
+	for (int f=0;f<formats.size();f++){
+		for (int c=0;c<compressions.size();c++){
+			QString fname = dir.path() + "/bench" + extensions.at(f) + compressions.at(c);
+			QString compression = compressions.at(c).isEmpty() ? QString("none") : compressions.at(c).mid(1);
+			QString errmsg;
+			if (!CompressedDevice::available(CompressedDevice::formatForFile(fname),errmsg)){
+				out << formats.at(f) << "\t" << compression << "\t" << errmsg << endl;
+				continue;
+			}
+			
+			qint64 best=0;
+			bool written=true;
+			for (int r=0;r<NUM_REPEATS && written;r++){
+				SequenceFile *sf = makeWriter(formats.at(f),fname);
+				QElapsedTimer timer;
+				timer.start();
+				written = sf->write(labels,seqs,comments);
+				qint64 ns = timer.nsecsElapsed();
+				if (!written)
+					out << formats.at(f) << "\t" << compression << "\t" << sf->error() << endl;
+				delete sf;
+				if (r==0 || ns < best) best = ns;
+			}
+			if (!written){
+				ok=false;
+				continue;
+			}
+			
+			out << formats.at(f) << "\t" << compression << "\t" << (best > 0 ? mb*1.0E9/best : 0.0) << "\t" 
+				<< QFileInfo(fname).size()/1048576.0 << endl;
+		}
+	}
+	
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,38 @@
+# Reports the throughput of the FASTA, ClustalW and A3M writers, uncompressed and with each compression format,
+# on a fixed synthetic alignment.
+# Run makeinclude.py in the top directory first, then qmake && make && ./export_bench
+# It's not a testcase, so make check doesn't run it.
+
+TARGET = export_bench
+
+CONFIG += console
+
+MOC_DIR = moc
+
+OBJECTS_DIR = obj
+
+INCLUDEPATH += ../../include
+
+DEPENDPATH=$$INCLUDEPATH
+
+HEADERS       =  ../../include/CompressedDevice.h
+
+SOURCES				 =  BenchExport.cpp \
+									../../Core/A3MFile.cpp \
+									../../Core/BufferedWriter.cpp \
+									../../Core/ClustalFile.cpp \
+									../../Core/CompressedDevice.cpp \
+									../../Core/FASTAFile.cpp \
+									../../Core/SequenceFile.cpp
+
+QT           += core concurrent
+QT           -= gui
+
+LIBS += -lz
+
+# zstd output (.zst) is optional
+CONFIG += link_pkgconfig
+packagesExist(libzstd){
+	PKGCONFIG += libzstd
+	DEFINES += HAVE_ZSTD
+}
@@ -0,0 +1,131 @@
+//
+// tweakseq - provides an editor for and interface to various sequence alignment tools
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2000-2018 Michael J. Wouters, Merridee A. Wouters
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Times PairwiseAligner's scalar, SSE2 and AVX2 fills on fixed sequences and reports GCUPS
+// (billions of matrix cells per second). Levels that the CPU doesn't support are skipped.
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QTextStream>
+
+#include "DebuggingInfo.h"
+#include "PairwiseAligner.h"
+
+DebuggingInfo trace("TRACE");
+DebuggingInfo warning("WARNING");
+DebuggingInfo fixme("FIXME");
+DebuggingInfo benchmark("BENCHMARK");
+
+#define PROTEIN_RESIDUES "ACDEFGHIKLMNPQRSTVWY"
+#define NUM_REPEATS 3 // the best time is reported
+
+static QTextStream out(stdout);
+
+// A fixed LCG, so that every run and every machine aligns the same sequences
+static QString makeSequence(int len,unsigned int seed)
+{
+	QString residues(PROTEIN_RESIDUES);
+	QString seq;
+	seq.reserve(len);
+	for (int i=0;i<len;i++){
+		seed = seed*1103515245 + 12345;
+		seq.append(residues.at((seed >> 16) % residues.size()));
+	}
+	return seq;
+}
+
+static double gcups(qint64 cells,qint64 ns)
+{
+	return ns > 0 ? (double) cells/ns : 0.0;
+}
+
+int main(int argc,char **argv)
+{
+	QCoreApplication app(argc,argv);
+	QLoggingCategory::setFilterRules("default.info=false"); // PairwiseAligner logs its own timings
+	
+	int lengths[] = {500,2000,5000};
+	int levels[] = {0,8,16};
+	
+	out << "length\tSIMD\tscore GCUPS\talign GCUPS" << endl;
+	
+	bool ok=true;
+	for (unsigned int l=0;l<sizeof(lengths)/sizeof(int);l++){
+		QString a = makeSequence(lengths[l],2*l+1);
+		QString b = makeSequence(lengths[l] + lengths[l]/20,2*l+2); // a little longer, so there are end gaps
+		qint64 cells = (qint64) a.size()*b.size();
+		
+		int refScore=0;
+		QString refA,refB;
+		for (unsigned int v=0;v<sizeof(levels)/sizeof(int);v++){
+			PairwiseAligner::limitSimd(levels[v]);
+			QString name = PairwiseAligner::simdName();
+			if (levels[v] == 8 && name != "SSE2") continue;
+			if (levels[v] == 16 && name != "AVX2") continue;
+			
+			PairwiseAligner pw;
+			pw.setMode(PairwiseAligner::Global);
+			
+			QElapsedTimer timer;
+			qint64 scoreNs=0,alignNs=0;
+			int s=0;
+			QString alignedA,alignedB,errmsg;
+			bool aligned=true;
+			for (int r=0;r<NUM_REPEATS && aligned;r++){
+				timer.start();
+				s = pw.score(a,b);
+				qint64 ns = timer.nsecsElapsed();
+				if (r==0 || ns < scoreNs) scoreNs = ns;
+				
+				timer.start();
+				if (!pw.align(a,b,alignedA,alignedB,errmsg)){
+					out << lengths[l] << "\t" << name << "\t" << errmsg << endl;
+					ok=aligned=false;
+					break;
+				}
+				ns = timer.nsecsElapsed();
+				if (r==0 || ns < alignNs) alignNs = ns;
+			}
+			if (!aligned) continue;
+			
+			out << lengths[l] << "\t" << name << "\t" << gcups(cells,scoreNs) << "\t" << gcups(cells,alignNs) << endl;
+			
+			if (levels[v] == 0){
+				refScore = s;
+				refA = alignedA;
+				refB = alignedB;
+			}
+			else if (s != refScore || alignedA != refA || alignedB != refB){
+				out << lengths[l] << "\t" << name << "\tdisagrees with the scalar result" << endl;
+				ok=false;
+			}
+		}
+	}
+	
+	PairwiseAligner::limitSimd(16);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+# Reports GCUPS for PairwiseAligner's scalar, SSE2 and AVX2 fills on fixed inputs.
+# Run makeinclude.py in the top directory first, then qmake && make && ./pairwise_bench
+# It's not a testcase, so make check doesn't run it.
+
+TARGET = pairwise_bench
+
+CONFIG += console
+
+MOC_DIR = moc
+
+OBJECTS_DIR = obj
+
+INCLUDEPATH += ../../include
+
+DEPENDPATH=$$INCLUDEPATH
+
+SOURCES				 =  BenchPairwise.cpp \
+									../../Core/PairwiseAligner.cpp \
+									../../Core/ScoringMatrix.cpp
+
+QT           += core
+QT           -= gui
@@ -0,0 +1,5 @@
+# qmake && make check, from here, builds and runs the tests (and builds the export_bench and pairwise_bench benchmarks)
+
+TEMPLATE = subdirs
+
+SUBDIRS = consensus export_bench pairwise_bench
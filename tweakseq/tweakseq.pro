@@ -6,26 +6,51 @@ INCLUDEPATH += include
 
 DEPENDPATH=$$INCLUDEPATH
 
-HEADERS       =  include/AboutDialog.h \
+HEADERS       =  include/A3MFile.h \
+								 include/AboutDialog.h \
+								 include/AlignmentBudgetDlg.h \
+								 include/AlignmentCache.h \
+								 include/AlignmentJob.h \
+								 include/AlignmentJobsPanel.h \
+								 include/AlignmentQueue.h \
 								 include/AlignmentTool.h \
 								 include/AlignmentToolDlg.h \
 								 include/AminoAcids.h \
 								 include/Application.h \
+								 include/BatchRunner.h \
+								 include/BufferedWriter.h \
+								 include/BuiltInAligner.h \
 								 include/Clipboard.h \
 								 include/ClustalFile.h \
 								 include/ClustalO.h \
+								 include/ClusterAligner.h \
+								 include/ColumnWindow.h \
+								 include/CompressedDevice.h \
+								 include/CostModel.h \
 								 include/DNA.h \
 								 include/DebuggingInfo.h \
+								 include/ExportJob.h \
 								 include/FASTAFile.h \
+								 include/FASTAIndex.h \
+								 include/FASTAStreamParser.h \
 								 include/GoToTool.h \
 								 include/ImportDialog.h \
+								 include/IndexedImportDialog.h \
 								 include/MAFFT.h \
+								 include/MappedAlignment.h \
+								 include/MessageLog.h \
 								 include/MessageWin.h \
 								 include/Muscle.h \
+								 include/PairwiseAligner.h \
 								 include/PDB.h \
 								 include/PDBFile.h \
+								 include/ProgressParser.h \
+								 include/ProgressiveAligner.h \
 								 include/Project.h \
 								 include/ResidueSelection.h \
+								 include/RunHistory.h \
+								 include/RunHistoryDialog.h \
+								 include/ScoringMatrix.h \
 								 include/SearchTool.h \
 								 include/SequenceEditor.h \
 								 include/SeqEditMainWin.h \
@@ -37,6 +62,7 @@ HEADERS       =  include/AboutDialog.h \
 								 include/SequencePropertiesDialog.h \
 								 include/SetupWizard.h \
 								 include/Structure.h \
+								 include/ToolProcess.h \
 								 include/Command.h \
 								 include/AddInsertionsCmd.h \
 								 include/AlignmentCmd.h \
@@ -46,6 +72,7 @@ HEADERS       =  include/AboutDialog.h \
 								 include/PasteCmd.h \
 								 include/ImportCmd.h \
 								 include/MoveCmd.h \
+								 include/RealignColumnsCmd.h \
 								 include/RenameCmd.h \
 								 include/UngroupCmd.h \
 								 include/Utility.h \
@@ -53,25 +80,45 @@ HEADERS       =  include/AboutDialog.h \
 								 include/XMLHelper.h \
 								 include/Consensus.h
 								 
-SOURCES				 =  Core/AlignmentTool.cpp \
+SOURCES				 =  Core/A3MFile.cpp \
+									Core/AlignmentCache.cpp \
+									Core/AlignmentJob.cpp \
+									Core/AlignmentQueue.cpp \
+									Core/AlignmentTool.cpp \
 									Core/Application.cpp \
+									Core/BatchRunner.cpp \
+									Core/BufferedWriter.cpp \
+									Core/BuiltInAligner.cpp \
 									Core/Clipboard.cpp \
 									Core/ClustalFile.cpp \
 									Core/ClustalO.cpp \
+									Core/ClusterAligner.cpp \
+									Core/CompressedDevice.cpp \
+									Core/CostModel.cpp \
+									Core/ExportJob.cpp \
 									Core/FASTAFile.cpp \
+									Core/FASTAIndex.cpp \
+									Core/FASTAStreamParser.cpp \
 									Core/Main.cpp \
 									Core/MAFFT.cpp \
+									Core/MappedAlignment.cpp \
 									Core/Muscle.cpp \
+									Core/PairwiseAligner.cpp \
 									Core/PDB.cpp \
 									Core/PDBFile.cpp \
+									Core/ProgressParser.cpp \
+									Core/ProgressiveAligner.cpp \
 									Core/Project.cpp \
 									Core/ResidueSelection.cpp \
+									Core/RunHistory.cpp \
+									Core/ScoringMatrix.cpp \
 									Core/Sequence.cpp \
 									Core/Sequences.cpp \
 									Core/SequenceFile.cpp\
 									Core/SequenceGroup.cpp\
 									Core/SequenceSelection.cpp \
 									Core/Structure.cpp \
+									Core/ToolProcess.cpp \
 									Core/Utility.cpp \
 									Core/XMLHelper.cpp
 									
@@ -85,12 +132,15 @@ SOURCES				+=  Core/UndoCommand/Command.cpp \
 									Core/UndoCommand/ImportCmd.cpp \
 									Core/UndoCommand/MoveCmd.cpp \
 									Core/UndoCommand/PasteCmd.cpp \
+									Core/UndoCommand/RealignColumnsCmd.cpp \
 									Core/UndoCommand/RenameCmd.cpp \
 									Core/UndoCommand/UngroupCmd.cpp
 
 SOURCES				+=  Core/Annotations/Consensus.cpp
 
-SOURCES       +=  UI/GoToTool.cpp \
+SOURCES       +=  UI/AlignmentJobsPanel.cpp \
+									UI/GoToTool.cpp \
+									UI/MessageLog.cpp \
 									UI/MessageWin.cpp \
 									UI/SearchTool.cpp \
 									UI/SequenceEditor.cpp \
@@ -98,14 +148,24 @@ SOURCES       +=  UI/GoToTool.cpp \
 									UI/SetupWizard.cpp
 									
 SOURCES				 += UI/Dialogs/AboutDialog.cpp \
+									UI/Dialogs/AlignmentBudgetDlg.cpp \
 									UI/Dialogs/AlignmentToolDlg.cpp \
 									UI/Dialogs/ImportDialog.cpp \
+									UI/Dialogs/IndexedImportDialog.cpp \
+									UI/Dialogs/RunHistoryDialog.cpp \
 									UI/Dialogs/SequencePropertiesDialog.cpp
 									
 RESOURCES = UI/Resources/application.qrc
 									
-QT           += core gui xml widgets printsupport
+QT           += core gui xml widgets printsupport concurrent
 
 #DEFINES      += QT_NO_DEBUG_OUTPUT 
 
 LIBS += -lz
+
+# zstd output (.zst) is optional
+CONFIG += link_pkgconfig
+packagesExist(libzstd){
+	PKGCONFIG += libzstd
+	DEFINES += HAVE_ZSTD
+}